@@ -1,12 +1,16 @@
 import { getDevice, updateDeviceStatus, autoRegisterDevice, updateDeviceUwbStatus } from '~/utils/deviceStorage';
-import { registerPeer, unregisterPeer, updateHeartbeat } from '~/utils/wsRuntime';
+import { canApplyHeartbeatDelta, getRuntimeByPeer, registerPeer, unregisterPeer, updateHeartbeat } from '~/utils/wsRuntime';
 import { updateDeviceRanges } from '~/utils/positioningRuntime';
+import { BINARY_HEARTBEAT_FORMAT, decodeBinaryHeartbeat, isBinaryHeartbeat } from '~/utils/binaryHeartbeat';
+import { recordCommandAck } from '~/utils/commandRuntime';
 
 interface IncomingBase { type: string; }
-interface RegisterMsg extends IncomingBase { type: 'register'; deviceId: string; }
+interface RegisterMsg extends IncomingBase { type: 'register'; deviceId: string; heartbeatFormat?: string; }
 interface HeartbeatMsg extends IncomingBase {
   type: 'heartbeat';
   deviceId?: string;
+  seq?: number;       // Есть только у JSON heartbeat с поддержкой разностей
+  keyframe?: boolean; // Полный снимок; без него в сообщении только изменившиеся поля
   servo1?: { angle: number };
   servo2?: { angle: number };
   uwb?: {
@@ -26,14 +30,30 @@ interface HeartbeatMsg extends IncomingBase {
     period?: number;
     localAddress?: number;
     peer0Address?: number;
-    ranges?: Array<{ peerId: string; distanceM: number; updatedAtMs?: number; rssiDbm?: number }>;
+    ranges?: Array<{ peerId: string; distanceM: number; filteredDistanceM?: number; updatedAtMs?: number; rssiDbm?: number }>;
   };
 }
 
-type IncomingMessage = RegisterMsg | HeartbeatMsg | any;
+// Поток расстояний между heartbeat, до 20 сообщений в секунду, без ack
+interface RangesMsg extends IncomingBase {
+  type: 'ranges';
+  ranges?: Array<{ peerId: string; distanceM: number; filteredDistanceM?: number; rssiDbm?: number }>;
+}
+
+// Подтверждение команды с seq; время по часам устройства, мкс
+interface CommandAckMsg extends IncomingBase {
+  type: 'command_ack';
+  seq: number;
+  status: string;
+  rxUs?: number;
+  acceptedUs?: number;
+}
+
+type IncomingMessage = RegisterMsg | HeartbeatMsg | RangesMsg | CommandAckMsg | any;
 const heartbeatLogAtByPeer = new Map<string, number>();
 
 function logIncoming(peerId: string, payload: IncomingMessage) {
+  if (payload.type === 'ranges' || payload.type === 'command_ack') return;
   if (payload.type !== 'heartbeat') {
     console.log(`[ws] incoming from ${peerId}:`, payload.type, payload);
     return;
@@ -57,18 +77,28 @@ export default defineWebSocketHandler({
   },
   async message(peer: any, message: any) {
     let payload: IncomingMessage;
-    try {
-      payload = JSON.parse(message.text());
-    } catch (e) {
-      console.log(`[ws] incoming from ${peer.id}: invalid_json`);
-      peer.send(JSON.stringify({ type: 'error', error: 'invalid_json' }));
-      return;
+    const bytes: Uint8Array = message.uint8Array();
+    if (isBinaryHeartbeat(bytes)) {
+      payload = decodeBinaryHeartbeat(bytes);
+      if (!payload) {
+        console.log(`[ws] incoming from ${peer.id}: invalid_binary`);
+        peer.send(JSON.stringify({ type: 'error', error: 'invalid_binary' }));
+        return;
+      }
+    } else {
+      try {
+        payload = JSON.parse(message.text());
+      } catch (e) {
+        console.log(`[ws] incoming from ${peer.id}: invalid_json`);
+        peer.send(JSON.stringify({ type: 'error', error: 'invalid_json' }));
+        return;
+      }
     }
 
     logIncoming(peer.id, payload);
 
     if (payload.type === 'register') {
-      const { deviceId } = payload as RegisterMsg;
+      const { deviceId, heartbeatFormat } = payload as RegisterMsg;
       
       // Пытаемся получить устройство или автоматически регистрируем
       let dev = await getDevice(deviceId);
@@ -81,27 +111,59 @@ export default defineWebSocketHandler({
       
       registerPeer(deviceId, peer);
       await updateDeviceStatus(deviceId, 'connected');
-      peer.send(JSON.stringify({ type: 'ack', action: 'register', deviceId }));
+      // Подтверждаем бинарный heartbeat, только если устройство его предложило
+      peer.send(JSON.stringify({
+        type: 'ack',
+        action: 'register',
+        deviceId,
+        ...(heartbeatFormat === BINARY_HEARTBEAT_FORMAT ? { heartbeatFormat: BINARY_HEARTBEAT_FORMAT } : {}),
+      }));
       console.log(`[ws] device ${deviceId} registered successfully`);
       return;
     }
 
     if (payload.type === 'heartbeat') {
-      let rt = updateHeartbeat(peer.id, payload.servo1?.angle, payload.servo2?.angle, payload.uwb);
+      const seq = typeof payload.seq === 'number' ? payload.seq : undefined;
+      // Heartbeat без seq (bin1, старые прошивки) всегда полный
+      const keyframe = seq === undefined || payload.keyframe === true;
+      if (!keyframe && !canApplyHeartbeatDelta(peer.id)) {
+        // Опорного снимка нет (перезапуск бэкенда, новая сессия) — просим полный
+        peer.send(JSON.stringify({ type: 'ack', action: 'heartbeat', seq, resync: true }));
+        return;
+      }
+
+      let rt = updateHeartbeat(peer.id, payload.servo1?.angle, payload.servo2?.angle, payload.uwb, keyframe);
       if (!rt?.deviceId && typeof payload.deviceId === 'string' && payload.deviceId.length > 0) {
         if (!(await getDevice(payload.deviceId))) {
           const clientIP = peer.request?.socket?.remoteAddress || 'unknown';
           await autoRegisterDevice(payload.deviceId, clientIP);
         }
         registerPeer(payload.deviceId, peer);
-        rt = updateHeartbeat(peer.id, payload.servo1?.angle, payload.servo2?.angle, payload.uwb);
+        rt = updateHeartbeat(peer.id, payload.servo1?.angle, payload.servo2?.angle, payload.uwb, keyframe);
       }
       if (rt?.deviceId) {
         await updateDeviceStatus(rt.deviceId, 'connected');
         await updateDeviceUwbStatus(rt.deviceId, payload.uwb?.ready, payload.uwb?.rangeCount, payload.uwb);
         updateDeviceRanges(rt.deviceId, payload.uwb?.ranges);
       }
-      peer.send(JSON.stringify({ type: 'ack', action: 'heartbeat' }));
+      peer.send(JSON.stringify({ type: 'ack', action: 'heartbeat', ...(seq !== undefined ? { seq } : {}) }));
+      return;
+    }
+
+    if (payload.type === 'ranges') {
+      // Без регистрации не знаем, чьи это расстояния; heartbeat восстановит сессию
+      const rt = getRuntimeByPeer(peer.id);
+      if (rt) updateDeviceRanges(rt.deviceId, (payload as RangesMsg).ranges);
+      return;
+    }
+
+    if (payload.type === 'command_ack') {
+      const rt = getRuntimeByPeer(peer.id);
+      const ack = rt ? recordCommandAck(rt.deviceId, payload as CommandAckMsg) : null;
+      if (ack && ack.status !== 'ok') {
+        const outcome = ack.status === 'failed' ? 'failed to execute' : 'rejected';
+        console.log(`[ws] device ${rt!.deviceId} ${outcome} ${ack.type} #${ack.seq}: ${ack.status}`);
+      }
       return;
     }
 
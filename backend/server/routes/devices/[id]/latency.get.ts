@@ -0,0 +1,22 @@
+import { requireUserId } from '~/lib/currentUser';
+import { getUserDevice } from '~/utils/deviceStorage';
+import { getCommandLatency } from '~/utils/commandRuntime';
+
+// Гистограммы задержки команд send → receive → accepted по command_ack устройства
+export default defineEventHandler(async (event) => {
+  const userId = requireUserId(event);
+  const id = getRouterParam(event, 'id');
+  const device = await getUserDevice(userId, id!);
+
+  if (!device) {
+    throw createError({
+      statusCode: 404,
+      statusMessage: 'Device not found'
+    });
+  }
+
+  return {
+    deviceId: device.id,
+    commands: getCommandLatency(device.id),
+  };
+});
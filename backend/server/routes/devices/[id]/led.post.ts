@@ -1,8 +1,21 @@
 import { requireUserId } from '~/lib/currentUser';
 import { getUserDevice } from '~/utils/deviceStorage';
-import { sendToDevice } from '~/utils/wsRuntime';
+import { sendConfirmed } from '~/utils/wsRuntime';
 import { updateDeviceLed } from '~/utils/deviceStorage';
 
+const LED_EFFECTS = ['none', 'fade', 'breathe', 'chase', 'color_temp', 'gradient'];
+
+function isRgbTriple(value: unknown): value is [number, number, number] {
+  return Array.isArray(value) && value.length === 3 &&
+    value.every((c) => typeof c === 'number' && c >= 0 && c <= 255);
+}
+
+function isZone(value: unknown) {
+  return Array.isArray(value) && value.length === 4 &&
+    typeof value[0] === 'number' && typeof value[1] === 'number' && value[0] >= 0 && value[1] >= value[0] &&
+    isRgbTriple(value[2]) && isRgbTriple(value[3]);
+}
+
 export default defineEventHandler(async (event) => {
   const userId = requireUserId(event);
   const deviceId = getRouterParam(event, 'id');
@@ -56,6 +69,34 @@ export default defineEventHandler(async (event) => {
       command = { type: body.type, brightness: body.brightness };
       break;
 
+    case 'set_led_effect':
+      // Анимацию рисует устройство; сюда приходит только описание эффекта
+      if (!LED_EFFECTS.includes(body.effect)) {
+        throw createError({
+          statusCode: 400,
+          statusMessage: `Invalid effect. Must be one of: ${LED_EFFECTS.join(', ')}`
+        });
+      }
+      for (const key of ['color', 'from'] as const) {
+        if (body[key] !== undefined && !isRgbTriple(body[key])) {
+          throw createError({
+            statusCode: 400,
+            statusMessage: `Invalid ${key}. Must be [r, g, b] with values 0-255`
+          });
+        }
+      }
+      if (body.zones !== undefined && (!Array.isArray(body.zones) || body.zones.length > 4 || !body.zones.every(isZone))) {
+        throw createError({
+          statusCode: 400,
+          statusMessage: 'Invalid zones. Up to 4 entries of [first, last, [r, g, b], [r, g, b]]'
+        });
+      }
+      command = { type: body.type, effect: body.effect };
+      for (const key of ['color', 'from', 'zones', 'durationMs', 'periodMs', 'minLevel', 'width', 'kelvinFrom', 'kelvinTo']) {
+        if (body[key] !== undefined) command[key] = body[key];
+      }
+      break;
+
     case 'clear_leds':
       // Эта команда не требует дополнительных параметров
       break;
@@ -67,16 +108,26 @@ export default defineEventHandler(async (event) => {
       });
   }
 
-  // Отправляем команду на устройство
-  const success = sendToDevice(deviceId, command);
+  // Отправляем команду на устройство и ждём подтверждения
+  const result = await sendConfirmed(deviceId, command);
   
-  if (!success) {
+  if (!result.sent) {
     throw createError({
       statusCode: 503,
       statusMessage: 'Device is not connected'
     });
   }
 
+  // failed — команда принята, но контроллер лент её не выполнил
+  if (result.confirmed && result.status !== 'ok') {
+    const failed = result.status === 'failed';
+    throw createError({
+      statusCode: failed ? 502 : 422,
+      statusMessage: `Device ${failed ? 'failed to execute' : 'rejected'} LED command ${body.type}`,
+      data: { status: result.status }
+    });
+  }
+
   // Обновляем локальное состояние
   switch (body.type) {
     case 'set_led_color':
@@ -89,7 +140,11 @@ export default defineEventHandler(async (event) => {
 
   return {
     success: true,
-    message: `LED command ${body.type} sent successfully`,
-    deviceId
+    message: result.confirmed
+      ? `LED command ${body.type} accepted`
+      : `LED command ${body.type} sent, no confirmation from device`,
+    deviceId,
+    confirmed: result.confirmed,
+    latencyMs: result.ack?.sendToAcceptedMs
   };
 });
@@ -1,6 +1,6 @@
 import { requireUserId } from '~/lib/currentUser';
 import { getUserDevice } from '~/utils/deviceStorage';
-import { sendServoCommand } from '~/utils/wsRuntime';
+import { sendConfirmed, servoCommand } from '~/utils/wsRuntime';
 
 export default defineEventHandler(async (event) => {
   const userId = requireUserId(event);
@@ -31,9 +31,18 @@ export default defineEventHandler(async (event) => {
   }
 
   // Сначала пытаемся через WebSocket
-  const wsSent = sendServoCommand(device.id, servo, angle);
-  if (wsSent) {
-    return { success: true, transport: 'websocket' };
+  const ws = await sendConfirmed(device.id, servoCommand(servo, angle));
+  // failed — команда принята, но контроллер сервоприводов её не выполнил
+  if (ws.confirmed && ws.status !== 'ok') {
+    const failed = ws.status === 'failed';
+    throw createError({
+      statusCode: failed ? 502 : 422,
+      statusMessage: failed ? 'Device failed to execute servo command' : 'Device rejected servo command',
+      data: { status: ws.status }
+    });
+  }
+  if (ws.sent) {
+    return { success: true, transport: 'websocket', confirmed: ws.confirmed, latencyMs: ws.ack?.sendToAcceptedMs };
   }
 
   // Fallback HTTP
@@ -1,6 +1,6 @@
 import { requireUserId } from '~/lib/currentUser';
 import { getUserDevice } from '~/utils/deviceStorage';
-import { sendServoCommand } from '~/utils/wsRuntime';
+import { sendConfirmed, servoCommand } from '~/utils/wsRuntime';
 import { updateDeviceAngles } from '~/utils/deviceStorage';
 
 interface ServoRequest {
@@ -37,10 +37,19 @@ export default defineEventHandler(async (event) => {
   }
 
   // Сначала пытаемся через WebSocket
-  const wsSent = sendServoCommand(device.id, body.servo, body.angle);
-  if (wsSent) {
+  const ws = await sendConfirmed(device.id, servoCommand(body.servo, body.angle));
+  // failed — команда принята, но контроллер сервоприводов её не выполнил
+  if (ws.confirmed && ws.status !== 'ok') {
+    const failed = ws.status === 'failed';
+    throw createError({
+      statusCode: failed ? 502 : 422,
+      statusMessage: failed ? 'Device failed to execute servo command' : 'Device rejected servo command',
+      data: { status: ws.status }
+    });
+  }
+  if (ws.sent) {
     await updateDeviceAngles(device.id, body.servo === 1 ? body.angle : undefined, body.servo === 2 ? body.angle : undefined);
-    return { success: true, transport: 'websocket' };
+    return { success: true, transport: 'websocket', confirmed: ws.confirmed, latencyMs: ws.ack?.sendToAcceptedMs };
   }
 
   // Fallback HTTP
@@ -0,0 +1,113 @@
+import { formatUwbPeerId } from '~/utils/positioningRuntime';
+
+// Формат описан в firmware/components/websocket_client/include/heartbeat_bin.h
+export const BINARY_HEARTBEAT_FORMAT = 'bin1';
+const MAGIC = 0xb1;
+const VERSION = 1;
+const HEADER_SIZE = 44;
+const FLAG_UWB_READY = 0x01;
+const FLAG_AUTO_CONFIG = 0x02;
+const RANGE_FLAG_NAMED = 0x01;
+const RANGE_SIZE = 16;
+
+export interface DecodedHeartbeat {
+  type: 'heartbeat';
+  servo1: { angle: number };
+  servo2: { angle: number };
+  uwb: {
+    ready: boolean;
+    rangeCount: number;
+    uartBytes: number;
+    discardedBytes: number;
+    parsedFrames: number;
+    invalidFrames: number;
+    parsedLines: number;
+    invalidLines: number;
+    lastByteAtMs: number;
+    lastRxHex: string;
+    autoConfig: boolean;
+    role: number;
+    pid: number;
+    period: number;
+    localAddress: number;
+    peer0Address: number;
+    ranges: Array<{ peerId: string; distanceM: number; filteredDistanceM: number; updatedAtMs: number; rssiDbm: number }>;
+  };
+}
+
+export function isBinaryHeartbeat(bytes: Uint8Array) {
+  return bytes.length >= 2 && bytes[0] === MAGIC;
+}
+
+export function decodeBinaryHeartbeat(bytes: Uint8Array): DecodedHeartbeat | null {
+  if (bytes.length < HEADER_SIZE || bytes[0] !== MAGIC || bytes[1] !== VERSION) {
+    return null;
+  }
+
+  const view = new DataView(bytes.buffer, bytes.byteOffset, bytes.byteLength);
+  const flags = view.getUint8(2);
+  const rangeCount = view.getUint8(3);
+  const lastRxLength = view.getUint8(39);
+  let offset = HEADER_SIZE;
+
+  if (offset + lastRxLength > bytes.length) {
+    return null;
+  }
+  const lastRxHex = Array.from(bytes.subarray(offset, offset + lastRxLength))
+    .map(byte => byte.toString(16).padStart(2, '0').toUpperCase())
+    .join(' ');
+  offset += lastRxLength;
+
+  const ranges: DecodedHeartbeat['uwb']['ranges'] = [];
+  for (let i = 0; i < rangeCount; i++) {
+    if (offset + 3 > bytes.length) return null;
+    const rangeFlags = view.getUint8(offset);
+    const address = view.getUint16(offset + 1, true);
+    offset += 3;
+
+    let peerId = formatUwbPeerId(address);
+    if (rangeFlags & RANGE_FLAG_NAMED) {
+      if (offset + 1 > bytes.length) return null;
+      const nameLength = view.getUint8(offset);
+      offset += 1;
+      if (offset + nameLength > bytes.length) return null;
+      peerId = new TextDecoder().decode(bytes.subarray(offset, offset + nameLength));
+      offset += nameLength;
+    }
+
+    if (offset + RANGE_SIZE - 3 > bytes.length) return null;
+    ranges.push({
+      peerId,
+      distanceM: view.getUint32(offset, true) / 1000,
+      filteredDistanceM: view.getUint32(offset + 4, true) / 1000,
+      rssiDbm: view.getInt8(offset + 8),
+      updatedAtMs: view.getUint32(offset + 9, true),
+    });
+    offset += RANGE_SIZE - 3;
+  }
+
+  return {
+    type: 'heartbeat',
+    servo1: { angle: view.getInt16(4, true) },
+    servo2: { angle: view.getInt16(6, true) },
+    uwb: {
+      ready: (flags & FLAG_UWB_READY) !== 0,
+      rangeCount,
+      uartBytes: view.getUint32(8, true),
+      discardedBytes: view.getUint32(12, true),
+      parsedFrames: view.getUint32(16, true),
+      invalidFrames: view.getUint32(20, true),
+      parsedLines: view.getUint32(24, true),
+      invalidLines: view.getUint32(28, true),
+      lastByteAtMs: view.getUint32(32, true),
+      lastRxHex,
+      autoConfig: (flags & FLAG_AUTO_CONFIG) !== 0,
+      role: view.getUint8(36),
+      pid: view.getUint8(37),
+      period: view.getUint8(38),
+      localAddress: view.getUint16(40, true),
+      peer0Address: view.getUint16(42, true),
+      ranges,
+    },
+  };
+}
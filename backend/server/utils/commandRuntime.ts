@@ -0,0 +1,226 @@
+// Подтверждения команд устройств и задержка пути send → receive → accepted.
+//
+// Каждой команде присваивается номер seq, устройство отвечает command_ack
+// с временем прихода и приёма по своим часам (esp_timer, мкс). Принята —
+// значит разобрана и передана контроллеру сервоприводов или лент; физически
+// изменение наступает позже, на ближайшем кадре их заданий. Часы не
+// синхронизированы, поэтому время на устройстве (accepted − rx) берётся из
+// ack, а сетевая часть оценивается как половина остатка времени ответа.
+// Статус "failed" — команда разобрана, но контроллер отказался её выполнить;
+// остальные статусы кроме "ok" — отказ разбора.
+
+export const COMMAND_ACK_TIMEOUT_MS = 1500;
+export const LATENCY_BUCKETS_MS = [1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 2000];
+const MAX_PENDING_COMMANDS = 64;
+
+export interface CommandAck {
+  seq: number;
+  type: string;
+  status: string;
+  roundTripMs: number;
+  sendToReceiveMs: number;    // Оценка: (roundTrip − на устройстве) / 2
+  receiveToAcceptedMs: number; // Измерено устройством
+  sendToAcceptedMs: number;
+}
+
+interface CommandAckMsg {
+  seq?: number;
+  status?: string;
+  rxUs?: number;
+  acceptedUs?: number;
+}
+
+interface PendingCommand {
+  type: string;
+  sentAt: number;
+  resolve?: (ack: CommandAck | null) => void;
+  timer?: ReturnType<typeof setTimeout>;
+}
+
+interface Histogram {
+  counts: number[]; // По LATENCY_BUCKETS_MS, последний — больше 2000 мс
+  count: number;
+  sumMs: number;
+  minMs: number;
+  maxMs: number;
+}
+
+interface DeviceCommands {
+  nextSeq: number;
+  pending: Map<number, PendingCommand>;
+  sent: number;
+  acked: number;
+  rejected: number;
+  failed: number;
+  timedOut: number;
+  lastAck?: CommandAck;
+  sendToReceive: Histogram;
+  receiveToAccepted: Histogram;
+  sendToAccepted: Histogram;
+  roundTrip: Histogram;
+}
+
+// Переживает переподключения устройства, ключ — deviceId
+const devices: Map<string, DeviceCommands> = new Map();
+
+function createHistogram(): Histogram {
+  return { counts: new Array(LATENCY_BUCKETS_MS.length + 1).fill(0), count: 0, sumMs: 0, minMs: Infinity, maxMs: 0 };
+}
+
+function recordLatency(histogram: Histogram, ms: number) {
+  let bucket = LATENCY_BUCKETS_MS.findIndex(limit => ms <= limit);
+  if (bucket < 0) bucket = LATENCY_BUCKETS_MS.length;
+  histogram.counts[bucket]++;
+  histogram.count++;
+  histogram.sumMs += ms;
+  histogram.minMs = Math.min(histogram.minMs, ms);
+  histogram.maxMs = Math.max(histogram.maxMs, ms);
+}
+
+// Перцентиль — верхняя граница корзины, в которую он попал
+function percentile(histogram: Histogram, q: number) {
+  if (histogram.count === 0) return null;
+  const rank = Math.ceil(histogram.count * q);
+  let seen = 0;
+  for (let i = 0; i < histogram.counts.length; i++) {
+    seen += histogram.counts[i];
+    if (seen >= rank) return i < LATENCY_BUCKETS_MS.length ? Math.min(LATENCY_BUCKETS_MS[i], histogram.maxMs) : histogram.maxMs;
+  }
+  return histogram.maxMs;
+}
+
+function summarize(histogram: Histogram) {
+  const round = (ms: number | null) => (ms === null ? null : Math.round(ms * 100) / 100);
+  const empty = histogram.count === 0;
+  return {
+    count: histogram.count,
+    counts: histogram.counts,
+    avgMs: empty ? null : round(histogram.sumMs / histogram.count),
+    minMs: empty ? null : round(histogram.minMs),
+    maxMs: empty ? null : round(histogram.maxMs),
+    p50Ms: round(percentile(histogram, 0.5)),
+    p95Ms: round(percentile(histogram, 0.95)),
+    p99Ms: round(percentile(histogram, 0.99)),
+  };
+}
+
+function deviceCommands(deviceId: string) {
+  let state = devices.get(deviceId);
+  if (!state) {
+    state = {
+      nextSeq: 1,
+      pending: new Map(),
+      sent: 0,
+      acked: 0,
+      rejected: 0,
+      failed: 0,
+      timedOut: 0,
+      sendToReceive: createHistogram(),
+      receiveToAccepted: createHistogram(),
+      sendToAccepted: createHistogram(),
+      roundTrip: createHistogram(),
+    };
+    devices.set(deviceId, state);
+  }
+  return state;
+}
+
+function settle(state: DeviceCommands, seq: number, ack: CommandAck | null) {
+  const command = state.pending.get(seq);
+  if (!command) return;
+  state.pending.delete(seq);
+  if (command.timer) clearTimeout(command.timer);
+  if (!ack) state.timedOut++;
+  command.resolve?.(ack);
+}
+
+// Команды без ожидающего (и без ack от старых прошивок) вычищаются здесь
+function expirePending(state: DeviceCommands, now: number) {
+  for (const [seq, command] of state.pending) {
+    if (!command.resolve && now - command.sentAt > COMMAND_ACK_TIMEOUT_MS) settle(state, seq, null);
+  }
+  while (state.pending.size >= MAX_PENDING_COMMANDS) {
+    const oldest = state.pending.keys().next().value as number;
+    settle(state, oldest, null);
+  }
+}
+
+// Номер для новой команды; время отправки — момент вызова
+export function trackCommand(deviceId: string, type: string) {
+  const state = deviceCommands(deviceId);
+  const now = performance.now();
+  expirePending(state, now);
+
+  const seq = state.nextSeq;
+  state.nextSeq = state.nextSeq >= 0xffffffff ? 1 : state.nextSeq + 1;
+  state.pending.set(seq, { type, sentAt: now });
+  state.sent++;
+  return seq;
+}
+
+// null — ack не пришёл за timeoutMs (устройство отключилось или прошивка без ack)
+export function waitForAck(deviceId: string, seq: number, timeoutMs = COMMAND_ACK_TIMEOUT_MS): Promise<CommandAck | null> {
+  const command = devices.get(deviceId)?.pending.get(seq);
+  if (!command) return Promise.resolve(null);
+  return new Promise(resolve => {
+    command.resolve = resolve;
+    command.timer = setTimeout(() => settle(deviceCommands(deviceId), seq, null), timeoutMs);
+  });
+}
+
+export function recordCommandAck(deviceId: string, msg: CommandAckMsg) {
+  const state = devices.get(deviceId);
+  if (!state || typeof msg.seq !== 'number') return null;
+  const command = state.pending.get(msg.seq);
+  if (!command) return null; // Опоздавший ack: команда уже учтена как потерянная
+
+  const roundTripMs = performance.now() - command.sentAt;
+  const deviceMs = typeof msg.rxUs === 'number' && typeof msg.acceptedUs === 'number'
+    ? Math.min(roundTripMs, Math.max(0, (msg.acceptedUs - msg.rxUs) / 1000))
+    : 0;
+  const sendToReceiveMs = (roundTripMs - deviceMs) / 2;
+  const ack: CommandAck = {
+    seq: msg.seq,
+    type: command.type,
+    status: typeof msg.status === 'string' ? msg.status : 'ok',
+    roundTripMs,
+    sendToReceiveMs,
+    receiveToAcceptedMs: deviceMs,
+    sendToAcceptedMs: sendToReceiveMs + deviceMs,
+  };
+
+  if (ack.status === 'ok') {
+    state.acked++;
+    recordLatency(state.sendToReceive, ack.sendToReceiveMs);
+    recordLatency(state.receiveToAccepted, ack.receiveToAcceptedMs);
+    recordLatency(state.sendToAccepted, ack.sendToAcceptedMs);
+    recordLatency(state.roundTrip, ack.roundTripMs);
+  } else if (ack.status === 'failed') {
+    state.failed++;
+  } else {
+    state.rejected++;
+  }
+  state.lastAck = ack;
+  settle(state, msg.seq, ack);
+  return ack;
+}
+
+export function getCommandLatency(deviceId: string) {
+  const state = devices.get(deviceId);
+  if (!state) return null;
+  expirePending(state, performance.now());
+  return {
+    sent: state.sent,
+    acked: state.acked,
+    rejected: state.rejected,
+    failed: state.failed,
+    timedOut: state.timedOut,
+    pending: state.pending.size,
+    lastAck: state.lastAck ?? null,
+    bucketsMs: LATENCY_BUCKETS_MS,
+    sendToReceive: summarize(state.sendToReceive),
+    receiveToAccepted: summarize(state.receiveToAccepted),
+    sendToAccepted: summarize(state.sendToAccepted),
+    roundTrip: summarize(state.roundTrip),
+  };
+}
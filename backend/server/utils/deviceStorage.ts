@@ -328,55 +328,66 @@ export async function updateDeviceLed(
   }).catch(() => undefined);
 }
 
+type UwbStatusField =
+  | 'uwbReady' | 'uwbRangeCount' | 'uwbUartBytes' | 'uwbDiscardedBytes' | 'uwbParsedFrames'
+  | 'uwbInvalidFrames' | 'uwbParsedLines' | 'uwbInvalidLines' | 'uwbLastByteAtMs' | 'uwbLastRxHex'
+  | 'uwbAutoConfig' | 'uwbRole' | 'uwbPid' | 'uwbPeriod' | 'uwbLocalAddress' | 'uwbPeer0Address';
+
+function numberOrUndefined(value: unknown) {
+  return typeof value === 'number' ? value : undefined;
+}
+
+function booleanOrUndefined(value: unknown) {
+  return typeof value === 'boolean' ? value : undefined;
+}
+
 export async function updateDeviceUwbStatus(
   id: string,
   ready?: boolean,
   rangeCount?: number,
   diagnostics?: UwbDiagnostics,
 ) {
+  const values: Record<UwbStatusField, number | string | boolean | undefined> = {
+    uwbReady: booleanOrUndefined(ready),
+    uwbRangeCount: numberOrUndefined(rangeCount),
+    uwbUartBytes: numberOrUndefined(diagnostics?.uartBytes),
+    uwbDiscardedBytes: numberOrUndefined(diagnostics?.discardedBytes),
+    uwbParsedFrames: numberOrUndefined(diagnostics?.parsedFrames),
+    uwbInvalidFrames: numberOrUndefined(diagnostics?.invalidFrames),
+    uwbParsedLines: numberOrUndefined(diagnostics?.parsedLines),
+    uwbInvalidLines: numberOrUndefined(diagnostics?.invalidLines),
+    uwbLastByteAtMs: numberOrUndefined(diagnostics?.lastByteAtMs),
+    uwbLastRxHex: typeof diagnostics?.lastRxHex === 'string' ? diagnostics.lastRxHex : undefined,
+    uwbAutoConfig: booleanOrUndefined(diagnostics?.autoConfig),
+    uwbRole: numberOrUndefined(diagnostics?.role),
+    uwbPid: numberOrUndefined(diagnostics?.pid),
+    uwbPeriod: numberOrUndefined(diagnostics?.period),
+    uwbLocalAddress: numberOrUndefined(diagnostics?.localAddress),
+    uwbPeer0Address: numberOrUndefined(diagnostics?.peer0Address),
+  };
+
+  // Heartbeat приходит раз в секунду, а большинство полей не меняется:
+  // в БД пишем только отличающиеся от runtime-копии значения.
+  // lastHeartbeat в БД обновляет updateDeviceStatus.
   const runtime = runtimeDevices.get(id);
+  const data: Partial<Record<UwbStatusField, number | string | boolean>> = {};
+  for (const field of Object.keys(values) as UwbStatusField[]) {
+    const value = values[field];
+    if (value === undefined || (runtime && runtime[field] === value)) continue;
+    data[field] = value;
+  }
+
   if (runtime) {
-    if (typeof ready === 'boolean') runtime.uwbReady = ready;
-    if (typeof rangeCount === 'number') runtime.uwbRangeCount = rangeCount;
-    if (typeof diagnostics?.uartBytes === 'number') runtime.uwbUartBytes = diagnostics.uartBytes;
-    if (typeof diagnostics?.discardedBytes === 'number') runtime.uwbDiscardedBytes = diagnostics.discardedBytes;
-    if (typeof diagnostics?.parsedFrames === 'number') runtime.uwbParsedFrames = diagnostics.parsedFrames;
-    if (typeof diagnostics?.invalidFrames === 'number') runtime.uwbInvalidFrames = diagnostics.invalidFrames;
-    if (typeof diagnostics?.parsedLines === 'number') runtime.uwbParsedLines = diagnostics.parsedLines;
-    if (typeof diagnostics?.invalidLines === 'number') runtime.uwbInvalidLines = diagnostics.invalidLines;
-    if (typeof diagnostics?.lastByteAtMs === 'number') runtime.uwbLastByteAtMs = diagnostics.lastByteAtMs;
-    if (typeof diagnostics?.lastRxHex === 'string') runtime.uwbLastRxHex = diagnostics.lastRxHex;
-    if (typeof diagnostics?.autoConfig === 'boolean') runtime.uwbAutoConfig = diagnostics.autoConfig;
-    if (typeof diagnostics?.role === 'number') runtime.uwbRole = diagnostics.role;
-    if (typeof diagnostics?.pid === 'number') runtime.uwbPid = diagnostics.pid;
-    if (typeof diagnostics?.period === 'number') runtime.uwbPeriod = diagnostics.period;
-    if (typeof diagnostics?.localAddress === 'number') runtime.uwbLocalAddress = diagnostics.localAddress;
-    if (typeof diagnostics?.peer0Address === 'number') runtime.uwbPeer0Address = diagnostics.peer0Address;
+    Object.assign(runtime, data);
     runtime.lastHeartbeat = new Date().toISOString();
     runtimeDevices.set(id, runtime);
   }
 
+  if (Object.keys(data).length === 0) return;
+
   await prisma.device.update({
     where: { id },
-    data: {
-      ...(typeof ready === 'boolean' ? { uwbReady: ready } : {}),
-      ...(typeof rangeCount === 'number' ? { uwbRangeCount: rangeCount } : {}),
-      ...(typeof diagnostics?.uartBytes === 'number' ? { uwbUartBytes: diagnostics.uartBytes } : {}),
-      ...(typeof diagnostics?.discardedBytes === 'number' ? { uwbDiscardedBytes: diagnostics.discardedBytes } : {}),
-      ...(typeof diagnostics?.parsedFrames === 'number' ? { uwbParsedFrames: diagnostics.parsedFrames } : {}),
-      ...(typeof diagnostics?.invalidFrames === 'number' ? { uwbInvalidFrames: diagnostics.invalidFrames } : {}),
-      ...(typeof diagnostics?.parsedLines === 'number' ? { uwbParsedLines: diagnostics.parsedLines } : {}),
-      ...(typeof diagnostics?.invalidLines === 'number' ? { uwbInvalidLines: diagnostics.invalidLines } : {}),
-      ...(typeof diagnostics?.lastByteAtMs === 'number' ? { uwbLastByteAtMs: diagnostics.lastByteAtMs } : {}),
-      ...(typeof diagnostics?.lastRxHex === 'string' ? { uwbLastRxHex: diagnostics.lastRxHex } : {}),
-      ...(typeof diagnostics?.autoConfig === 'boolean' ? { uwbAutoConfig: diagnostics.autoConfig } : {}),
-      ...(typeof diagnostics?.role === 'number' ? { uwbRole: diagnostics.role } : {}),
-      ...(typeof diagnostics?.pid === 'number' ? { uwbPid: diagnostics.pid } : {}),
-      ...(typeof diagnostics?.period === 'number' ? { uwbPeriod: diagnostics.period } : {}),
-      ...(typeof diagnostics?.localAddress === 'number' ? { uwbLocalAddress: diagnostics.localAddress } : {}),
-      ...(typeof diagnostics?.peer0Address === 'number' ? { uwbPeer0Address: diagnostics.peer0Address } : {}),
-      lastHeartbeat: new Date(),
-    },
+    data,
   }).catch(() => undefined);
 }
 
@@ -1,6 +1,8 @@
 export interface UwbRangeInput {
   peerId: string;
   distanceM: number;
+  // Уже сглаженное на устройстве значение (uwb_range_filter)
+  filteredDistanceM?: number;
   updatedAtMs?: number;
   rssiDbm?: number;
 }
@@ -70,7 +72,7 @@ function normalizePair(fromDeviceId: string, toDeviceId: string) {
   return [fromDeviceId, toDeviceId].sort().join('::');
 }
 
-function formatUwbPeerId(address: number) {
+export function formatUwbPeerId(address: number) {
   return `uwb_${address.toString(16).padStart(4, '0').toUpperCase()}`;
 }
 
@@ -203,7 +205,13 @@ export function updateDeviceRanges(
     }
 
     const key = normalizePair(fromDeviceId, range.peerId);
-    const filteredDistanceM = smoothDistance(key, range.distanceM);
+    const edgeFiltered = typeof range.filteredDistanceM === 'number'
+      && Number.isFinite(range.filteredDistanceM)
+      && range.filteredDistanceM >= 0
+      && range.filteredDistanceM <= 100;
+    const filteredDistanceM = edgeFiltered
+      ? range.filteredDistanceM as number
+      : smoothDistance(key, range.distanceM);
     distances.set(key, {
       fromDeviceId,
       toDeviceId: range.peerId,
@@ -7,7 +7,7 @@ import {
   updateDeviceLed,
 } from './deviceStorage';
 import { getPositioningSummary } from './positioningRuntime';
-import { onlineDevices, sendServoCommand, sendToDevice } from './wsRuntime';
+import { batchCommand, onlineDevices, poseCommand, sendConfirmed } from './wsRuntime';
 
 export interface RoomZone {
   id: string;
@@ -390,21 +390,17 @@ export async function applyScene(userId: string, sceneId: string) {
     throw new Error(`Scene ${sceneId} not found`);
   }
 
-  const results = [];
+  const pending = [];
   for (const deviceState of scene.devices) {
     const brightness = normalizeBrightness(deviceState.brightness);
-    const ledColorSent = sendToDevice(deviceState.deviceId, {
-      type: 'set_led_color',
-      r: deviceState.colorR,
-      g: deviceState.colorG,
-      b: deviceState.colorB,
-    });
-    const ledBrightnessSent = sendToDevice(deviceState.deviceId, {
-      type: 'set_led_brightness',
-      brightness,
-    });
-    const servo1Sent = sendServoCommand(deviceState.deviceId, 1, deviceState.servo1Angle);
-    const servo2Sent = sendServoCommand(deviceState.deviceId, 2, deviceState.servo2Angle);
+    // Одно сообщение на устройство: цвет, яркость и обе оси меняются одновременно.
+    // Подтверждения всех устройств ждём вместе, после записи состояния
+    const result = sendConfirmed(deviceState.deviceId, batchCommand([
+      { type: 'set_led_color', r: deviceState.colorR, g: deviceState.colorG, b: deviceState.colorB },
+      { type: 'set_led_brightness', brightness },
+      { type: 'set_servo', id: 1, angle: deviceState.servo1Angle },
+      { type: 'set_servo', id: 2, angle: deviceState.servo2Angle },
+    ]));
 
     await updateDeviceLed(
       deviceState.deviceId,
@@ -418,16 +414,16 @@ export async function applyScene(userId: string, sceneId: string) {
       await assignDeviceZoneInStorage(userId, deviceState.deviceId, deviceState.zoneId);
     }
 
-    results.push({
+    pending.push(result.then(({ sent, confirmed, status, ack }) => ({
       deviceId: deviceState.deviceId,
-      ledColorSent,
-      ledBrightnessSent,
-      servo1Sent,
-      servo2Sent,
-    });
+      sent,
+      confirmed,
+      status,
+      latencyMs: ack?.sendToAcceptedMs,
+    })));
   }
 
-  return { sceneId, results };
+  return { sceneId, results: await Promise.all(pending) };
 }
 
 async function fallbackPose(userId: string, deviceId: string) {
@@ -486,17 +482,20 @@ export async function aimDeviceAtTarget(
   const servo1Angle = clampServo(90 + bearingDeg / 2);
   const servo2Angle = clampServo(90 - elevationDeg);
 
-  const servo1Sent = sendServoCommand(sourceDeviceId, 1, servo1Angle);
-  const servo2Sent = sendServoCommand(sourceDeviceId, 2, servo2Angle);
+  // servo1 — азимут (pan), servo2 — наклон (tilt)
+  const pose = sendConfirmed(sourceDeviceId, poseCommand(servo1Angle, servo2Angle));
   await updateDeviceAngles(sourceDeviceId, servo1Angle, servo2Angle);
+  const { sent: poseSent, confirmed: poseConfirmed, status: poseStatus, ack } = await pose;
 
   return {
     sourceDeviceId,
     targetDeviceId,
     servo1Angle,
     servo2Angle,
-    servo1Sent,
-    servo2Sent,
+    poseSent,
+    poseConfirmed,
+    poseStatus,
+    latencyMs: ack?.sendToAcceptedMs,
     sourcePose,
     targetPose,
   };
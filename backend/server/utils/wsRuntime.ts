@@ -1,3 +1,5 @@
+import { COMMAND_ACK_TIMEOUT_MS, type CommandAck, trackCommand, waitForAck } from './commandRuntime';
+
 interface RuntimeEntry {
   deviceId: string;
   peer: any; // Nitro CrossWS peer
@@ -20,6 +22,7 @@ interface RuntimeEntry {
   uwbPeriod?: number;
   uwbLocalAddress?: number;
   uwbPeer0Address?: number;
+  heartbeatSynced?: boolean; // Получен полный heartbeat, можно применять разностные
 }
 
 const runtime: Map<string, RuntimeEntry> = new Map(); // key: peer.id
@@ -53,11 +56,13 @@ export function updateHeartbeat(
     period?: number;
     localAddress?: number;
     peer0Address?: number;
-  }
+  },
+  keyframe = true,
 ) {
   const entry = runtime.get(peerId);
   if (!entry) return null;
   entry.lastHeartbeat = Date.now();
+  if (keyframe) entry.heartbeatSynced = true;
   if (typeof s1 === 'number') entry.servo1Angle = s1;
   if (typeof s2 === 'number') entry.servo2Angle = s2;
   if (typeof uwb?.ready === 'boolean') entry.uwbReady = uwb.ready;
@@ -79,6 +84,16 @@ export function updateHeartbeat(
   return entry;
 }
 
+// Разностный heartbeat содержит только изменившиеся поля и без полного
+// снимка в текущей сессии дал бы неполное состояние
+export function canApplyHeartbeatDelta(peerId: string) {
+  return runtime.get(peerId)?.heartbeatSynced === true;
+}
+
+export function getRuntimeByPeer(peerId: string) {
+  return runtime.get(peerId) ?? null;
+}
+
 export function getRuntimeByDevice(deviceId: string) {
   for (const e of runtime.values()) {
     if (e.deviceId === deviceId) return e;
@@ -135,17 +150,55 @@ export function onlineDevices(): Array<{
     }));
 }
 
-export function sendServoCommand(deviceId: string, servo: number, angle: number) {
+// Каждая команда получает seq: устройство подтверждает её command_ack
+function dispatch(deviceId: string, command: Record<string, unknown>) {
   const entry = getRuntimeByDevice(deviceId);
-  if (!entry) return false;
-  entry.peer.send(JSON.stringify({ type: 'set_servo', id: servo, angle }));
-  return true;
+  if (!entry) return null;
+  const seq = trackCommand(deviceId, String(command.type));
+  entry.peer.send(JSON.stringify({ ...command, seq }));
+  return seq;
 }
 
-export function sendToDevice(deviceId: string, command: any) {
-  const entry = getRuntimeByDevice(deviceId);
-  if (!entry) return false;
-  entry.peer.send(JSON.stringify(command));
-  return true;
+export interface CommandResult {
+  sent: boolean;       // Сокет устройства был открыт
+  confirmed: boolean;  // Устройство прислало command_ack
+  status?: string;     // Статус из ack: ok, invalid, unknown_type, no_type
+  ack?: CommandAck;
 }
 
+// Отправить и дождаться подтверждения; без ack за timeoutMs — confirmed: false
+export async function sendConfirmed(
+  deviceId: string,
+  command: Record<string, unknown>,
+  timeoutMs = COMMAND_ACK_TIMEOUT_MS,
+): Promise<CommandResult> {
+  const seq = dispatch(deviceId, command);
+  if (seq === null) return { sent: false, confirmed: false };
+  const ack = await waitForAck(deviceId, seq, timeoutMs);
+  if (!ack) return { sent: true, confirmed: false };
+  return { sent: true, confirmed: true, status: ack.status, ack };
+}
+
+export function servoCommand(servo: number, angle: number) {
+  return { type: 'set_servo', id: servo, angle };
+}
+
+// Обе оси одним сообщением: устройство согласует их так, чтобы они пришли одновременно
+export function poseCommand(pan: number, tilt: number, durationMs?: number) {
+  return {
+    type: 'set_pose',
+    pan,
+    tilt,
+    ...(typeof durationMs === 'number' ? { durationMs } : {}),
+  };
+}
+
+// Операции пакета устройство применяет вместе: один кадр LED и одно согласованное движение осей
+export function batchCommand(ops: Array<Record<string, unknown>>) {
+  return { type: 'batch', ops };
+}
+
+// Без ожидания подтверждения; задержка всё равно учитывается, если ack придёт
+export function sendToDevice(deviceId: string, command: any) {
+  return dispatch(deviceId, command) !== null;
+}
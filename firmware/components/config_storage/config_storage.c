@@ -159,4 +159,83 @@ esp_err_t config_storage_save(const device_config_t* config)
     
     nvs_close(nvs_handle);
     return err;
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Ключ NVS калибровки сервопривода
+ */
+static const char* servo_calibration_key(int servo_id)
+{
+    return servo_id == 1 ? "servo1_cal" : "servo2_cal";
+}
+
+esp_err_t config_storage_load_servo_calibration(int servo_id, servo_calibration_t* calibration)
+{
+    if ((servo_id != 1 && servo_id != 2) || calibration == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    nvs_handle_t nvs_handle;
+    esp_err_t err = nvs_open(CONFIG_NAMESPACE, NVS_READONLY, &nvs_handle);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Error opening NVS handle: %s", esp_err_to_name(err));
+        return err;
+    }
+    
+    servo_calibration_t stored;
+    size_t required_size = sizeof(stored);
+    err = nvs_get_blob(nvs_handle, servo_calibration_key(servo_id), &stored, &required_size);
+    nvs_close(nvs_handle);
+    if (err != ESP_OK) {
+        if (err != ESP_ERR_NVS_NOT_FOUND) {
+            ESP_LOGE(TAG, "Error reading servo %d calibration: %s", servo_id, esp_err_to_name(err));
+        }
+        return err;
+    }
+    
+    if (required_size != sizeof(stored) || stored.version != SERVO_CALIBRATION_VERSION) {
+        ESP_LOGW(TAG, "Servo %d calibration has unknown format, ignored", servo_id);
+        return ESP_ERR_INVALID_VERSION;
+    }
+    
+    *calibration = stored;
+    return ESP_OK;
+}
+
+esp_err_t config_storage_save_servo_calibration(int servo_id, const servo_calibration_t* calibration)
+{
+    if (servo_id != 1 && servo_id != 2) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    nvs_handle_t nvs_handle;
+    esp_err_t err = nvs_open(CONFIG_NAMESPACE, NVS_READWRITE, &nvs_handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Error opening NVS handle: %s", esp_err_to_name(err));
+        return err;
+    }
+    
+    if (calibration != NULL) {
+        err = nvs_set_blob(nvs_handle, servo_calibration_key(servo_id), calibration, sizeof(*calibration));
+    } else {
+        err = nvs_erase_key(nvs_handle, servo_calibration_key(servo_id));
+        if (err == ESP_ERR_NVS_NOT_FOUND) {
+            err = ESP_OK;
+        }
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Error saving servo %d calibration: %s", servo_id, esp_err_to_name(err));
+        nvs_close(nvs_handle);
+        return err;
+    }
+    
+    err = nvs_commit(nvs_handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Error committing to NVS: %s", esp_err_to_name(err));
+    } else {
+        ESP_LOGI(TAG, "Servo %d calibration %s", servo_id, calibration != NULL ? "saved" : "erased");
+    }
+    
+    nvs_close(nvs_handle);
+    return err;
+}
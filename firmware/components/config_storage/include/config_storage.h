@@ -3,6 +3,7 @@
 #include "esp_err.h"
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -22,6 +23,10 @@ extern "C" {
 #define SERVO_MIN_ANGLE 0
 #define SERVO_MAX_ANGLE 180
 
+// Калибровка сервоприводов
+#define SERVO_CALIBRATION_MAX_POINTS 8
+#define SERVO_CALIBRATION_VERSION 1
+
 // Структура конфигурации устройства
 typedef struct {
     char wifi_ssid[64];
@@ -35,10 +40,22 @@ typedef struct {
 typedef struct {
     int angle1;
     int angle2;
+    int32_t angle1_cdeg;    // Тот же угол в сотых долях градуса
+    int32_t angle2_cdeg;
     bool moving1;
     bool moving2;
 } servo_status_t;
 
+// Калибровочная таблица сервопривода: угол -> ширина импульса, между
+// точками линейная интерполяция. Хранится в NVS как blob, поэтому только
+// типы фиксированного размера
+typedef struct {
+    uint8_t version;                                     // SERVO_CALIBRATION_VERSION
+    uint8_t count;                                       // Число точек, 2..SERVO_CALIBRATION_MAX_POINTS
+    uint16_t angle_cdeg[SERVO_CALIBRATION_MAX_POINTS];   // Углы по возрастанию, сотые градуса
+    uint16_t pulse_us[SERVO_CALIBRATION_MAX_POINTS];     // Импульс в точке, мкс
+} servo_calibration_t;
+
 /**
  * @brief Инициализация NVS
  * @return ESP_OK при успехе
@@ -59,6 +76,23 @@ esp_err_t config_storage_load(device_config_t* config);
  */
 esp_err_t config_storage_save(const device_config_t* config);
 
+/**
+ * @brief Загрузить калибровочную таблицу сервопривода из NVS
+ * @param servo_id ID сервопривода (1 или 2)
+ * @param calibration Указатель на структуру для таблицы
+ * @return ESP_OK при успехе, ESP_ERR_NVS_NOT_FOUND если таблица не сохранялась,
+ *         ESP_ERR_INVALID_VERSION если сохранена в другом формате
+ */
+esp_err_t config_storage_load_servo_calibration(int servo_id, servo_calibration_t* calibration);
+
+/**
+ * @brief Сохранить калибровочную таблицу сервопривода в NVS
+ * @param servo_id ID сервопривода (1 или 2)
+ * @param calibration Таблица; NULL удаляет сохранённую
+ * @return ESP_OK при успехе
+ */
+esp_err_t config_storage_save_servo_calibration(int servo_id, const servo_calibration_t* calibration);
+
 /**
  * @brief Генерация device_id на основе MAC адреса
  * @param device_id Буфер для хранения device_id (минимум 32 байта)
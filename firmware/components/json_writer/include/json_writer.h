@@ -0,0 +1,74 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Потоковая запись JSON в заранее выделенный буфер: без кучи, без snprintf,
+ * без форматирования пробелами. Запятые и вложенность отслеживаются сами.
+ * При нехватке места запись прекращается, а json_writer_finish вернёт 0.
+ * Заголовок не тянет зависимостей ESP-IDF (см. firmware/host_bench).
+ */
+
+#define JSON_WRITER_MAX_DEPTH 32
+
+typedef struct {
+    char *buffer;
+    size_t size;
+    size_t length;
+    uint32_t first_mask;    ///< Бит на уровень: следующий элемент первый в контейнере
+    uint8_t depth;
+    bool after_key;
+    bool overflow;
+} json_writer_t;
+
+/**
+ * @brief Начать запись в buffer
+ */
+void json_writer_init(json_writer_t *writer, char *buffer, size_t size);
+
+void json_writer_object_begin(json_writer_t *writer);
+void json_writer_object_end(json_writer_t *writer);
+void json_writer_array_begin(json_writer_t *writer);
+void json_writer_array_end(json_writer_t *writer);
+
+/**
+ * @brief Записать ключ; следующим должно идти значение
+ */
+void json_writer_key(json_writer_t *writer, const char *key);
+
+void json_writer_string(json_writer_t *writer, const char *value);
+void json_writer_int(json_writer_t *writer, int64_t value);
+void json_writer_uint(json_writer_t *writer, uint64_t value);
+void json_writer_bool(json_writer_t *writer, bool value);
+void json_writer_null(json_writer_t *writer);
+
+/**
+ * @brief Записать число с фиксированной точкой
+ * @param decimals Количество знаков после запятой (до 9), хвостовые нули отбрасываются
+ *
+ * NaN, бесконечность и |value| > 9e15 записываются как null. Для больших
+ * значений знаков после запятой становится меньше, чтобы не выйти за uint64.
+ */
+void json_writer_float(json_writer_t *writer, double value, unsigned decimals);
+
+void json_writer_field_string(json_writer_t *writer, const char *key, const char *value);
+void json_writer_field_int(json_writer_t *writer, const char *key, int64_t value);
+void json_writer_field_uint(json_writer_t *writer, const char *key, uint64_t value);
+void json_writer_field_bool(json_writer_t *writer, const char *key, bool value);
+void json_writer_field_float(json_writer_t *writer, const char *key, double value, unsigned decimals);
+
+/**
+ * @brief Завершить запись и добавить завершающий ноль
+ * @return Длина JSON без нуля; 0 если буфер переполнен или контейнеры не закрыты
+ */
+size_t json_writer_finish(json_writer_t *writer);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,274 @@
+#include "json_writer.h"
+
+#include <string.h>
+
+static const char s_hex_digits[] = "0123456789abcdef";
+
+static void put_bytes(json_writer_t *writer, const char *bytes, size_t len)
+{
+    // Один байт всегда остаётся под завершающий ноль
+    if (writer->overflow || writer->size - writer->length <= len) {
+        writer->overflow = true;
+        return;
+    }
+    memcpy(writer->buffer + writer->length, bytes, len);
+    writer->length += len;
+}
+
+static void put_char(json_writer_t *writer, char c)
+{
+    put_bytes(writer, &c, 1);
+}
+
+static void begin_value(json_writer_t *writer)
+{
+    if (writer->after_key) {
+        writer->after_key = false;
+        return;
+    }
+
+    uint32_t bit = 1u << writer->depth;
+    if (writer->depth > 0 && (writer->first_mask & bit) == 0) {
+        put_char(writer, ',');
+    }
+    writer->first_mask &= ~bit;
+}
+
+static void begin_container(json_writer_t *writer, char open)
+{
+    begin_value(writer);
+    put_char(writer, open);
+    if (writer->depth + 1 >= JSON_WRITER_MAX_DEPTH) {
+        writer->overflow = true;
+        return;
+    }
+    writer->depth++;
+    writer->first_mask |= 1u << writer->depth;
+}
+
+static void end_container(json_writer_t *writer, char close)
+{
+    put_char(writer, close);
+    if (writer->depth == 0) {
+        writer->overflow = true;
+        return;
+    }
+    writer->depth--;
+}
+
+static void put_escaped(json_writer_t *writer, const char *value)
+{
+    put_char(writer, '"');
+
+    const char *run = value;
+    for (const char *p = value; *p != '\0'; p++) {
+        unsigned char c = (unsigned char)*p;
+        if (c >= 0x20 && c != '"' && c != '\\') {
+            continue;
+        }
+
+        put_bytes(writer, run, (size_t)(p - run));
+        run = p + 1;
+
+        switch (c) {
+            case '"':  put_bytes(writer, "\\\"", 2); break;
+            case '\\': put_bytes(writer, "\\\\", 2); break;
+            case '\n': put_bytes(writer, "\\n", 2); break;
+            case '\r': put_bytes(writer, "\\r", 2); break;
+            case '\t': put_bytes(writer, "\\t", 2); break;
+            default: {
+                char escaped[6] = {'\\', 'u', '0', '0', s_hex_digits[c >> 4], s_hex_digits[c & 0x0F]};
+                put_bytes(writer, escaped, sizeof(escaped));
+                break;
+            }
+        }
+    }
+    put_bytes(writer, run, strlen(run));
+
+    put_char(writer, '"');
+}
+
+static void put_uint(json_writer_t *writer, uint64_t value)
+{
+    char digits[20];
+    size_t count = 0;
+    do {
+        digits[sizeof(digits) - 1 - count++] = (char)('0' + value % 10u);
+        value /= 10u;
+    } while (value != 0);
+    put_bytes(writer, digits + sizeof(digits) - count, count);
+}
+
+void json_writer_init(json_writer_t *writer, char *buffer, size_t size)
+{
+    memset(writer, 0, sizeof(*writer));
+    writer->buffer = buffer;
+    writer->size = size;
+    writer->overflow = (buffer == NULL || size == 0);
+}
+
+void json_writer_object_begin(json_writer_t *writer)
+{
+    begin_container(writer, '{');
+}
+
+void json_writer_object_end(json_writer_t *writer)
+{
+    end_container(writer, '}');
+}
+
+void json_writer_array_begin(json_writer_t *writer)
+{
+    begin_container(writer, '[');
+}
+
+void json_writer_array_end(json_writer_t *writer)
+{
+    end_container(writer, ']');
+}
+
+void json_writer_key(json_writer_t *writer, const char *key)
+{
+    begin_value(writer);
+    put_escaped(writer, key);
+    put_char(writer, ':');
+    writer->after_key = true;
+}
+
+void json_writer_string(json_writer_t *writer, const char *value)
+{
+    begin_value(writer);
+    if (value == NULL) {
+        put_bytes(writer, "null", 4);
+        return;
+    }
+    put_escaped(writer, value);
+}
+
+void json_writer_int(json_writer_t *writer, int64_t value)
+{
+    begin_value(writer);
+    if (value < 0) {
+        put_char(writer, '-');
+        put_uint(writer, (uint64_t)0 - (uint64_t)value);
+        return;
+    }
+    put_uint(writer, (uint64_t)value);
+}
+
+void json_writer_uint(json_writer_t *writer, uint64_t value)
+{
+    begin_value(writer);
+    put_uint(writer, value);
+}
+
+void json_writer_bool(json_writer_t *writer, bool value)
+{
+    begin_value(writer);
+    if (value) {
+        put_bytes(writer, "true", 4);
+    } else {
+        put_bytes(writer, "false", 5);
+    }
+}
+
+void json_writer_null(json_writer_t *writer)
+{
+    begin_value(writer);
+    put_bytes(writer, "null", 4);
+}
+
+void json_writer_float(json_writer_t *writer, double value, unsigned decimals)
+{
+    static const uint32_t s_pow10[] = {
+        1u, 10u, 100u, 1000u, 10000u, 100000u, 1000000u, 10000000u, 100000000u, 1000000000u,
+    };
+
+    // NaN не равен сам себе; за пределами int64 фиксированная точка не нужна
+    if (value != value || value > 9.0e15 || value < -9.0e15) {
+        json_writer_null(writer);
+        return;
+    }
+
+    if (decimals > 9) {
+        decimals = 9;
+    }
+
+    bool negative = value < 0.0;
+    double magnitude = negative ? -value : value;
+
+    // magnitude * scale тоже должно уместиться: большие числа теряют дробные знаки
+    while (decimals > 0 && magnitude > 9.0e15 / s_pow10[decimals]) {
+        decimals--;
+    }
+
+    begin_value(writer);
+
+    uint32_t scale = s_pow10[decimals];
+    uint64_t scaled = (uint64_t)(magnitude * (double)scale + 0.5);
+    uint64_t whole = scaled / scale;
+    uint32_t fraction = (uint32_t)(scaled % scale);
+
+    if (negative && scaled != 0) {
+        put_char(writer, '-');
+    }
+    put_uint(writer, whole);
+
+    if (fraction == 0) {
+        return;
+    }
+
+    char digits[9];
+    unsigned count = decimals;
+    for (unsigned i = decimals; i > 0; i--) {
+        digits[i - 1] = (char)('0' + fraction % 10u);
+        fraction /= 10u;
+    }
+    while (count > 0 && digits[count - 1] == '0') {
+        count--;
+    }
+    put_char(writer, '.');
+    put_bytes(writer, digits, count);
+}
+
+void json_writer_field_string(json_writer_t *writer, const char *key, const char *value)
+{
+    json_writer_key(writer, key);
+    json_writer_string(writer, value);
+}
+
+void json_writer_field_int(json_writer_t *writer, const char *key, int64_t value)
+{
+    json_writer_key(writer, key);
+    json_writer_int(writer, value);
+}
+
+void json_writer_field_uint(json_writer_t *writer, const char *key, uint64_t value)
+{
+    json_writer_key(writer, key);
+    json_writer_uint(writer, value);
+}
+
+void json_writer_field_bool(json_writer_t *writer, const char *key, bool value)
+{
+    json_writer_key(writer, key);
+    json_writer_bool(writer, value);
+}
+
+void json_writer_field_float(json_writer_t *writer, const char *key, double value, unsigned decimals)
+{
+    json_writer_key(writer, key);
+    json_writer_float(writer, value, decimals);
+}
+
+size_t json_writer_finish(json_writer_t *writer)
+{
+    if (writer->overflow || writer->depth != 0 || writer->after_key) {
+        if (writer->buffer != NULL && writer->size > 0) {
+            writer->buffer[0] = '\0';
+        }
+        return 0;
+    }
+    writer->buffer[writer->length] = '\0';
+    return writer->length;
+}
@@ -8,7 +8,13 @@
 extern "C" {
 #endif
 
-#define LED_CONTROLLER_MAX_LEDS 64
+#ifdef CONFIG_LED_CONTROLLER_MAX_LEDS
+#define LED_CONTROLLER_MAX_LEDS CONFIG_LED_CONTROLLER_MAX_LEDS
+#else
+#define LED_CONTROLLER_MAX_LEDS 512
+#endif
+
+#define LED_CONTROLLER_MAX_STRIPS 4  ///< Каждой ленте нужен свой канал RMT
 
 /**
  * @brief Структура для RGB цвета
@@ -19,6 +25,78 @@ typedef struct {
     uint8_t b;  ///< Синий канал (0-255)
 } led_rgb_t;
 
+/**
+ * @brief Цвет в 16-битном линейном свете (после гамма-коррекции)
+ */
+typedef struct {
+    uint16_t r;
+    uint16_t g;
+    uint16_t b;
+} led_rgb16_t;
+
+/**
+ * @brief Тип эффекта
+ */
+typedef enum {
+    LED_EFFECT_NONE = 0,    ///< Эффект не задан, лента показывает статический цвет
+    LED_EFFECT_FADE,        ///< Плавный переход from -> color за duration_ms
+    LED_EFFECT_BREATHE,     ///< «Дыхание» цвета color с периодом period_ms
+    LED_EFFECT_CHASE,       ///< Бегущий отрезок width цвета color по фону from
+    LED_EFFECT_COLOR_TEMP,  ///< Переход цветовой температуры kelvin_from -> kelvin_to
+    LED_EFFECT_GRADIENT,    ///< Статические градиенты по зонам ленты
+} led_effect_type_t;
+
+#define LED_EFFECT_MAX_ZONES 4
+
+/**
+ * @brief Зона градиента: светодиоды first..last от from к to
+ */
+typedef struct {
+    uint16_t first;
+    uint16_t last;
+    led_rgb_t from;
+    led_rgb_t to;
+} led_effect_zone_t;
+
+/**
+ * @brief Параметры эффекта; поля, не используемые типом, игнорируются
+ */
+typedef struct {
+    led_effect_type_t type;
+    led_rgb_t color;            ///< Целевой / основной цвет
+    led_rgb_t from;             ///< Начальный цвет перехода или фон бегущего отрезка
+    bool from_current;          ///< FADE начинается с цвета, который сейчас на ленте
+    uint32_t duration_ms;       ///< Длительность перехода (FADE, COLOR_TEMP)
+    uint32_t period_ms;         ///< Период повторения (BREATHE, CHASE)
+    uint16_t kelvin_from;       ///< Температура, K (COLOR_TEMP)
+    uint16_t kelvin_to;
+    uint8_t min_level;          ///< Минимальный уровень «дыхания», 0-255
+    uint8_t width;              ///< Длина бегущего отрезка, светодиодов
+    uint8_t zone_count;
+    led_effect_zone_t zones[LED_EFFECT_MAX_ZONES];
+} led_effect_t;
+
+/**
+ * @brief Что пакет изменений делает с содержимым лент
+ */
+typedef enum {
+    LED_CHANGE_KEEP = 0,    ///< Содержимое не меняется
+    LED_CHANGE_COLOR,       ///< Статический цвет color
+    LED_CHANGE_EFFECT,      ///< Эффект effect
+    LED_CHANGE_CLEAR,       ///< Выключить светодиоды
+} led_change_content_t;
+
+/**
+ * @brief Пакет изменений всех лент, применяемый одним кадром
+ */
+typedef struct {
+    led_change_content_t content;
+    led_rgb_t color;
+    led_effect_t effect;
+    bool set_brightness;
+    uint8_t brightness;
+} led_controller_change_t;
+
 /**
  * @brief Конфигурация LED контроллера
  */
@@ -28,13 +106,60 @@ typedef struct {
 } led_controller_config_t;
 
 /**
- * @brief Инициализация LED контроллера
+ * @brief Дескриптор ленты
+ */
+typedef struct led_controller *led_controller_handle_t;
+
+/**
+ * @brief Бюджет времени кадра
+ *
+ * Ленты передаются параллельно, каждая своим каналом RMT, поэтому кадр
+ * занимает время самой длинной ленты (wire_us), а не сумму (serial_wire_us).
+ */
+typedef struct {
+    int strip_count;
+    int led_count;              ///< Светодиодов во всех лентах
+    uint32_t frame_period_us;   ///< Период кадра эффектов
+    uint32_t wire_us;           ///< Расчётное время передачи кадра самой длинной ленты
+    uint32_t serial_wire_us;    ///< Расчётное время, если передавать ленты по очереди
+    uint32_t measured_us;       ///< Измеренное время последнего кадра самой медленной ленты, 0 — кадров ещё не было
+} led_frame_budget_t;
+
+/**
+ * @brief Инициализация LED контроллера с одной лентой
+ *
+ * То же, что led_controller_add_strip для первой ленты.
  * 
  * @param config Конфигурация контроллера
  * @return ESP_OK в случае успеха
  */
 esp_err_t led_controller_init(const led_controller_config_t *config);
 
+/**
+ * @brief Добавить ленту на отдельном канале RMT
+ *
+ * Функции без дескриптора работают со всеми лентами сразу; сквозной
+ * индекс led_controller_set_color идёт по лентам в порядке добавления.
+ * 
+ * @param config Конфигурация ленты
+ * @param out_handle Дескриптор ленты (может быть NULL)
+ * @return ESP_OK в случае успеха, ESP_ERR_NO_MEM если лент уже
+ *         LED_CONTROLLER_MAX_STRIPS
+ */
+esp_err_t led_controller_add_strip(const led_controller_config_t *config, led_controller_handle_t *out_handle);
+
+/**
+ * @brief Получить дескриптор ленты по порядковому номеру
+ * 
+ * @return Дескриптор или NULL, если ленты с таким номером нет
+ */
+led_controller_handle_t led_controller_get_strip(int index);
+
+/**
+ * @brief Получить количество добавленных лент
+ */
+int led_controller_get_strip_count(void);
+
 /**
  * @brief Деинициализация LED контроллера
  * 
@@ -50,6 +175,17 @@ esp_err_t led_controller_deinit(void);
  */
 esp_err_t led_controller_set_all_color(const led_rgb_t *color);
 
+/**
+ * @brief Установка 16-битного линейного цвета для всех светодиодов
+ *
+ * Гамма-коррекция не применяется: значение задаёт световой поток
+ * напрямую, а уровни между шагами 8-битной ленты передаются дизерингом.
+ * 
+ * @param color Линейный цвет, 0-65535 на канал
+ * @return ESP_OK в случае успеха
+ */
+esp_err_t led_controller_set_all_color16(const led_rgb16_t *color);
+
 /**
  * @brief Установка цвета для одного светодиода
  * 
@@ -59,13 +195,46 @@ esp_err_t led_controller_set_all_color(const led_rgb_t *color);
  */
 esp_err_t led_controller_set_color(int led_index, const led_rgb_t *color);
 
+/**
+ * @brief Запустить эффект
+ *
+ * Кадры рисует отдельная задача с фиксированной частотой
+ * (CONFIG_LED_CONTROLLER_EFFECT_FPS) с учётом текущей яркости. Переходы
+ * (FADE, COLOR_TEMP) после завершения оставляют ленту на конечном цвете;
+ * led_controller_set_all_color, led_controller_set_color и
+ * led_controller_clear останавливают эффект.
+ * 
+ * @param effect Параметры эффекта; LED_EFFECT_NONE останавливает текущий
+ * @return ESP_OK в случае успеха
+ */
+esp_err_t led_controller_set_effect(const led_effect_t *effect);
+
 /**
  * @brief Отправка данных на светодиодную ленту
+ *
+ * Не ждёт передачи: кадр из заднего буфера ставится в очередь RMT, а
+ * следующий можно готовить, пока этот уходит по проводу. Если провод
+ * занят предыдущим кадром, новый отправит led_controller_task. Кадры
+ * всех лент запускаются подряд и передаются одновременно.
  * 
  * @return ESP_OK в случае успеха
  */
 esp_err_t led_controller_update(void);
 
+/**
+ * @brief Отправить кадр, отложенный из-за занятого провода
+ *
+ * Должна вызываться периодически (из задания led планировщика control).
+ */
+void led_controller_task(void);
+
+/**
+ * @brief Проверить, есть ли неотправленный или уходящий кадр
+ * 
+ * @return true, пока лента не показывает последний записанный кадр
+ */
+bool led_controller_is_busy(void);
+
 /**
  * @brief Выключение всех светодиодов
  * 
@@ -75,19 +244,85 @@ esp_err_t led_controller_clear(void);
 
 /**
  * @brief Установка яркости
+ *
+ * Шкала перцептивная (множитель (brightness / 255)^2), кадр сразу
+ * перерисовывается с новой яркостью.
  * 
  * @param brightness Яркость от 0 до 255
  * @return ESP_OK в случае успеха
  */
 esp_err_t led_controller_set_brightness(uint8_t brightness);
 
+/**
+ * @brief Применить пакет изменений ко всем лентам
+ *
+ * Содержимое и яркость меняются под одной блокировкой, кадр
+ * перерисовывается и отправляется один раз: промежуточное состояние
+ * (новый цвет со старой яркостью) на ленту не попадает.
+ * 
+ * @param change Изменения
+ * @return ESP_OK в случае успеха
+ */
+esp_err_t led_controller_apply(const led_controller_change_t *change);
+
 /**
  * @brief Получение текущего количества светодиодов
  * 
- * @return Количество светодиодов или -1 если контроллер не инициализирован
+ * @return Количество светодиодов во всех лентах или -1 если контроллер
+ *         не инициализирован
  */
 int led_controller_get_led_count(void);
 
+/**
+ * @brief Установка цвета для всех светодиодов одной ленты
+ *
+ * Как и led_controller_set_all_color, только пишет кадр: отправляет его
+ * led_controller_update.
+ */
+esp_err_t led_controller_strip_set_all_color(led_controller_handle_t strip, const led_rgb_t *color);
+
+/**
+ * @brief Установка 16-битного линейного цвета для всех светодиодов одной ленты
+ */
+esp_err_t led_controller_strip_set_all_color16(led_controller_handle_t strip, const led_rgb16_t *color);
+
+/**
+ * @brief Установка цвета для одного светодиода ленты
+ *
+ * @param led_index Индекс светодиода в ленте (0-based)
+ */
+esp_err_t led_controller_strip_set_color(led_controller_handle_t strip, int led_index, const led_rgb_t *color);
+
+/**
+ * @brief Установка яркости одной ленты; кадр ленты сразу перерисовывается
+ */
+esp_err_t led_controller_strip_set_brightness(led_controller_handle_t strip, uint8_t brightness);
+
+/**
+ * @brief Запустить эффект на одной ленте
+ */
+esp_err_t led_controller_strip_set_effect(led_controller_handle_t strip, const led_effect_t *effect);
+
+/**
+ * @brief Выключение светодиодов одной ленты
+ */
+esp_err_t led_controller_strip_clear(led_controller_handle_t strip);
+
+/**
+ * @brief Получение количества светодиодов ленты
+ * 
+ * @return Количество светодиодов или -1 для неизвестного дескриптора
+ */
+int led_controller_strip_get_led_count(led_controller_handle_t strip);
+
+/**
+ * @brief Получить бюджет времени кадра по всем лентам
+ * 
+ * @param budget Результат
+ * @return ESP_OK в случае успеха
+ */
+esp_err_t led_controller_get_frame_budget(led_frame_budget_t *budget);
+
 #ifdef __cplusplus
 }
 #endif
\ No newline at end of file
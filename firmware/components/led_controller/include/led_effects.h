@@ -0,0 +1,38 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "led_controller.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Отрисовка кадров эффектов (led_effect_t) в массив цветов без учёта
+ * яркости и порядка байт ленты. Модуль не зависит от ESP-IDF и
+ * собирается на хосте.
+ */
+
+/**
+ * @brief Нарисовать кадр эффекта
+ * 
+ * @param effect Параметры эффекта
+ * @param elapsed_ms Время от запуска эффекта
+ * @param pixels Кадр, count элементов
+ * @param count Количество светодиодов
+ * @return true, пока эффект меняет картинку; false — кадр окончательный
+ */
+bool led_effect_render(const led_effect_t *effect, uint32_t elapsed_ms, led_rgb_t *pixels, int count);
+
+/**
+ * @brief Цвет излучения чёрного тела для температуры 1000-10000 K
+ * 
+ * @param kelvin Температура, за пределами диапазона ограничивается
+ * @param color Результат
+ */
+void led_effect_kelvin_to_rgb(uint32_t kelvin, led_rgb_t *color);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Путь цвета от кадра к байтам ленты. Кадр хранится в 16-битном
+ * линейном свете (после гамма-коррекции), яркость — множитель 0.16 из
+ * таблицы, а дробная часть результата, не помещающаяся в 8 бит ленты,
+ * переносится на следующий кадр (временной дизеринг). Всё за один проход
+ * по буферу GRB без делений. Модуль не зависит от ESP-IDF и собирается
+ * на хосте.
+ */
+
+#define LED_GAMMA_LUT_SIZE 256
+
+/** 8-битный цвет -> 16-битный линейный свет, round(65535 * (i / 255)^2.6) */
+extern const uint16_t led_gamma_lut[LED_GAMMA_LUT_SIZE];
+
+/** Яркость 0-255 -> множитель 0.16, round(65535 * (i / 255)^2) */
+extern const uint16_t led_brightness_lut[LED_GAMMA_LUT_SIZE];
+
+/**
+ * @brief Ближайший 8-битный цвет для линейного значения (обратная гамма)
+ */
+uint8_t led_gamma_inverse(uint16_t linear);
+
+/**
+ * @brief Преобразовать линейный кадр в байты ленты
+ * 
+ * @param linear Линейный свет, subpixels значений в порядке ленты
+ * @param out Байты ленты
+ * @param error Остаток дизеринга на субпиксель, хранится между кадрами
+ * @param subpixels Количество субпикселей (светодиодов × 3)
+ * @param scale Множитель яркости 0.16 (led_brightness_lut)
+ * @param dither Переносить дробную часть на следующий кадр; без дизеринга
+ *               она отбрасывается, а error не меняется
+ * @return true, если у кадра есть дробная часть: при дизеринге кадр нужно
+ *         повторять, чтобы средний уровень совпал с заданным
+ */
+bool led_pipeline_render(const uint16_t *linear, uint8_t *out, uint8_t *error,
+                         size_t subpixels, uint16_t scale, bool dither);
+
+/**
+ * @brief Учесть отрисованный кадр в признаке повтора дизеринга
+ *
+ * @param refresh Признак ленты «кадр нужно повторять», обновляется
+ * @param fractional Результат led_pipeline_render
+ * @param dither Включён ли дизеринг
+ * @return true, если повтор только что стал нужен: задачу, повторяющую
+ *         кадры, пора разбудить
+ */
+bool led_pipeline_update_refresh(bool *refresh, bool fractional, bool dither);
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,31 +1,382 @@
 #include <string.h>
 #include <stdlib.h>
+#include <stdatomic.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/semphr.h"
 #include "led_controller.h"
 #include "led_strip_encoder.h"
+#include "led_effects.h"
+#include "led_pipeline.h"
 #include "driver/rmt_tx.h"
+#include "esp_attr.h"
 #include "esp_log.h"
+#include "esp_timer.h"
+#include "soc/soc_caps.h"
 
 static const char *TAG = "led_controller";
 
 #define RMT_LED_STRIP_RESOLUTION_HZ 10000000 // 10MHz resolution, 1 tick = 0.1us
-
-// Структура для хранения состояния LED контроллера
-typedef struct {
+#define LED_DEINIT_TIMEOUT_MS 100           // Дождаться последнего кадра перед освобождением буферов
+#define LED_EFFECT_TASK_STACK_SIZE 3072
+#define LED_EFFECT_TASK_PRIORITY 4          // Ниже планировщика control: сервоприводы важнее кадра эффекта
+
+#ifdef CONFIG_LED_CONTROLLER_DITHER
+#define LED_DITHER true
+#else
+#define LED_DITHER false
+#endif
+
+#ifdef CONFIG_LED_CONTROLLER_EFFECT_FPS
+#define LED_EFFECT_FPS CONFIG_LED_CONTROLLER_EFFECT_FPS
+#else
+#define LED_EFFECT_FPS 60
+#endif
+
+// С DMA кадр уходит из памяти без прерываний на каждые 64 символа RMT
+#if SOC_RMT_SUPPORT_DMA
+#define LED_RMT_WITH_DMA 1
+#else
+#define LED_RMT_WITH_DMA 0
+#endif
+#define LED_RMT_DMA_SYMBOLS 1024
+#define LED_RMT_MEM_BLOCK_SYMBOLS 64
+
+// Время передачи кадра: бит 0 и бит 1 занимают по 1.2 мкс (led_strip_encoder),
+// после кадра — 50 мкс reset
+#define LED_WIRE_NS_PER_BIT 1200
+#define LED_RESET_US 50
+
+// Состояние одной ленты: свой канал RMT, свои буферы и свой эффект
+struct led_controller {
     rmt_channel_handle_t led_chan;
     rmt_encoder_handle_t led_encoder;
+    // Сеттеры пишут кадр в 16-битном линейном свете (порядок GRB);
+    // led_pipeline переводит его в задний буфер байтов ленты, RMT читает
+    // передний. Буферы меняются только при отправке кадра
+    uint16_t *linear_pixels;
+    uint8_t *dither_error;
+    bool dither_refresh;            // У кадра есть дробная часть, дизеринг требует повторов
+    uint8_t *frame_buffers[2];
     uint8_t *led_strip_pixels;
+    atomic_bool in_flight;          // Передний буфер ещё уходит по проводу
+    bool frame_pending;             // В заднем буфере кадр, ожидающий отправки
+    int64_t tx_started_us;          // Начало передачи последнего кадра
+    atomic_uint wire_us;            // Измеренное время передачи последнего кадра
     int led_count;
     int gpio_pin;
     uint8_t brightness;
     led_rgb_t current_color;  // Храним текущий цвет
-    bool initialized;
-} led_controller_state_t;
+    // Эффект владеет лентой, пока effect.type != LED_EFFECT_NONE; задача
+    // рисует кадры, пока effect_running. Поколение отсекает кадры эффекта,
+    // заменённого во время отрисовки
+    led_effect_t effect;
+    bool effect_running;
+    uint32_t effect_generation;
+    TickType_t effect_started;
+};
+
+static struct led_controller s_strips[LED_CONTROLLER_MAX_STRIPS];
+static int s_strip_count = 0;
+static SemaphoreHandle_t s_lock = NULL;  // Кадры пишут задачи WS, HTTP, control и задача эффектов
+static TaskHandle_t s_effect_task = NULL;
+
+/**
+ * @brief Конец передачи кадра (контекст прерывания RMT)
+ */
+static IRAM_ATTR bool on_frame_sent(rmt_channel_handle_t channel, const rmt_tx_done_event_data_t *edata, void *user_ctx)
+{
+    struct led_controller *strip = user_ctx;
+    atomic_store(&strip->wire_us, (unsigned int)(esp_timer_get_time() - strip->tx_started_us));
+    atomic_store(&strip->in_flight, false);
+    return false;
+}
 
-static led_controller_state_t s_led_state = {0};
+static bool is_strip(led_controller_handle_t strip)
+{
+    return strip >= s_strips && strip < s_strips + s_strip_count;
+}
 
-esp_err_t led_controller_init(const led_controller_config_t *config)
+/**
+ * @brief Расчётное время передачи кадра ленты, мкс
+ */
+static uint32_t strip_wire_us(int led_count)
+{
+    return (uint32_t)led_count * 24 * LED_WIRE_NS_PER_BIT / 1000 + LED_RESET_US;
+}
+
+/**
+ * @brief Поставить задний буфер ленты в очередь RMT, если провод свободен
+ *
+ * Вызывается под s_lock. Пока предыдущий кадр уходит, новый остаётся в
+ * заднем буфере и отправляется из led_controller_task; несколько
+ * обновлений за это время сливаются в один кадр.
+ */
+static esp_err_t flush_frame_locked(struct led_controller *strip)
+{
+    if (!strip->frame_pending || atomic_load(&strip->in_flight)) {
+        return ESP_OK;
+    }
+
+    rmt_transmit_config_t tx_config = {
+        .loop_count = 0, // no transfer loop
+        .flags.queue_nonblocking = 1,
+    };
+
+    uint8_t *front = strip->led_strip_pixels;
+    atomic_store(&strip->in_flight, true);
+    strip->tx_started_us = esp_timer_get_time();
+    esp_err_t ret = rmt_transmit(strip->led_chan, strip->led_encoder,
+                                 front, strip->led_count * 3, &tx_config);
+    if (ret != ESP_OK) {
+        atomic_store(&strip->in_flight, false);
+        ESP_LOGE(TAG, "Failed to transmit LED data on GPIO %d: %s", strip->gpio_pin, esp_err_to_name(ret));
+        return ret;
+    }
+
+    // Бывший передний буфер свободен: in_flight был снят его передачей.
+    // Следующий кадр целиком перерисовывается из линейного буфера
+    strip->led_strip_pixels = (front == strip->frame_buffers[0]) ? strip->frame_buffers[1] : strip->frame_buffers[0];
+    strip->frame_pending = false;
+    return ESP_OK;
+}
+
+/**
+ * @brief Отправить кадры всех лент (под s_lock)
+ *
+ * rmt_transmit не ждёт провода, поэтому каналы запускаются подряд с
+ * разницей в единицы микросекунд и передают параллельно: кадр всех лент
+ * занимает время самой длинной, а не сумму.
+ */
+static esp_err_t flush_all_locked(void)
+{
+    esp_err_t result = ESP_OK;
+    for (int i = 0; i < s_strip_count; i++) {
+        esp_err_t ret = flush_frame_locked(&s_strips[i]);
+        if (ret != ESP_OK && result == ESP_OK) {
+            result = ret;
+        }
+    }
+    return result;
+}
+
+/**
+ * @brief Записать линейный цвет светодиода (формат GRB, под lock)
+ */
+static void set_linear_locked(struct led_controller *strip, int led_index, const led_rgb16_t *color)
+{
+    strip->linear_pixels[led_index * 3 + 0] = color->g; // Green
+    strip->linear_pixels[led_index * 3 + 1] = color->r; // Red
+    strip->linear_pixels[led_index * 3 + 2] = color->b; // Blue
+}
+
+static led_rgb16_t to_linear(const led_rgb_t *color)
+{
+    led_rgb16_t linear = {
+        .r = led_gamma_lut[color->r],
+        .g = led_gamma_lut[color->g],
+        .b = led_gamma_lut[color->b],
+    };
+    return linear;
+}
+
+/**
+ * @brief Записать цвет всех светодиодов ленты в линейный кадр (под lock)
+ */
+static void fill_all_locked(struct led_controller *strip, const led_rgb16_t *color)
+{
+    for (int i = 0; i < strip->led_count; i++) {
+        set_linear_locked(strip, i, color);
+    }
+}
+
+/**
+ * @brief Записать кадр эффекта в линейный кадр (под lock)
+ */
+static void write_frame_locked(struct led_controller *strip, const led_rgb_t *frame)
+{
+    for (int i = 0; i < strip->led_count; i++) {
+        led_rgb16_t linear = to_linear(&frame[i]);
+        set_linear_locked(strip, i, &linear);
+    }
+}
+
+/**
+ * @brief Перевести линейный кадр в задний буфер с яркостью и дизерингом
+ *        (под lock); отправку делает flush
+ *
+ * Без эффекта задача эффектов спит до уведомления, поэтому статический
+ * цвет, которому впервые понадобился дизеринг, её будит.
+ */
+static void render_locked(struct led_controller *strip)
+{
+    bool fractional = led_pipeline_render(strip->linear_pixels, strip->led_strip_pixels,
+                                          strip->dither_error, strip->led_count * 3,
+                                          led_brightness_lut[strip->brightness], LED_DITHER);
+    if (led_pipeline_update_refresh(&strip->dither_refresh, fractional, LED_DITHER) && s_effect_task) {
+        xTaskNotifyGive(s_effect_task);
+    }
+    strip->frame_pending = true;
+}
+
+/**
+ * @brief Снять эффект: статические команды снова управляют лентой (под lock)
+ */
+static void stop_effect_locked(struct led_controller *strip)
+{
+    strip->effect.type = LED_EFFECT_NONE;
+    strip->effect_running = false;
+    strip->effect_generation++;
+}
+
+/**
+ * @brief Запустить эффект на ленте (под lock)
+ */
+static void start_effect_locked(struct led_controller *strip, const led_effect_t *effect, TickType_t now)
+{
+    stop_effect_locked(strip);
+    if (effect->type == LED_EFFECT_NONE) {
+        return;
+    }
+    strip->effect = *effect;
+    if (effect->from_current) {
+        strip->effect.from = strip->current_color;
+    }
+    strip->effect_started = now;
+    strip->effect_running = true;
+}
+
+static void set_all_color16_locked(struct led_controller *strip, const led_rgb16_t *color)
+{
+    stop_effect_locked(strip);
+    // Ближайший 8-битный цвет — начало для следующего перехода
+    strip->current_color.r = led_gamma_inverse(color->r);
+    strip->current_color.g = led_gamma_inverse(color->g);
+    strip->current_color.b = led_gamma_inverse(color->b);
+    fill_all_locked(strip, color);
+}
+
+static void set_all_color_locked(struct led_controller *strip, const led_rgb_t *color)
+{
+    stop_effect_locked(strip);
+    // Сохраняем текущий цвет
+    strip->current_color = *color;
+    led_rgb16_t linear = to_linear(color);
+    fill_all_locked(strip, &linear);
+}
+
+static void clear_locked(struct led_controller *strip)
+{
+    stop_effect_locked(strip);
+    memset(strip->linear_pixels, 0, strip->led_count * 3 * sizeof(uint16_t));
+    memset(strip->dither_error, 0, strip->led_count * 3);
+    render_locked(strip);
+}
+
+/**
+ * @brief Нарисовать очередной кадр эффекта каждой ленты
+ *
+ * Рисует без блокировки, под lock только копирует параметры и пишет
+ * готовый кадр, поэтому команды WS не ждут отрисовки.
+ *
+ * @param rendered Отмечаются ленты, получившие кадр эффекта
+ * @return true, если хотя бы на одной ленте идёт эффект
+ */
+static bool render_effects(bool *rendered)
+{
+    static led_rgb_t frame[LED_CONTROLLER_MAX_LEDS];
+    bool active = false;
+
+    for (int i = 0; i < s_strip_count; i++) {
+        struct led_controller *strip = &s_strips[i];
+        rendered[i] = false;
+
+        xSemaphoreTake(s_lock, portMAX_DELAY);
+        bool running = strip->effect_running;
+        led_effect_t effect = strip->effect;
+        uint32_t generation = strip->effect_generation;
+        TickType_t started = strip->effect_started;
+        xSemaphoreGive(s_lock);
+
+        if (!running) {
+            continue;
+        }
+        active = true;
+
+        uint32_t elapsed_ms = (uint32_t)((xTaskGetTickCount() - started) * portTICK_PERIOD_MS);
+        bool animating = led_effect_render(&effect, elapsed_ms, frame, strip->led_count);
+
+        xSemaphoreTake(s_lock, portMAX_DELAY);
+        if (generation == strip->effect_generation) {
+            write_frame_locked(strip, frame);
+            render_locked(strip);
+            rendered[i] = true;
+            if (!animating) {
+                // Окончательный кадр нарисован; лента остаётся за эффектом до новой команды
+                strip->effect_running = false;
+                strip->current_color = frame[0];
+            }
+        }
+        xSemaphoreGive(s_lock);
+    }
+    return active;
+}
+
+/**
+ * @brief Задача эффектов: кадр раз в 1/LED_EFFECT_FPS секунды
+ *
+ * Кадры всех лент отправляются вместе, одним flush. Без активного
+ * эффекта задача спит до уведомления, а если кадр какой-то ленты
+ * дизерингуется — повторяет его с той же частотой.
+ */
+static void effect_task(void *arg)
+{
+    const TickType_t period = pdMS_TO_TICKS(1000 / LED_EFFECT_FPS);
+    TickType_t last_wake = xTaskGetTickCount();
+    bool tick = false;  // Подошёл срок кадра: дизерингуемые ленты перерисовываются
+
+    while (1) {
+        bool rendered[LED_CONTROLLER_MAX_STRIPS];
+        bool active = render_effects(rendered);
+
+        bool refresh = false;
+        xSemaphoreTake(s_lock, portMAX_DELAY);
+        for (int i = 0; i < s_strip_count; i++) {
+            struct led_controller *strip = &s_strips[i];
+            if (!strip->effect_running && strip->dither_refresh) {
+                refresh = true;
+                if (tick && !rendered[i]) {
+                    render_locked(strip);
+                }
+            }
+        }
+        flush_all_locked();
+        xSemaphoreGive(s_lock);
+
+        if (active) {
+            vTaskDelayUntil(&last_wake, period > 0 ? period : 1);
+            tick = true;
+            continue;
+        }
+
+        tick = ulTaskNotifyTake(pdTRUE, refresh ? period : portMAX_DELAY) == 0 && refresh;
+        last_wake = xTaskGetTickCount();
+    }
+}
+
+static void log_frame_budget(void)
+{
+    led_frame_budget_t budget;
+    led_controller_get_frame_budget(&budget);
+    ESP_LOGI(TAG, "LED frame: %d strip(s), %d LEDs, %u us on the wire (%u us if sent one by one), period %u us",
+             budget.strip_count, budget.led_count, (unsigned)budget.wire_us,
+             (unsigned)budget.serial_wire_us, (unsigned)budget.frame_period_us);
+    if (budget.wire_us > budget.frame_period_us) {
+        ESP_LOGW(TAG, "Longest LED strip does not fit the %d fps effect frame", LED_EFFECT_FPS);
+    }
+}
+
+esp_err_t led_controller_add_strip(const led_controller_config_t *config, led_controller_handle_t *out_handle)
 {
     if (!config) {
         ESP_LOGE(TAG, "Config is NULL");
@@ -36,188 +387,471 @@ esp_err_t led_controller_init(const led_controller_config_t *config)
         ESP_LOGE(TAG, "Invalid LED count: %d", config->led_count);
         return ESP_ERR_INVALID_ARG;
     }
-    
-    if (s_led_state.initialized) {
-        ESP_LOGW(TAG, "LED controller already initialized");
-        return ESP_OK;
+
+    if (s_strip_count >= LED_CONTROLLER_MAX_STRIPS) {
+        ESP_LOGE(TAG, "No free LED strip slots (max %d)", LED_CONTROLLER_MAX_STRIPS);
+        return ESP_ERR_NO_MEM;
     }
 
-    ESP_LOGI(TAG, "Initializing LED controller on GPIO %d with %d LEDs", config->gpio_pin, config->led_count);
+    if (!s_lock) {
+        s_lock = xSemaphoreCreateMutex();
+        if (!s_lock) {
+            ESP_LOGE(TAG, "Failed to create LED lock");
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    int index = s_strip_count;
+    struct led_controller *strip = &s_strips[index];
+    memset(strip, 0, sizeof(*strip));
+
+    ESP_LOGI(TAG, "Initializing LED strip %d on GPIO %d with %d LEDs", index, config->gpio_pin, config->led_count);
     
     // Сохраняем конфигурацию
-    s_led_state.led_count = config->led_count;
-    s_led_state.gpio_pin = config->gpio_pin;
-    s_led_state.brightness = 255; // Максимальная яркость по умолчанию
+    strip->led_count = config->led_count;
+    strip->gpio_pin = config->gpio_pin;
+    strip->brightness = 255; // Максимальная яркость по умолчанию
 
-    // Создаем RMT канал
+    // Создаем RMT канал; DMA есть не у каждого канала, его получает первая лента
     rmt_tx_channel_config_t tx_chan_config = {
         .clk_src = RMT_CLK_SRC_DEFAULT,
         .gpio_num = config->gpio_pin,
-        .mem_block_symbols = 64,
+        .mem_block_symbols = (LED_RMT_WITH_DMA && index == 0) ? LED_RMT_DMA_SYMBOLS : LED_RMT_MEM_BLOCK_SYMBOLS,
         .resolution_hz = RMT_LED_STRIP_RESOLUTION_HZ,
         .trans_queue_depth = 4,
+        .flags.with_dma = LED_RMT_WITH_DMA && index == 0,
     };
-    ESP_ERROR_CHECK(rmt_new_tx_channel(&tx_chan_config, &s_led_state.led_chan));
+    ESP_ERROR_CHECK(rmt_new_tx_channel(&tx_chan_config, &strip->led_chan));
+
+    rmt_tx_event_callbacks_t callbacks = {
+        .on_trans_done = on_frame_sent,
+    };
+    ESP_ERROR_CHECK(rmt_tx_register_event_callbacks(strip->led_chan, &callbacks, strip));
 
     // Устанавливаем энкодер для LED ленты
     led_strip_encoder_config_t encoder_config = {
         .resolution = RMT_LED_STRIP_RESOLUTION_HZ,
     };
-    ESP_ERROR_CHECK(rmt_new_led_strip_encoder(&encoder_config, &s_led_state.led_encoder));
+    ESP_ERROR_CHECK(rmt_new_led_strip_encoder(&encoder_config, &strip->led_encoder));
 
     // Включаем RMT канал
-    ESP_ERROR_CHECK(rmt_enable(s_led_state.led_chan));
+    ESP_ERROR_CHECK(rmt_enable(strip->led_chan));
 
-    // Выделяем память для данных светодиодов
-    s_led_state.led_strip_pixels = malloc(config->led_count * 3);
-    if (!s_led_state.led_strip_pixels) {
+    // Выделяем память для данных светодиодов (оба буфера одним блоком)
+    strip->frame_buffers[0] = calloc(2, config->led_count * 3);
+    strip->linear_pixels = calloc(config->led_count * 3, sizeof(uint16_t));
+    strip->dither_error = calloc(config->led_count * 3, 1);
+    if (!strip->frame_buffers[0] || !strip->linear_pixels || !strip->dither_error) {
         ESP_LOGE(TAG, "Failed to allocate memory for LED strip pixels");
         return ESP_ERR_NO_MEM;
     }
+    strip->frame_buffers[1] = strip->frame_buffers[0] + config->led_count * 3;
+    strip->led_strip_pixels = strip->frame_buffers[0];
+    atomic_store(&strip->in_flight, false);
+    atomic_store(&strip->wire_us, 0);
+
+    if (!s_effect_task &&
+        xTaskCreate(effect_task, "led_effects", LED_EFFECT_TASK_STACK_SIZE, NULL,
+                    LED_EFFECT_TASK_PRIORITY, &s_effect_task) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create LED effect task");
+        return ESP_ERR_NO_MEM;
+    }
 
-    // Очищаем все светодиоды
-    memset(s_led_state.led_strip_pixels, 0, config->led_count * 3);
-    
-    s_led_state.initialized = true;
-    
-    // Отправляем данные для инициализации
-    led_controller_update();
+    // Лента видна остальным функциям только полностью готовой;
+    // отправляем данные для инициализации
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    s_strip_count++;
+    render_locked(strip);
+    flush_frame_locked(strip);
+    xSemaphoreGive(s_lock);
+
+    if (out_handle) {
+        *out_handle = strip;
+    }
+    log_frame_budget();
     
-    ESP_LOGI(TAG, "LED controller initialized successfully");
+    ESP_LOGI(TAG, "LED strip %d initialized successfully", index);
     return ESP_OK;
 }
 
+esp_err_t led_controller_init(const led_controller_config_t *config)
+{
+    if (s_strip_count > 0) {
+        ESP_LOGW(TAG, "LED controller already initialized");
+        return ESP_OK;
+    }
+    return led_controller_add_strip(config, NULL);
+}
+
 esp_err_t led_controller_deinit(void)
 {
-    if (!s_led_state.initialized) {
+    if (s_strip_count == 0) {
         return ESP_OK;
     }
 
-    // Очищаем светодиоды перед выключением
+    // Очищаем светодиоды перед выключением; RMT читает буфер до конца кадра
     led_controller_clear();
-    
-    // Освобождаем ресурсы
-    if (s_led_state.led_strip_pixels) {
-        free(s_led_state.led_strip_pixels);
-        s_led_state.led_strip_pixels = NULL;
+    if (s_effect_task) {
+        // Под lock задача эффектов гарантированно не держит мьютекс
+        xSemaphoreTake(s_lock, portMAX_DELAY);
+        vTaskDelete(s_effect_task);
+        s_effect_task = NULL;
+        xSemaphoreGive(s_lock);
     }
+
+    for (int i = 0; i < s_strip_count; i++) {
+        struct led_controller *strip = &s_strips[i];
+        rmt_tx_wait_all_done(strip->led_chan, pdMS_TO_TICKS(LED_DEINIT_TIMEOUT_MS));
     
-    if (s_led_state.led_encoder) {
-        rmt_del_encoder(s_led_state.led_encoder);
-        s_led_state.led_encoder = NULL;
-    }
+        // Освобождаем ресурсы
+        free(strip->frame_buffers[0]);
+        free(strip->linear_pixels);
+        free(strip->dither_error);
     
-    if (s_led_state.led_chan) {
-        rmt_disable(s_led_state.led_chan);
-        rmt_del_channel(s_led_state.led_chan);
-        s_led_state.led_chan = NULL;
+        if (strip->led_encoder) {
+            rmt_del_encoder(strip->led_encoder);
+        }
+    
+        if (strip->led_chan) {
+            rmt_disable(strip->led_chan);
+            rmt_del_channel(strip->led_chan);
+        }
+        memset(strip, 0, sizeof(*strip));
     }
+    s_strip_count = 0;
 
-    s_led_state.initialized = false;
+    vSemaphoreDelete(s_lock);
+    s_lock = NULL;
     
     ESP_LOGI(TAG, "LED controller deinitialized");
     return ESP_OK;
 }
 
+led_controller_handle_t led_controller_get_strip(int index)
+{
+    return (index >= 0 && index < s_strip_count) ? &s_strips[index] : NULL;
+}
+
+int led_controller_get_strip_count(void)
+{
+    return s_strip_count;
+}
+
 esp_err_t led_controller_set_all_color(const led_rgb_t *color)
 {
-    if (!s_led_state.initialized || !color) {
+    if (s_strip_count == 0 || !color) {
         return ESP_ERR_INVALID_STATE;
     }
 
-    // Сохраняем текущий цвет
-    s_led_state.current_color = *color;
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    for (int i = 0; i < s_strip_count; i++) {
+        set_all_color_locked(&s_strips[i], color);
+    }
+    xSemaphoreGive(s_lock);
 
-    // Применяем яркость к цвету
-    uint8_t r = (color->r * s_led_state.brightness) / 255;
-    uint8_t g = (color->g * s_led_state.brightness) / 255;
-    uint8_t b = (color->b * s_led_state.brightness) / 255;
+    return ESP_OK;
+}
 
-    // Устанавливаем цвет для всех светодиодов (формат GRB)
-    for (int i = 0; i < s_led_state.led_count; i++) {
-        s_led_state.led_strip_pixels[i * 3 + 0] = g; // Green
-        s_led_state.led_strip_pixels[i * 3 + 1] = r; // Red
-        s_led_state.led_strip_pixels[i * 3 + 2] = b; // Blue
+esp_err_t led_controller_set_all_color16(const led_rgb16_t *color)
+{
+    if (s_strip_count == 0 || !color) {
+        return ESP_ERR_INVALID_STATE;
     }
 
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    for (int i = 0; i < s_strip_count; i++) {
+        set_all_color16_locked(&s_strips[i], color);
+    }
+    xSemaphoreGive(s_lock);
+
     return ESP_OK;
 }
 
 esp_err_t led_controller_set_color(int led_index, const led_rgb_t *color)
 {
-    if (!s_led_state.initialized || !color) {
+    if (s_strip_count == 0 || !color) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // Сквозной индекс: ленты идут одна за другой в порядке добавления
+    int index = led_index;
+    for (int i = 0; index >= 0 && i < s_strip_count; i++) {
+        if (index < s_strips[i].led_count) {
+            return led_controller_strip_set_color(&s_strips[i], index, color);
+        }
+        index -= s_strips[i].led_count;
+    }
+
+    ESP_LOGE(TAG, "Invalid LED index: %d", led_index);
+    return ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t led_controller_update(void)
+{
+    if (s_strip_count == 0) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // Кадры уходят по проводу асинхронно, ждать их окончания не нужно
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    for (int i = 0; i < s_strip_count; i++) {
+        render_locked(&s_strips[i]);
+    }
+    esp_err_t ret = flush_all_locked();
+    xSemaphoreGive(s_lock);
+    return ret;
+}
+
+void led_controller_task(void)
+{
+    bool pending = false;
+    for (int i = 0; i < s_strip_count; i++) {
+        pending |= s_strips[i].frame_pending && !atomic_load(&s_strips[i].in_flight);
+    }
+    if (!pending) {
+        return;
+    }
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    flush_all_locked();
+    xSemaphoreGive(s_lock);
+}
+
+bool led_controller_is_busy(void)
+{
+    for (int i = 0; i < s_strip_count; i++) {
+        if (atomic_load(&s_strips[i].in_flight) || s_strips[i].frame_pending) {
+            return true;
+        }
+    }
+    return false;
+}
+
+esp_err_t led_controller_clear(void)
+{
+    if (s_strip_count == 0) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    for (int i = 0; i < s_strip_count; i++) {
+        clear_locked(&s_strips[i]);
+    }
+    esp_err_t ret = flush_all_locked();
+    xSemaphoreGive(s_lock);
+    return ret;
+}
+
+esp_err_t led_controller_set_brightness(uint8_t brightness)
+{
+    if (s_strip_count == 0) {
         return ESP_ERR_INVALID_STATE;
     }
+
+    // Яркость применяется при переводе линейного кадра в байты ленты,
+    // поэтому кадр (статический или эффекта) просто перерисовывается
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    for (int i = 0; i < s_strip_count; i++) {
+        s_strips[i].brightness = brightness;
+        render_locked(&s_strips[i]);
+    }
+    esp_err_t ret = flush_all_locked();
+    xSemaphoreGive(s_lock);
     
-    if (led_index < 0 || led_index >= s_led_state.led_count) {
-        ESP_LOGE(TAG, "Invalid LED index: %d", led_index);
+    ESP_LOGI(TAG, "Brightness set to %d", brightness);
+    return ret;
+}
+
+esp_err_t led_controller_set_effect(const led_effect_t *effect)
+{
+    if (s_strip_count == 0 || !effect) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (effect->zone_count > LED_EFFECT_MAX_ZONES) {
         return ESP_ERR_INVALID_ARG;
     }
 
-    // Применяем яркость к цвету
-    uint8_t r = (color->r * s_led_state.brightness) / 255;
-    uint8_t g = (color->g * s_led_state.brightness) / 255;
-    uint8_t b = (color->b * s_led_state.brightness) / 255;
-
-    // Устанавливаем цвет для конкретного светодиода (формат GRB)
-    s_led_state.led_strip_pixels[led_index * 3 + 0] = g; // Green
-    s_led_state.led_strip_pixels[led_index * 3 + 1] = r; // Red
-    s_led_state.led_strip_pixels[led_index * 3 + 2] = b; // Blue
+    // Общий момент старта: эффекты лент идут синхронно
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    TickType_t now = xTaskGetTickCount();
+    for (int i = 0; i < s_strip_count; i++) {
+        start_effect_locked(&s_strips[i], effect, now);
+    }
+    xTaskNotifyGive(s_effect_task);
+    xSemaphoreGive(s_lock);
 
+    ESP_LOGI(TAG, "LED effect %d started", (int)effect->type);
     return ESP_OK;
 }
 
-esp_err_t led_controller_update(void)
+esp_err_t led_controller_apply(const led_controller_change_t *change)
 {
-    if (!s_led_state.initialized) {
+    if (s_strip_count == 0 || !change) {
         return ESP_ERR_INVALID_STATE;
     }
+    if (change->content == LED_CHANGE_EFFECT && change->effect.zone_count > LED_EFFECT_MAX_ZONES) {
+        return ESP_ERR_INVALID_ARG;
+    }
 
-    rmt_transmit_config_t tx_config = {
-        .loop_count = 0, // no transfer loop
-    };
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    TickType_t now = xTaskGetTickCount();
+    for (int i = 0; i < s_strip_count; i++) {
+        struct led_controller *strip = &s_strips[i];
+        if (change->set_brightness) {
+            strip->brightness = change->brightness;
+        }
+        switch (change->content) {
+        case LED_CHANGE_COLOR:
+            set_all_color_locked(strip, &change->color);
+            break;
+        case LED_CHANGE_EFFECT:
+            start_effect_locked(strip, &change->effect, now);
+            break;
+        case LED_CHANGE_CLEAR:
+            clear_locked(strip);
+            break;
+        default:
+            break;
+        }
+        // clear_locked уже перерисовал кадр, а кадр эффекта нарисует
+        // задача эффектов уже с новой яркостью
+        if (change->content != LED_CHANGE_CLEAR && !strip->effect_running) {
+            render_locked(strip);
+        }
+    }
+    if (change->content == LED_CHANGE_EFFECT) {
+        xTaskNotifyGive(s_effect_task);
+    }
+    esp_err_t ret = flush_all_locked();
+    xSemaphoreGive(s_lock);
+    return ret;
+}
 
-    esp_err_t ret = rmt_transmit(s_led_state.led_chan, s_led_state.led_encoder, 
-                                 s_led_state.led_strip_pixels, 
-                                 s_led_state.led_count * 3, &tx_config);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to transmit LED data: %s", esp_err_to_name(ret));
-        return ret;
+int led_controller_get_led_count(void)
+{
+    if (s_strip_count == 0) {
+        return -1;
+    }
+    int total = 0;
+    for (int i = 0; i < s_strip_count; i++) {
+        total += s_strips[i].led_count;
     }
+    return total;
+}
 
-    ret = rmt_tx_wait_all_done(s_led_state.led_chan, portMAX_DELAY);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to wait for transmission: %s", esp_err_to_name(ret));
-        return ret;
+esp_err_t led_controller_strip_set_all_color(led_controller_handle_t strip, const led_rgb_t *color)
+{
+    if (!is_strip(strip) || !color) {
+        return ESP_ERR_INVALID_STATE;
     }
 
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    set_all_color_locked(strip, color);
+    xSemaphoreGive(s_lock);
     return ESP_OK;
 }
 
-esp_err_t led_controller_clear(void)
+esp_err_t led_controller_strip_set_all_color16(led_controller_handle_t strip, const led_rgb16_t *color)
 {
-    if (!s_led_state.initialized) {
+    if (!is_strip(strip) || !color) {
         return ESP_ERR_INVALID_STATE;
     }
 
-    memset(s_led_state.led_strip_pixels, 0, s_led_state.led_count * 3);
-    return led_controller_update();
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    set_all_color16_locked(strip, color);
+    xSemaphoreGive(s_lock);
+    return ESP_OK;
 }
 
-esp_err_t led_controller_set_brightness(uint8_t brightness)
+esp_err_t led_controller_strip_set_color(led_controller_handle_t strip, int led_index, const led_rgb_t *color)
 {
-    if (!s_led_state.initialized) {
+    if (!is_strip(strip) || !color) {
         return ESP_ERR_INVALID_STATE;
     }
-
-    s_led_state.brightness = brightness;
-    ESP_LOGI(TAG, "Brightness set to %d", brightness);
     
-    // Переприменяем текущий цвет с новой яркостью
-    return led_controller_set_all_color(&s_led_state.current_color);
+    if (led_index < 0 || led_index >= strip->led_count) {
+        ESP_LOGE(TAG, "Invalid LED index: %d", led_index);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // Устанавливаем цвет для конкретного светодиода
+    led_rgb16_t linear = to_linear(color);
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    stop_effect_locked(strip);
+    set_linear_locked(strip, led_index, &linear);
+    xSemaphoreGive(s_lock);
+
+    return ESP_OK;
 }
 
-int led_controller_get_led_count(void)
+esp_err_t led_controller_strip_set_brightness(led_controller_handle_t strip, uint8_t brightness)
+{
+    if (!is_strip(strip)) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    strip->brightness = brightness;
+    render_locked(strip);
+    esp_err_t ret = flush_frame_locked(strip);
+    xSemaphoreGive(s_lock);
+    return ret;
+}
+
+esp_err_t led_controller_strip_set_effect(led_controller_handle_t strip, const led_effect_t *effect)
+{
+    if (!is_strip(strip) || !effect) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (effect->zone_count > LED_EFFECT_MAX_ZONES) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    start_effect_locked(strip, effect, xTaskGetTickCount());
+    xTaskNotifyGive(s_effect_task);
+    xSemaphoreGive(s_lock);
+    return ESP_OK;
+}
+
+esp_err_t led_controller_strip_clear(led_controller_handle_t strip)
+{
+    if (!is_strip(strip)) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    clear_locked(strip);
+    esp_err_t ret = flush_frame_locked(strip);
+    xSemaphoreGive(s_lock);
+    return ret;
+}
+
+int led_controller_strip_get_led_count(led_controller_handle_t strip)
+{
+    return is_strip(strip) ? strip->led_count : -1;
+}
+
+esp_err_t led_controller_get_frame_budget(led_frame_budget_t *budget)
 {
-    return s_led_state.initialized ? s_led_state.led_count : -1;
-}
\ No newline at end of file
+    if (!budget) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    memset(budget, 0, sizeof(*budget));
+    budget->strip_count = s_strip_count;
+    budget->frame_period_us = 1000000 / LED_EFFECT_FPS;
+    for (int i = 0; i < s_strip_count; i++) {
+        uint32_t wire_us = strip_wire_us(s_strips[i].led_count);
+        uint32_t measured_us = atomic_load(&s_strips[i].wire_us);
+        budget->led_count += s_strips[i].led_count;
+        budget->serial_wire_us += wire_us;
+        if (wire_us > budget->wire_us) {
+            budget->wire_us = wire_us;
+        }
+        if (measured_us > budget->measured_us) {
+            budget->measured_us = measured_us;
+        }
+    }
+    return ESP_OK;
+}
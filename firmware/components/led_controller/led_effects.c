@@ -0,0 +1,156 @@
+#include "led_effects.h"
+#include <math.h>
+
+#define LED_EFFECT_PI 3.14159265f
+
+// Цвет чёрного тела через каждые 1000 K, от 1000 до 10000 K
+static const led_rgb_t s_kelvin_table[] = {
+    {255,  56,   0}, {255, 137,  14}, {255, 180, 107}, {255, 209, 163}, {255, 228, 206},
+    {255, 243, 239}, {245, 243, 255}, {227, 233, 255}, {214, 225, 255}, {204, 219, 255},
+};
+
+#define KELVIN_TABLE_MIN  1000u
+#define KELVIN_TABLE_STEP 1000u
+#define KELVIN_TABLE_LEN  (sizeof(s_kelvin_table) / sizeof(s_kelvin_table[0]))
+
+/**
+ * @brief Линейное смешивание цветов, t в 1/256
+ */
+static led_rgb_t blend(led_rgb_t a, led_rgb_t b, uint32_t t)
+{
+    led_rgb_t out = {
+        .r = (uint8_t)(a.r + (((int32_t)b.r - a.r) * (int32_t)t) / 256),
+        .g = (uint8_t)(a.g + (((int32_t)b.g - a.g) * (int32_t)t) / 256),
+        .b = (uint8_t)(a.b + (((int32_t)b.b - a.b) * (int32_t)t) / 256),
+    };
+    return out;
+}
+
+static led_rgb_t scale(led_rgb_t color, uint32_t level)
+{
+    led_rgb_t black = {0, 0, 0};
+    return blend(black, color, level);
+}
+
+static void fill(led_rgb_t *pixels, int count, led_rgb_t color)
+{
+    for (int i = 0; i < count; i++) {
+        pixels[i] = color;
+    }
+}
+
+/**
+ * @brief Доля перехода в 1/256 и признак его продолжения
+ */
+static bool transition_progress(uint32_t elapsed_ms, uint32_t duration_ms, uint32_t *t)
+{
+    if (duration_ms == 0 || elapsed_ms >= duration_ms) {
+        *t = 256;
+        return false;
+    }
+    *t = (uint32_t)(((uint64_t)elapsed_ms * 256) / duration_ms);
+    return true;
+}
+
+void led_effect_kelvin_to_rgb(uint32_t kelvin, led_rgb_t *color)
+{
+    uint32_t max_kelvin = KELVIN_TABLE_MIN + (KELVIN_TABLE_LEN - 1) * KELVIN_TABLE_STEP;
+    if (kelvin < KELVIN_TABLE_MIN) kelvin = KELVIN_TABLE_MIN;
+    if (kelvin > max_kelvin) kelvin = max_kelvin;
+
+    uint32_t index = (kelvin - KELVIN_TABLE_MIN) / KELVIN_TABLE_STEP;
+    if (index >= KELVIN_TABLE_LEN - 1) {
+        *color = s_kelvin_table[KELVIN_TABLE_LEN - 1];
+        return;
+    }
+    uint32_t t = ((kelvin - KELVIN_TABLE_MIN) % KELVIN_TABLE_STEP) * 256 / KELVIN_TABLE_STEP;
+    *color = blend(s_kelvin_table[index], s_kelvin_table[index + 1], t);
+}
+
+/**
+ * @brief Бегущий отрезок с дробным положением: крайние светодиоды
+ *        отрезка подсвечиваются частично, поэтому движение без рывков
+ */
+static void render_chase(const led_effect_t *effect, uint32_t elapsed_ms, led_rgb_t *pixels, int count)
+{
+    uint32_t period = effect->period_ms > 0 ? effect->period_ms : 1;
+    float head = (float)(elapsed_ms % period) * count / period;
+    float tail = head + (effect->width > 0 ? effect->width : 1);
+
+    for (int i = 0; i < count; i++) {
+        // Покрытие ячейки светодиода отрезком [head, tail) на кольце длиной count
+        float coverage = 0.0f;
+        for (int wrap = 0; wrap <= 1; wrap++) {
+            float cell = (float)(i + wrap * count);
+            float overlap = fminf(cell + 1.0f, tail) - fmaxf(cell, head);
+            if (overlap > 0.0f) {
+                coverage += overlap;
+            }
+        }
+        if (coverage > 1.0f) coverage = 1.0f;
+        pixels[i] = blend(effect->from, effect->color, (uint32_t)lroundf(coverage * 256.0f));
+    }
+}
+
+static void render_gradient(const led_effect_t *effect, led_rgb_t *pixels, int count)
+{
+    led_rgb_t black = {0, 0, 0};
+    fill(pixels, count, black);
+
+    for (int z = 0; z < effect->zone_count && z < LED_EFFECT_MAX_ZONES; z++) {
+        const led_effect_zone_t *zone = &effect->zones[z];
+        int first = zone->first;
+        int last = zone->last < count ? zone->last : count - 1;
+        int span = last - first;
+        for (int i = first; i <= last; i++) {
+            uint32_t t = span > 0 ? (uint32_t)((i - first) * 256 / span) : 0;
+            pixels[i] = blend(zone->from, zone->to, t);
+        }
+    }
+}
+
+bool led_effect_render(const led_effect_t *effect, uint32_t elapsed_ms, led_rgb_t *pixels, int count)
+{
+    uint32_t t;
+    bool running;
+
+    switch (effect->type) {
+    case LED_EFFECT_FADE:
+        running = transition_progress(elapsed_ms, effect->duration_ms, &t);
+        fill(pixels, count, blend(effect->from, effect->color, t));
+        return running;
+
+    case LED_EFFECT_BREATHE: {
+        uint32_t period = effect->period_ms > 0 ? effect->period_ms : 1;
+        float phase = 2.0f * LED_EFFECT_PI * (float)(elapsed_ms % period) / period;
+        // Косинус начинается с минимума, поэтому эффект стартует без скачка вверх
+        float wave = (1.0f - cosf(phase)) * 0.5f;
+        uint32_t level = effect->min_level + (uint32_t)lroundf(wave * (256 - effect->min_level));
+        fill(pixels, count, scale(effect->color, level));
+        return true;
+    }
+
+    case LED_EFFECT_CHASE:
+        render_chase(effect, elapsed_ms, pixels, count);
+        return true;
+
+    case LED_EFFECT_COLOR_TEMP: {
+        // Интенсивность задаёт общая яркость ленты, здесь только оттенок
+        running = transition_progress(elapsed_ms, effect->duration_ms, &t);
+        int32_t delta = (int32_t)effect->kelvin_to - (int32_t)effect->kelvin_from;
+        led_rgb_t color;
+        led_effect_kelvin_to_rgb((uint32_t)((int32_t)effect->kelvin_from + delta * (int32_t)t / 256), &color);
+        fill(pixels, count, color);
+        return running;
+    }
+
+    case LED_EFFECT_GRADIENT:
+        render_gradient(effect, pixels, count);
+        return false;
+
+    case LED_EFFECT_NONE:
+    default:
+        fill(pixels, count, effect->color);
+        return false;
+    }
+}
@@ -0,0 +1,127 @@
+#include "led_pipeline.h"
+
+// Таблицы сгенерированы заранее (см. формулы в led_pipeline.h) и лежат во flash
+const uint16_t led_gamma_lut[LED_GAMMA_LUT_SIZE] = {
+        0,     0,     0,     1,     1,     2,     4,     6,
+        8,    11,    14,    18,    23,    29,    35,    41,
+       49,    57,    67,    77,    88,    99,   112,   126,
+      141,   156,   173,   191,   210,   230,   251,   274,
+      297,   322,   348,   375,   404,   433,   464,   497,
+      531,   566,   602,   640,   680,   721,   763,   807,
+      853,   899,   948,   998,  1050,  1103,  1158,  1215,
+     1273,  1333,  1394,  1458,  1523,  1590,  1658,  1729,
+     1801,  1875,  1951,  2029,  2109,  2190,  2274,  2359,
+     2446,  2536,  2627,  2720,  2816,  2913,  3012,  3114,
+     3217,  3323,  3431,  3541,  3653,  3767,  3883,  4001,
+     4122,  4245,  4370,  4498,  4627,  4759,  4893,  5030,
+     5169,  5310,  5453,  5599,  5747,  5898,  6051,  6206,
+     6364,  6525,  6688,  6853,  7021,  7191,  7364,  7539,
+     7717,  7897,  8080,  8266,  8454,  8645,  8838,  9034,
+     9233,  9434,  9638,  9845, 10055, 10267, 10482, 10699,
+    10920, 11143, 11369, 11598, 11829, 12064, 12301, 12541,
+    12784, 13030, 13279, 13530, 13785, 14042, 14303, 14566,
+    14832, 15102, 15374, 15649, 15928, 16209, 16493, 16781,
+    17071, 17365, 17661, 17961, 18264, 18570, 18879, 19191,
+    19507, 19825, 20147, 20472, 20800, 21131, 21466, 21804,
+    22145, 22489, 22837, 23188, 23542, 23899, 24260, 24625,
+    24992, 25363, 25737, 26115, 26496, 26880, 27268, 27659,
+    28054, 28452, 28854, 29259, 29667, 30079, 30495, 30914,
+    31337, 31763, 32192, 32626, 33062, 33503, 33947, 34394,
+    34846, 35300, 35759, 36221, 36687, 37156, 37629, 38106,
+    38586, 39071, 39558, 40050, 40545, 41045, 41547, 42054,
+    42565, 43079, 43597, 44119, 44644, 45174, 45707, 46245,
+    46786, 47331, 47880, 48432, 48989, 49550, 50114, 50683,
+    51255, 51832, 52412, 52996, 53585, 54177, 54773, 55374,
+    55978, 56587, 57199, 57816, 58436, 59061, 59690, 60323,
+    60960, 61601, 62246, 62896, 63549, 64207, 64869, 65535,
+};
+
+const uint16_t led_brightness_lut[LED_GAMMA_LUT_SIZE] = {
+        0,     1,     4,     9,    16,    25,    36,    49,
+       65,    82,   101,   122,   145,   170,   198,   227,
+      258,   291,   327,   364,   403,   444,   488,   533,
+      581,   630,   681,   735,   790,   848,   907,   969,
+     1032,  1098,  1165,  1235,  1306,  1380,  1455,  1533,
+     1613,  1694,  1778,  1864,  1951,  2041,  2133,  2226,
+     2322,  2420,  2520,  2621,  2725,  2831,  2939,  3049,
+     3161,  3274,  3390,  3508,  3628,  3750,  3874,  4000,
+     4128,  4258,  4390,  4524,  4660,  4798,  4938,  5081,
+     5225,  5371,  5519,  5669,  5821,  5976,  6132,  6290,
+     6450,  6612,  6777,  6943,  7111,  7282,  7454,  7628,
+     7805,  7983,  8164,  8346,  8530,  8717,  8905,  9096,
+     9288,  9483,  9679,  9878, 10078, 10281, 10486, 10692,
+    10901, 11111, 11324, 11539, 11755, 11974, 12195, 12418,
+    12642, 12869, 13098, 13329, 13562, 13796, 14033, 14272,
+    14513, 14756, 15001, 15248, 15497, 15748, 16001, 16256,
+    16513, 16772, 17033, 17296, 17561, 17828, 18097, 18368,
+    18641, 18916, 19193, 19473, 19754, 20037, 20322, 20609,
+    20899, 21190, 21483, 21778, 22076, 22375, 22676, 22980,
+    23285, 23593, 23902, 24213, 24527, 24842, 25160, 25479,
+    25801, 26124, 26450, 26777, 27107, 27439, 27772, 28108,
+    28445, 28785, 29127, 29470, 29816, 30164, 30513, 30865,
+    31219, 31575, 31933, 32292, 32654, 33018, 33384, 33752,
+    34122, 34493, 34867, 35243, 35621, 36001, 36383, 36767,
+    37153, 37541, 37931, 38323, 38717, 39113, 39511, 39912,
+    40314, 40718, 41124, 41532, 41942, 42355, 42769, 43185,
+    43603, 44024, 44446, 44870, 45297, 45725, 46155, 46588,
+    47022, 47458, 47897, 48337, 48780, 49224, 49671, 50119,
+    50570, 51022, 51477, 51933, 52392, 52852, 53315, 53780,
+    54246, 54715, 55185, 55658, 56133, 56610, 57088, 57569,
+    58052, 58537, 59023, 59512, 60003, 60496, 60991, 61488,
+    61986, 62487, 62990, 63495, 64002, 64511, 65022, 65535,
+};
+
+uint8_t led_gamma_inverse(uint16_t linear)
+{
+    // Таблица монотонна: первый элемент не меньше linear, затем ближайший из соседей
+    unsigned lo = 0;
+    unsigned hi = LED_GAMMA_LUT_SIZE - 1;
+    while (lo < hi) {
+        unsigned mid = (lo + hi) / 2;
+        if (led_gamma_lut[mid] < linear) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo > 0 && linear - led_gamma_lut[lo - 1] < led_gamma_lut[lo] - linear) {
+        lo--;
+    }
+    return (uint8_t)lo;
+}
+
+bool led_pipeline_render(const uint16_t *linear, uint8_t *out, uint8_t *error,
+                         size_t subpixels, uint16_t scale, bool dither)
+{
+    uint32_t fraction = 0;
+
+    if (!dither) {
+        for (size_t i = 0; i < subpixels; i++) {
+            uint32_t value = ((uint32_t)linear[i] * scale) >> 16;
+            fraction |= value & 0xFF;
+            out[i] = (uint8_t)(value >> 8);
+        }
+        return fraction != 0;
+    }
+
+    for (size_t i = 0; i < subpixels; i++) {
+        // 16 бит света + остаток прошлых кадров; старший байт уходит на ленту,
+        // младший копится, пока не перевалит за целый шаг
+        uint32_t scaled = ((uint32_t)linear[i] * scale) >> 16;
+        uint32_t value = scaled + error[i];
+        fraction |= scaled & 0xFF;
+        if (value > 0xFFFF) {
+            value = 0xFFFF;
+        }
+        out[i] = (uint8_t)(value >> 8);
+        error[i] = (uint8_t)value;
+    }
+    return fraction != 0;
+}
+
+bool led_pipeline_update_refresh(bool *refresh, bool fractional, bool dither)
+{
+    bool was_refreshing = *refresh;
+    *refresh = fractional && dither;
+    return *refresh && !was_refreshing;
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Кооперативный планировщик периодических заданий. Каждый планировщик —
+ * одна задача FreeRTOS: из созревших заданий первым выполняется задание
+ * с большим приоритетом, при равных — с более ранним сроком. Задание не
+ * вытесняется, поэтому блокирующая работа (сеть) выносится в отдельный
+ * планировщик с более низким приоритетом задачи.
+ */
+
+#define SCHEDULER_MAX_SCHEDULERS 2
+#define SCHEDULER_MAX_JOBS 8             ///< Заданий на один планировщик
+#define SCHEDULER_HISTOGRAM_BUCKETS 8    ///< Корзина i: время выполнения < 64 * 4^i мкс, последняя — всё остальное
+
+/**
+ * @brief Функция задания
+ */
+typedef void (*scheduler_job_fn_t)(void *arg);
+
+/**
+ * @brief Дескриптор планировщика
+ */
+typedef struct scheduler *scheduler_handle_t;
+
+/**
+ * @brief Конфигурация планировщика (задачи FreeRTOS)
+ */
+typedef struct {
+    const char *name;
+    uint32_t stack_size;
+    int task_priority;
+} scheduler_config_t;
+
+/**
+ * @brief Конфигурация задания
+ */
+typedef struct {
+    const char *name;
+    scheduler_job_fn_t fn;
+    void *arg;
+    uint32_t period_ms;
+    uint32_t deadline_ms;   ///< Срок от момента выпуска; 0 — равен периоду
+    uint8_t priority;       ///< Больше — важнее
+} scheduler_job_config_t;
+
+/**
+ * @brief Статистика задания
+ */
+typedef struct {
+    const char *name;
+    const char *scheduler;
+    uint32_t period_ms;
+    uint32_t deadline_ms;
+    uint8_t priority;
+    uint32_t runs;
+    uint32_t misses;            ///< Выполнений, закончившихся после срока
+    uint32_t skipped;           ///< Выпусков, пропущенных целиком из-за опоздания больше периода
+    uint32_t last_us;
+    uint32_t max_us;
+    uint64_t total_us;
+    uint32_t max_latency_us;    ///< Наибольшая задержка старта от момента выпуска
+    uint32_t histogram[SCHEDULER_HISTOGRAM_BUCKETS];
+} scheduler_job_stats_t;
+
+/**
+ * @brief Создать планировщик; задача запускается scheduler_start
+ * 
+ * @param config Конфигурация
+ * @param out_handle Дескриптор планировщика
+ * @return ESP_OK в случае успеха
+ */
+esp_err_t scheduler_create(const scheduler_config_t *config, scheduler_handle_t *out_handle);
+
+/**
+ * @brief Добавить задание (до scheduler_start)
+ *
+ * Первый выпуск — сразу после запуска планировщика.
+ * 
+ * @param scheduler Дескриптор планировщика
+ * @param job Конфигурация задания
+ * @return ESP_OK в случае успеха
+ */
+esp_err_t scheduler_add_job(scheduler_handle_t scheduler, const scheduler_job_config_t *job);
+
+/**
+ * @brief Запустить задачу планировщика
+ * 
+ * @param scheduler Дескриптор планировщика
+ * @return ESP_OK в случае успеха
+ */
+esp_err_t scheduler_start(scheduler_handle_t scheduler);
+
+/**
+ * @brief Получить количество заданий во всех планировщиках
+ */
+int scheduler_get_job_count(void);
+
+/**
+ * @brief Получить статистику задания
+ * 
+ * @param index Сквозной номер задания по всем планировщикам
+ * @param stats Результат
+ * @return ESP_OK в случае успеха, ESP_ERR_INVALID_ARG для неверного номера
+ */
+esp_err_t scheduler_get_job_stats(int index, scheduler_job_stats_t *stats);
+
+/**
+ * @brief Верхняя граница корзины гистограммы, мкс (0 для последней корзины)
+ */
+uint32_t scheduler_histogram_bucket_us(int bucket);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,237 @@
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "scheduler.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+static const char *TAG = "scheduler";
+
+#define SCHEDULER_HISTOGRAM_FIRST_US 64
+
+typedef struct {
+    scheduler_job_config_t config;
+    int64_t release_us;     // Момент текущего (ещё не выполненного) выпуска
+    scheduler_job_stats_t stats;
+} scheduler_job_t;
+
+struct scheduler {
+    scheduler_config_t config;
+    scheduler_job_t jobs[SCHEDULER_MAX_JOBS];
+    int job_count;
+    TaskHandle_t task;
+    portMUX_TYPE stats_lock;    // Статистику читает httpd на другом ядре, total_us 64-битный
+};
+
+static struct scheduler s_schedulers[SCHEDULER_MAX_SCHEDULERS];
+static int s_scheduler_count = 0;
+
+uint32_t scheduler_histogram_bucket_us(int bucket)
+{
+    if (bucket < 0 || bucket >= SCHEDULER_HISTOGRAM_BUCKETS - 1) {
+        return 0;
+    }
+    return (uint32_t)SCHEDULER_HISTOGRAM_FIRST_US << (2 * bucket);
+}
+
+static int histogram_bucket(uint32_t elapsed_us)
+{
+    int bucket = 0;
+    while (bucket < SCHEDULER_HISTOGRAM_BUCKETS - 1 && elapsed_us >= scheduler_histogram_bucket_us(bucket)) {
+        bucket++;
+    }
+    return bucket;
+}
+
+/**
+ * @brief Выбрать созревшее задание: больший приоритет, затем ранний срок
+ */
+static scheduler_job_t *pick_job(struct scheduler *sched, int64_t now_us)
+{
+    scheduler_job_t *best = NULL;
+    int64_t best_deadline = 0;
+
+    for (int i = 0; i < sched->job_count; i++) {
+        scheduler_job_t *job = &sched->jobs[i];
+        if (job->release_us > now_us) {
+            continue;
+        }
+        int64_t deadline = job->release_us + (int64_t)job->config.deadline_ms * 1000;
+        if (!best || job->config.priority > best->config.priority ||
+            (job->config.priority == best->config.priority && deadline < best_deadline)) {
+            best = job;
+            best_deadline = deadline;
+        }
+    }
+    return best;
+}
+
+/**
+ * @brief Выполнить задание и учесть время, срок и следующий выпуск
+ */
+static void run_job(struct scheduler *sched, scheduler_job_t *job)
+{
+    int64_t started_us = esp_timer_get_time();
+    job->config.fn(job->config.arg);
+    int64_t finished_us = esp_timer_get_time();
+
+    uint32_t elapsed_us = (uint32_t)(finished_us - started_us);
+    uint32_t latency_us = (uint32_t)(started_us - job->release_us);
+    int64_t period_us = (int64_t)job->config.period_ms * 1000;
+    scheduler_job_stats_t *stats = &job->stats;
+    bool missed = finished_us > job->release_us + (int64_t)job->config.deadline_ms * 1000;
+
+    // Выпуски держат фазу; опоздание больше периода не догоняется пачкой
+    uint32_t skipped = 0;
+    job->release_us += period_us;
+    if (job->release_us <= finished_us) {
+        int64_t behind = (finished_us - job->release_us) / period_us + 1;
+        skipped = (uint32_t)behind;
+        job->release_us += behind * period_us;
+    }
+
+    portENTER_CRITICAL(&sched->stats_lock);
+    stats->runs++;
+    stats->last_us = elapsed_us;
+    stats->total_us += elapsed_us;
+    if (elapsed_us > stats->max_us) {
+        stats->max_us = elapsed_us;
+    }
+    if (latency_us > stats->max_latency_us) {
+        stats->max_latency_us = latency_us;
+    }
+    stats->histogram[histogram_bucket(elapsed_us)]++;
+    if (missed) {
+        stats->misses++;
+    }
+    stats->skipped += skipped;
+    portEXIT_CRITICAL(&sched->stats_lock);
+}
+
+static void scheduler_task(void *arg)
+{
+    struct scheduler *sched = arg;
+
+    ESP_LOGI(TAG, "Scheduler %s started with %d jobs", sched->config.name, sched->job_count);
+
+    int64_t now_us = esp_timer_get_time();
+    for (int i = 0; i < sched->job_count; i++) {
+        sched->jobs[i].release_us = now_us;
+    }
+
+    while (1) {
+        now_us = esp_timer_get_time();
+        scheduler_job_t *job = pick_job(sched, now_us);
+        if (job) {
+            run_job(sched, job);
+            continue;
+        }
+
+        // Спим до ближайшего выпуска с точностью тика
+        int64_t next_us = INT64_MAX;
+        for (int i = 0; i < sched->job_count; i++) {
+            if (sched->jobs[i].release_us < next_us) {
+                next_us = sched->jobs[i].release_us;
+            }
+        }
+        TickType_t ticks = pdMS_TO_TICKS((uint32_t)((next_us - now_us + 999) / 1000));
+        vTaskDelay(ticks > 0 ? ticks : 1);
+    }
+}
+
+esp_err_t scheduler_create(const scheduler_config_t *config, scheduler_handle_t *out_handle)
+{
+    if (!config || !config->name || !out_handle) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_scheduler_count >= SCHEDULER_MAX_SCHEDULERS) {
+        ESP_LOGE(TAG, "No free scheduler slots (max %d)", SCHEDULER_MAX_SCHEDULERS);
+        return ESP_ERR_NO_MEM;
+    }
+
+    struct scheduler *sched = &s_schedulers[s_scheduler_count];
+    memset(sched, 0, sizeof(*sched));
+    sched->config = *config;
+    portMUX_INITIALIZE(&sched->stats_lock);
+    s_scheduler_count++;
+
+    *out_handle = sched;
+    return ESP_OK;
+}
+
+esp_err_t scheduler_add_job(scheduler_handle_t scheduler, const scheduler_job_config_t *job)
+{
+    if (!scheduler || !job || !job->fn || job->period_ms == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (scheduler->task) {
+        // Задача планировщика читает список заданий без блокировки
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (scheduler->job_count >= SCHEDULER_MAX_JOBS) {
+        ESP_LOGE(TAG, "Scheduler %s is full", scheduler->config.name);
+        return ESP_ERR_NO_MEM;
+    }
+
+    scheduler_job_t *slot = &scheduler->jobs[scheduler->job_count];
+    memset(slot, 0, sizeof(*slot));
+    slot->config = *job;
+    if (slot->config.deadline_ms == 0) {
+        slot->config.deadline_ms = job->period_ms;
+    }
+    slot->stats.name = job->name;
+    slot->stats.scheduler = scheduler->config.name;
+    slot->stats.period_ms = job->period_ms;
+    slot->stats.deadline_ms = slot->config.deadline_ms;
+    slot->stats.priority = job->priority;
+    scheduler->job_count++;
+
+    ESP_LOGI(TAG, "Job %s/%s: period %u ms, deadline %u ms, priority %u", scheduler->config.name,
+             job->name, (unsigned)job->period_ms, (unsigned)slot->config.deadline_ms, (unsigned)job->priority);
+    return ESP_OK;
+}
+
+esp_err_t scheduler_start(scheduler_handle_t scheduler)
+{
+    if (!scheduler) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (scheduler->task) {
+        return ESP_OK;
+    }
+
+    if (xTaskCreate(scheduler_task, scheduler->config.name, scheduler->config.stack_size, scheduler,
+                    scheduler->config.task_priority, &scheduler->task) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create scheduler task %s", scheduler->config.name);
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+int scheduler_get_job_count(void)
+{
+    int count = 0;
+    for (int i = 0; i < s_scheduler_count; i++) {
+        count += s_schedulers[i].job_count;
+    }
+    return count;
+}
+
+esp_err_t scheduler_get_job_stats(int index, scheduler_job_stats_t *stats)
+{
+    if (!stats || index < 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    for (int i = 0; i < s_scheduler_count; i++) {
+        if (index < s_schedulers[i].job_count) {
+            // Копия под той же блокировкой, что и обновление: без рваных 64-битных полей
+            portENTER_CRITICAL(&s_schedulers[i].stats_lock);
+            *stats = s_schedulers[i].jobs[index].stats;
+            portEXIT_CRITICAL(&s_schedulers[i].stats_lock);
+            return ESP_OK;
+        }
+        index -= s_schedulers[i].job_count;
+    }
+    return ESP_ERR_INVALID_ARG;
+}
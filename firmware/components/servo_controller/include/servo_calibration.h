@@ -0,0 +1,63 @@
+#pragma once
+
+#include "config_storage.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Отображение угла в ширину импульса по калибровочной таблице
+ * (servo_calibration_t из config_storage). Между точками — линейная
+ * интерполяция, за крайними точками импульс не выходит: таблица задаёт
+ * рабочий диапазон конкретного экземпляра сервопривода. Импульсы могут
+ * убывать с ростом угла (сервопривод установлен зеркально). Модуль не
+ * зависит от ESP-IDF и собирается на хосте.
+ */
+
+#define SERVO_CALIBRATION_DEFAULT_MIN_US  800    ///< Импульс 0° без калибровки
+#define SERVO_CALIBRATION_DEFAULT_MAX_US  2500   ///< Импульс 180° без калибровки
+#define SERVO_CALIBRATION_PULSE_MIN_US    400    ///< Допустимый диапазон импульсов
+#define SERVO_CALIBRATION_PULSE_MAX_US    2700
+
+/**
+ * @brief Таблица по умолчанию: 0..180° -> 800..2500 мкс
+ */
+void servo_calibration_default(servo_calibration_t *cal);
+
+/**
+ * @brief Таблица из двух крайних точек
+ */
+void servo_calibration_linear(servo_calibration_t *cal, int32_t min_cdeg, uint16_t min_pulse_us,
+                              int32_t max_cdeg, uint16_t max_pulse_us);
+
+/**
+ * @brief Проверить таблицу: 2..MAX точек, углы строго возрастают, импульсы
+ *        в допустимом диапазоне и строго монотонны
+ */
+bool servo_calibration_is_valid(const servo_calibration_t *cal);
+
+/**
+ * @brief Добавить или заменить точку, сохраняя порядок углов
+ * @return false, если таблица заполнена или аргументы вне диапазона
+ */
+bool servo_calibration_set_point(servo_calibration_t *cal, int32_t angle_cdeg, uint16_t pulse_us);
+
+/**
+ * @brief Ширина импульса для угла
+ * @param angle_cdeg Угол в сотых градуса, за пределами таблицы — крайняя точка
+ * @return Импульс в мкс (дробный, чтобы не терять разрешение LEDC)
+ */
+float servo_calibration_pulse_us(const servo_calibration_t *cal, int32_t angle_cdeg);
+
+/**
+ * @brief Обратное отображение: угол для ширины импульса
+ * @return Угол в сотых градуса, за пределами таблицы — крайняя точка
+ */
+int32_t servo_calibration_angle_cdeg(const servo_calibration_t *cal, float pulse_us);
+
+#ifdef __cplusplus
+}
+#endif
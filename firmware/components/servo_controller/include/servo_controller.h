@@ -3,11 +3,23 @@
 #include "esp_err.h"
 #include "config_storage.h"
 #include <stdbool.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/**
+ * @brief Счётчики записи duty в LEDC (из задания servo)
+ */
+typedef struct {
+    uint32_t writes;        ///< Записей duty
+    uint32_t errors;        ///< Из них неудачных
+    uint32_t last_us;       ///< Длительность последней записи
+    uint32_t max_us;        ///< Максимальная длительность записи
+    uint64_t total_us;      ///< Суммарная длительность, для среднего
+} servo_output_stats_t;
+
 /**
  * @brief Инициализация сервоконтроллера
  * @return ESP_OK при успехе
@@ -23,6 +35,86 @@ esp_err_t servo_controller_init(void);
  */
 esp_err_t servo_controller_move_to(int servo_id, int angle, bool smooth);
 
+/**
+ * @brief Установить угол сервопривода с точностью до сотой градуса
+ *
+ * Угол переводится в импульс по калибровочной таблице оси, поэтому
+ * сопровождение цели не упирается в шаг в один градус.
+ * @param servo_id ID сервопривода (1 или 2)
+ * @param angle_cdeg Угол в сотых долях градуса (0-18000)
+ * @param smooth Плавное движение (true/false)
+ * @return ESP_OK при успехе
+ */
+esp_err_t servo_controller_move_to_cdeg(int servo_id, int32_t angle_cdeg, bool smooth);
+
+/**
+ * @brief Согласованно перевести обе оси так, чтобы они пришли одновременно
+ *
+ * Профиль каждой оси растягивается до времени самой медленной из них (или до
+ * duration_ms, если оно больше), поэтому луч идёт к цели по прямой, а не
+ * «буквой Г». Время рассчитывается от покоя; ось, уже движущаяся с большой
+ * скоростью, может немного отклониться от расчёта.
+ * @param pan Угол сервопривода 1 (азимут), градусы
+ * @param tilt Угол сервопривода 2 (наклон), градусы
+ * @param duration_ms Желаемая длительность, 0 — максимально быстро
+ * @return ESP_OK при успехе
+ */
+esp_err_t servo_controller_move_pose(int pan, int tilt, uint32_t duration_ms);
+
+/**
+ * @brief Согласованное движение обеих осей с точностью до сотой градуса
+ * @param pan_cdeg Угол сервопривода 1 в сотых долях градуса (0-18000)
+ * @param tilt_cdeg Угол сервопривода 2 в сотых долях градуса (0-18000)
+ * @param duration_ms Желаемая длительность, 0 — максимально быстро
+ * @return ESP_OK при успехе
+ */
+esp_err_t servo_controller_move_pose_cdeg(int32_t pan_cdeg, int32_t tilt_cdeg, uint32_t duration_ms);
+
+/**
+ * @brief Перевести один сервопривод программным профилем за заданное время
+ *
+ * Профиль растягивается так же, как у servo_controller_move_pose_cdeg;
+ * запасной путь, когда аппаратное затухание LEDC недоступно.
+ * @param servo_id ID сервопривода (1 или 2)
+ * @param angle_cdeg Угол в сотых долях градуса (0-18000)
+ * @param duration_ms Желаемая длительность, 0 — максимально быстро
+ * @return ESP_OK при успехе
+ */
+esp_err_t servo_controller_move_timed_cdeg(int servo_id, int32_t angle_cdeg, uint32_t duration_ms);
+
+/**
+ * @brief Перевести сервопривод аппаратным затуханием LEDC за заданное время
+ *
+ * Duty меняется таймером LEDC равномерно, без участия процессора; статус
+ * обновляется обработчиком конца затухания. Любой последующий
+ * servo_controller_move_to прерывает затухание с текущего положения.
+ * Фактическая длительность может немного отличаться от duration_ms
+ * (см. servo_fade.h).
+ * @param servo_id ID сервопривода (1 или 2)
+ * @param angle Угол в градусах (0-180)
+ * @param duration_ms Длительность перехода
+ * @return ESP_OK при успехе, ESP_ERR_NOT_SUPPORTED без службы затухания LEDC
+ */
+esp_err_t servo_controller_fade_to(int servo_id, int angle, uint32_t duration_ms);
+
+/**
+ * @brief Затухание LEDC к углу с точностью до сотой градуса
+ * @param servo_id ID сервопривода (1 или 2)
+ * @param angle_cdeg Угол в сотых долях градуса (0-18000)
+ * @param duration_ms Длительность перехода
+ * @return ESP_OK при успехе, ESP_ERR_NOT_SUPPORTED без службы затухания LEDC
+ */
+esp_err_t servo_controller_fade_to_cdeg(int servo_id, int32_t angle_cdeg, uint32_t duration_ms);
+
+/**
+ * @brief Задать ограничения скорости и ускорения плавного движения
+ * @param servo_id ID сервопривода (1, 2 или 0 для всех)
+ * @param max_velocity_dps Максимальная скорость, град/с
+ * @param max_accel_dps2 Максимальное ускорение, град/с²
+ * @return ESP_OK при успехе
+ */
+esp_err_t servo_controller_set_motion_limits(int servo_id, float max_velocity_dps, float max_accel_dps2);
+
 /**
  * @brief Получить текущий статус сервоприводов
  * @param status Указатель на структуру статуса
@@ -30,9 +122,75 @@ esp_err_t servo_controller_move_to(int servo_id, int angle, bool smooth);
  */
 esp_err_t servo_controller_get_status(servo_status_t* status);
 
+/**
+ * @brief Получить счётчики времени записи duty
+ * @param stats Указатель на структуру для результата
+ * @return ESP_OK при успехе
+ */
+esp_err_t servo_controller_get_output_stats(servo_output_stats_t* stats);
+
+/*
+ * Калибровка оси (сервопривод без обратной связи, поэтому по месту):
+ *   1. servo_controller_set_pulse_us — подвести ось к механическим упорам
+ *      и найти крайние рабочие импульсы;
+ *   2. servo_controller_calibration_set_limits — начать таблицу с этих пределов;
+ *   3. подвести ось импульсом к отметке угла и записать её
+ *      servo_controller_calibration_record, повторить для нужных углов;
+ *   4. servo_controller_calibration_apply — проверить и применить таблицу.
+ */
+
+/**
+ * @brief Выдать импульс заданной ширины в обход калибровки
+ * @param servo_id ID сервопривода (1 или 2)
+ * @param pulse_us Ширина импульса, мкс (400-2700)
+ * @return ESP_OK при успехе
+ */
+esp_err_t servo_controller_set_pulse_us(int servo_id, uint16_t pulse_us);
+
+/**
+ * @brief Начать новую калибровочную таблицу из двух крайних точек
+ * @param servo_id ID сервопривода (1 или 2)
+ * @param min_pulse_us Импульс для 0°
+ * @param max_pulse_us Импульс для 180° (меньше min_pulse_us, если ось зеркальна)
+ * @return ESP_OK при успехе
+ */
+esp_err_t servo_controller_calibration_set_limits(int servo_id, uint16_t min_pulse_us, uint16_t max_pulse_us);
+
+/**
+ * @brief Записать текущий импульс оси как точку угла в собираемую таблицу
+ * @param servo_id ID сервопривода (1 или 2)
+ * @param angle_cdeg Угол отметки, сотые градуса
+ * @return ESP_OK при успехе, ESP_ERR_INVALID_ARG если таблица заполнена
+ */
+esp_err_t servo_controller_calibration_record(int servo_id, int32_t angle_cdeg);
+
+/**
+ * @brief Применить собранную таблицу
+ * @param servo_id ID сервопривода (1 или 2)
+ * @param persist Сохранить таблицу в NVS
+ * @return ESP_OK при успехе, ESP_ERR_INVALID_STATE если таблица немонотонна
+ */
+esp_err_t servo_controller_calibration_apply(int servo_id, bool persist);
+
+/**
+ * @brief Вернуть калибровку по умолчанию и удалить сохранённую
+ * @param servo_id ID сервопривода (1 или 2)
+ * @return ESP_OK при успехе
+ */
+esp_err_t servo_controller_calibration_reset(int servo_id);
+
+/**
+ * @brief Получить действующую калибровочную таблицу
+ * @param servo_id ID сервопривода (1 или 2)
+ * @param calibration Указатель на структуру для результата
+ * @return ESP_OK при успехе
+ */
+esp_err_t servo_controller_get_calibration(int servo_id, servo_calibration_t* calibration);
+
 /**
  * @brief Задача для плавного движения сервоприводов
- * Должна вызываться периодически из основного цикла или задачи FreeRTOS
+ * Должна вызываться периодически из основного цикла или задачи FreeRTOS.
+ * Раз в период ШИМ (20 мс) продвигает профили осей и обновляет duty.
  */
 void servo_controller_task(void);
 
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Модель аппаратного затухания LEDC (ledc_set_fade_with_time).
+ *
+ * Драйвер раскладывает затухание на шаги: scale отсчётов duty каждые
+ * cycle_num периодов ШИМ. Из-за целочисленного деления фактическое время
+ * отличается от запрошенного — модель повторяет этот расчёт, чтобы статус
+ * сервопривода показывал положение во время затухания без чтения регистров
+ * LEDC. Модуль не зависит от ESP-IDF и собирается на хосте.
+ */
+
+#define SERVO_FADE_CYCLE_NUM_MAX 1023   ///< Предел числа периодов на шаг в LEDC
+
+typedef struct {
+    uint32_t start_duty;
+    uint32_t target_duty;
+    uint32_t scale;         ///< Отсчётов duty за шаг
+    uint32_t cycle_num;     ///< Периодов ШИМ на шаг
+    uint32_t steps;         ///< Число шагов до target_duty
+    uint32_t period_us;     ///< Период ШИМ
+    int64_t started_us;
+} servo_fade_t;
+
+/**
+ * @brief Рассчитать затухание так же, как ledc_set_fade_with_time
+ * @param duration_ms Запрошенная длительность
+ * @param pwm_freq_hz Частота таймера LEDC
+ * @param now_us Момент запуска
+ */
+void servo_fade_plan(servo_fade_t *fade, uint32_t start_duty, uint32_t target_duty,
+                     uint32_t duration_ms, uint32_t pwm_freq_hz, int64_t now_us);
+
+/**
+ * @brief Момент, когда LEDC выставит target_duty
+ */
+int64_t servo_fade_end_us(const servo_fade_t *fade);
+
+/**
+ * @brief Duty на выходе LEDC в момент now_us
+ */
+uint32_t servo_fade_duty_at(const servo_fade_t *fade, int64_t now_us);
+
+#ifdef __cplusplus
+}
+#endif
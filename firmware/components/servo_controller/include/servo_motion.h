@@ -0,0 +1,61 @@
+#pragma once
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Планировщик движения одной оси с ограничением скорости и ускорения
+ * (трапециевидный профиль). Профиль считается онлайн на каждом кадре, поэтому
+ * новую цель можно задать посреди движения: ось сохраняет текущую скорость и
+ * плавно перестраивается без остановки.
+ *
+ * Модуль не зависит от ESP-IDF и собирается на хосте.
+ */
+
+typedef struct {
+    float position;         ///< Текущее положение, градусы
+    float velocity;         ///< Текущая скорость, град/с
+    float target;           ///< Целевое положение, градусы
+    float max_velocity;     ///< Ограничение скорости, град/с
+    float max_accel;        ///< Ограничение ускорения, град/с²
+    bool moving;
+} servo_motion_t;
+
+/**
+ * @brief Инициализировать ось в покое в положении position
+ */
+void servo_motion_init(servo_motion_t *motion, float position, float max_velocity, float max_accel);
+
+/**
+ * @brief Изменить ограничения; текущее движение продолжается с новыми
+ */
+void servo_motion_set_limits(servo_motion_t *motion, float max_velocity, float max_accel);
+
+/**
+ * @brief Задать новую цель, не сбрасывая текущую скорость
+ */
+void servo_motion_set_target(servo_motion_t *motion, float target);
+
+/**
+ * @brief Мгновенно поставить ось в положение и остановить
+ */
+void servo_motion_jump(servo_motion_t *motion, float position);
+
+/**
+ * @brief Время перехода из покоя в текущем положении в target при текущих ограничениях
+ * @return Секунды
+ */
+float servo_motion_duration(const servo_motion_t *motion, float target);
+
+/**
+ * @brief Продвинуть профиль на dt_s секунд
+ * @return true если ось ещё движется
+ */
+bool servo_motion_step(servo_motion_t *motion, float dt_s);
+
+#ifdef __cplusplus
+}
+#endif
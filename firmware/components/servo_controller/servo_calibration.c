@@ -0,0 +1,116 @@
+#include "servo_calibration.h"
+#include <math.h>
+#include <string.h>
+
+void servo_calibration_default(servo_calibration_t *cal)
+{
+    servo_calibration_linear(cal, SERVO_MIN_ANGLE * 100, SERVO_CALIBRATION_DEFAULT_MIN_US,
+                             SERVO_MAX_ANGLE * 100, SERVO_CALIBRATION_DEFAULT_MAX_US);
+}
+
+void servo_calibration_linear(servo_calibration_t *cal, int32_t min_cdeg, uint16_t min_pulse_us,
+                              int32_t max_cdeg, uint16_t max_pulse_us)
+{
+    memset(cal, 0, sizeof(*cal));
+    cal->version = SERVO_CALIBRATION_VERSION;
+    cal->count = 2;
+    cal->angle_cdeg[0] = (uint16_t)min_cdeg;
+    cal->pulse_us[0] = min_pulse_us;
+    cal->angle_cdeg[1] = (uint16_t)max_cdeg;
+    cal->pulse_us[1] = max_pulse_us;
+}
+
+static bool pulse_in_range(uint32_t pulse_us)
+{
+    return pulse_us >= SERVO_CALIBRATION_PULSE_MIN_US && pulse_us <= SERVO_CALIBRATION_PULSE_MAX_US;
+}
+
+bool servo_calibration_is_valid(const servo_calibration_t *cal)
+{
+    if (cal->version != SERVO_CALIBRATION_VERSION ||
+        cal->count < 2 || cal->count > SERVO_CALIBRATION_MAX_POINTS) {
+        return false;
+    }
+    
+    bool rising = cal->pulse_us[1] > cal->pulse_us[0];
+    for (int i = 0; i < cal->count; i++) {
+        if (!pulse_in_range(cal->pulse_us[i]) || cal->angle_cdeg[i] > SERVO_MAX_ANGLE * 100) {
+            return false;
+        }
+        if (i == 0) {
+            continue;
+        }
+        // Немонотонная таблица не обращается однозначно
+        if (cal->angle_cdeg[i] <= cal->angle_cdeg[i - 1] ||
+            cal->pulse_us[i] == cal->pulse_us[i - 1] ||
+            (cal->pulse_us[i] > cal->pulse_us[i - 1]) != rising) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool servo_calibration_set_point(servo_calibration_t *cal, int32_t angle_cdeg, uint16_t pulse_us)
+{
+    if (angle_cdeg < SERVO_MIN_ANGLE * 100 || angle_cdeg > SERVO_MAX_ANGLE * 100 || !pulse_in_range(pulse_us)) {
+        return false;
+    }
+    
+    int pos = 0;
+    while (pos < cal->count && cal->angle_cdeg[pos] < angle_cdeg) {
+        pos++;
+    }
+    if (pos < cal->count && cal->angle_cdeg[pos] == angle_cdeg) {
+        cal->pulse_us[pos] = pulse_us;
+        return true;
+    }
+    if (cal->count >= SERVO_CALIBRATION_MAX_POINTS) {
+        return false;
+    }
+    
+    memmove(&cal->angle_cdeg[pos + 1], &cal->angle_cdeg[pos], (cal->count - pos) * sizeof(cal->angle_cdeg[0]));
+    memmove(&cal->pulse_us[pos + 1], &cal->pulse_us[pos], (cal->count - pos) * sizeof(cal->pulse_us[0]));
+    cal->angle_cdeg[pos] = (uint16_t)angle_cdeg;
+    cal->pulse_us[pos] = pulse_us;
+    cal->count++;
+    return true;
+}
+
+float servo_calibration_pulse_us(const servo_calibration_t *cal, int32_t angle_cdeg)
+{
+    int last = cal->count - 1;
+    if (angle_cdeg <= cal->angle_cdeg[0]) {
+        return cal->pulse_us[0];
+    }
+    if (angle_cdeg >= cal->angle_cdeg[last]) {
+        return cal->pulse_us[last];
+    }
+    
+    int i = 1;
+    while (cal->angle_cdeg[i] < angle_cdeg) {
+        i++;
+    }
+    float t = (float)(angle_cdeg - cal->angle_cdeg[i - 1]) / (float)(cal->angle_cdeg[i] - cal->angle_cdeg[i - 1]);
+    return cal->pulse_us[i - 1] + t * ((float)cal->pulse_us[i] - (float)cal->pulse_us[i - 1]);
+}
+
+int32_t servo_calibration_angle_cdeg(const servo_calibration_t *cal, float pulse_us)
+{
+    int last = cal->count - 1;
+    // Для убывающей таблицы сравниваем импульсы с обратным знаком
+    float sign = cal->pulse_us[last] > cal->pulse_us[0] ? 1.0f : -1.0f;
+    float p = sign * pulse_us;
+    if (p <= sign * cal->pulse_us[0]) {
+        return cal->angle_cdeg[0];
+    }
+    if (p >= sign * cal->pulse_us[last]) {
+        return cal->angle_cdeg[last];
+    }
+    
+    int i = 1;
+    while (sign * cal->pulse_us[i] < p) {
+        i++;
+    }
+    float t = (pulse_us - cal->pulse_us[i - 1]) / ((float)cal->pulse_us[i] - (float)cal->pulse_us[i - 1]);
+    return cal->angle_cdeg[i - 1] + (int32_t)lroundf(t * (float)(cal->angle_cdeg[i] - cal->angle_cdeg[i - 1]));
+}
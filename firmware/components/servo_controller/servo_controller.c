@@ -1,9 +1,17 @@
 #include "servo_controller.h"
+#include "servo_motion.h"
+#include "servo_fade.h"
+#include "servo_calibration.h"
 #include "driver/ledc.h"
+#include "esp_attr.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
 #include "freertos/task.h"
 #include <math.h>
+#include <stdatomic.h>
+#include <stdint.h>
 
 static const char *TAG = "SERVO_CONTROLLER";
 
@@ -15,77 +23,234 @@ static const char *TAG = "SERVO_CONTROLLER";
 #define SERVO_LEDC_DUTY_RES           LEDC_TIMER_13_BIT  // 13-битное разрешение
 #define SERVO_LEDC_FREQUENCY          50                 // 50 Hz для сервоприводов
 
-// PWM параметры для сервоприводов (расширенный диапазон для разных моделей)
-#define SERVO_MIN_DUTY                328    // ~0.8ms при 13-bit и 50Hz (минимальный рабочий импульс)
-#define SERVO_MAX_DUTY                1024   // ~2.5ms при 13-bit и 50Hz (максимальный рабочий импульс)  
-#define SERVO_STEP_DELAY_MS           15     // Задержка между шагами плавного движения
+// Импульс -> duty: период ШИМ и полная шкала 13-битного duty (~2.44 мкс на отсчёт).
+// Рабочий диапазон импульсов задаёт калибровочная таблица каждой оси
+#define SERVO_PERIOD_US               (1000000 / SERVO_LEDC_FREQUENCY)
+#define SERVO_DUTY_MAX                (1u << 13)
+#define SERVO_FRAME_MS                (1000 / SERVO_LEDC_FREQUENCY)  // Новый duty раз в период ШИМ
+
+#ifdef CONFIG_SERVO_CONTROLLER_MAX_VELOCITY_DPS
+#define SERVO_MAX_VELOCITY_DPS        CONFIG_SERVO_CONTROLLER_MAX_VELOCITY_DPS
+#else
+#define SERVO_MAX_VELOCITY_DPS        240
+#endif
+
+#ifdef CONFIG_SERVO_CONTROLLER_MAX_ACCEL_DPS2
+#define SERVO_MAX_ACCEL_DPS2          CONFIG_SERVO_CONTROLLER_MAX_ACCEL_DPS2
+#else
+#define SERVO_MAX_ACCEL_DPS2          960
+#endif
+
+#define SERVO_COUNT                   2
+
+// Подробный лог каждой записи duty только по CONFIG_SERVO_CONTROLLER_TRACE:
+// на 50 Гц с двумя осями он сам по себе не укладывается в срок задания servo
+#ifdef CONFIG_SERVO_CONTROLLER_TRACE
+#define SERVO_TRACE(...)              ESP_LOGI(TAG, __VA_ARGS__)
+#else
+#define SERVO_TRACE(...)              do { } while (0)
+#endif
 
 // Текущие состояния сервоприводов
 static servo_status_t s_servo_status = {
     .angle1 = 90,
     .angle2 = 90,
+    .angle1_cdeg = 9000,
+    .angle2_cdeg = 9000,
     .moving1 = false,
     .moving2 = false
 };
 
-// Целевые углы для плавного движения
-static int s_target_angle1 = 90;
-static int s_target_angle2 = 90;
-static TickType_t s_last_step_time = 0;
+// Состояние движения меняют задачи WS/HTTP и задание servo; всё ниже — под s_lock
+static SemaphoreHandle_t s_lock = NULL;
+
+// Профили движения осей (индекс = servo_id - 1) и последний записанный duty
+static servo_motion_t s_motion[SERVO_COUNT];
+static uint32_t s_duty[SERVO_COUNT];
+// Ограничения осей; согласованное движение временно их уменьшает
+static float s_max_velocity[SERVO_COUNT];
+static float s_max_accel[SERVO_COUNT];
+static TickType_t s_last_frame_time = 0;
+// Действующие калибровочные таблицы и таблицы, собираемые при калибровке
+static servo_calibration_t s_calibration[SERVO_COUNT];
+static servo_calibration_t s_calibration_pending[SERVO_COUNT];
+static servo_output_stats_t s_output_stats = {0};
+
+// Аппаратное затухание LEDC: модель даёт положение для статуса, флаг
+// завершения выставляет обработчик прерывания конца затухания
+static servo_fade_t s_fade[SERVO_COUNT];
+static bool s_fade_active[SERVO_COUNT];
+static atomic_bool s_fade_done[SERVO_COUNT];
+static bool s_fade_ready = false;
+
+static ledc_channel_t servo_channel(int index)
+{
+    return index == 0 ? SERVO_LEDC_CHANNEL_1 : SERVO_LEDC_CHANNEL_2;
+}
+
+static void set_status(int index, float angle, bool moving)
+{
+    int32_t angle_cdeg = (int32_t)lroundf(angle * 100.0f);
+    if (index == 0) {
+        s_servo_status.angle1 = (int)lroundf(angle);
+        s_servo_status.angle1_cdeg = angle_cdeg;
+        s_servo_status.moving1 = moving;
+    } else {
+        s_servo_status.angle2 = (int)lroundf(angle);
+        s_servo_status.angle2_cdeg = angle_cdeg;
+        s_servo_status.moving2 = moving;
+    }
+}
+
+static uint32_t pulse_to_duty(float pulse_us)
+{
+    return (uint32_t)lroundf(pulse_us * SERVO_DUTY_MAX / SERVO_PERIOD_US);
+}
+
+static float duty_to_pulse_us(uint32_t duty)
+{
+    return (float)duty * SERVO_PERIOD_US / SERVO_DUTY_MAX;
+}
 
 /**
  * @brief Преобразование угла в значение duty cycle для LEDC
- * @param angle Угол в градусах (0-180)
+ * @param index Индекс оси (servo_id - 1), выбирает калибровочную таблицу
+ * @param angle Угол в градусах (0-180), дробная часть даёт промежуточный duty
  * @return Значение duty cycle
  */
-static uint32_t angle_to_duty(int angle)
+static uint32_t angle_to_duty(int index, float angle)
 {
     // Ограничиваем угол
     if (angle < SERVO_MIN_ANGLE) angle = SERVO_MIN_ANGLE;
     if (angle > SERVO_MAX_ANGLE) angle = SERVO_MAX_ANGLE;
     
-    // Линейная интерполяция между MIN и MAX duty
-    return SERVO_MIN_DUTY + (angle * (SERVO_MAX_DUTY - SERVO_MIN_DUTY)) / (SERVO_MAX_ANGLE - SERVO_MIN_ANGLE);
+    float pulse_us = servo_calibration_pulse_us(&s_calibration[index], (int32_t)lroundf(angle * 100.0f));
+    return pulse_to_duty(pulse_us);
+}
+
+/**
+ * @brief Обратное преобразование duty в угол
+ */
+static float duty_to_angle(int index, uint32_t duty)
+{
+    return servo_calibration_angle_cdeg(&s_calibration[index], duty_to_pulse_us(duty)) / 100.0f;
 }
 
 /**
- * @brief Установить duty cycle для сервопривода
+ * @brief Конец аппаратного затухания (контекст прерывания)
+ *
+ * Без вычислений с плавающей точкой: FPU в прерываниях ESP32 недоступен,
+ * статус обновляет servo_controller_task по флагу.
+ */
+static IRAM_ATTR bool on_fade_end(const ledc_cb_param_t *param, void *user_arg)
+{
+    int index = (int)(intptr_t)user_arg;
+    if (param->event == LEDC_FADE_END_EVT) {
+        atomic_store(&s_fade_done[index], true);
+    }
+    return false;
+}
+
+/**
+ * @brief Прервать затухание оси и продолжить с того duty, где оно остановилось (под s_lock)
+ */
+static void cancel_fade(int index)
+{
+    if (!s_fade_active[index]) {
+        return;
+    }
+    
+    ledc_fade_stop(SERVO_LEDC_MODE, servo_channel(index));
+    uint32_t duty = ledc_get_duty(SERVO_LEDC_MODE, servo_channel(index));
+    s_fade_active[index] = false;
+    atomic_store(&s_fade_done[index], false);
+    s_duty[index] = duty;
+    servo_motion_jump(&s_motion[index], duty_to_angle(index, duty));
+}
+
+/**
+ * @brief Записать duty cycle сервопривода (под s_lock)
+ *
+ * Вызывается из задания servo на каждом кадре движения, поэтому не
+ * блокируется: новый duty применяется таймером LEDC с начала следующего
+ * периода ШИМ, ждать или перечитывать его не нужно.
  * @param servo_id ID сервопривода (1 или 2)
- * @param angle Угол в градусах
+ * @param duty Значение duty cycle
  */
-static void set_servo_angle_immediate(int servo_id, int angle)
+static void write_servo_duty(int servo_id, uint32_t duty)
 {
-    uint32_t duty = angle_to_duty(angle);
-    ledc_channel_t channel = (servo_id == 1) ? SERVO_LEDC_CHANNEL_1 : SERVO_LEDC_CHANNEL_2;
-    int gpio_pin = (servo_id == 1) ? SERVO1_PIN : SERVO2_PIN;
+    ledc_channel_t channel = servo_channel(servo_id - 1);
     
-    ESP_LOGI(TAG, "Setting servo %d (GPIO%d): angle=%d°, duty=%d (%.2fms)", 
-             servo_id, gpio_pin, angle, duty, (duty * 20.0) / 8192.0);
+    // Кадры с тем же duty ничего не меняют на выходе
+    if (duty == s_duty[servo_id - 1]) {
+        return;
+    }
     
+    SERVO_TRACE("Setting servo %d (GPIO%d): duty=%d (%.1f us)",
+                servo_id, (servo_id == 1) ? SERVO1_PIN : SERVO2_PIN, (int)duty,
+                (double)duty_to_pulse_us(duty));
+    
+    int64_t started_us = esp_timer_get_time();
     esp_err_t ret = ledc_set_duty(SERVO_LEDC_MODE, channel, duty);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to set duty for servo %d: %s", servo_id, esp_err_to_name(ret));
-        return;
+    if (ret == ESP_OK) {
+        ret = ledc_update_duty(SERVO_LEDC_MODE, channel);
+    }
+    uint32_t elapsed_us = (uint32_t)(esp_timer_get_time() - started_us);
+    
+    s_output_stats.writes++;
+    s_output_stats.last_us = elapsed_us;
+    s_output_stats.total_us += elapsed_us;
+    if (elapsed_us > s_output_stats.max_us) {
+        s_output_stats.max_us = elapsed_us;
     }
     
-    ret = ledc_update_duty(SERVO_LEDC_MODE, channel);
     if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to update duty for servo %d: %s", servo_id, esp_err_to_name(ret));
+        // Ошибка повторится на каждом кадре, поэтому только счётчик и отладочный лог
+        s_output_stats.errors++;
+        ESP_LOGD(TAG, "Failed to write duty for servo %d: %s", servo_id, esp_err_to_name(ret));
         return;
     }
     
-    // Проверяем что duty cycle установлен корректно
-    uint32_t actual_duty = ledc_get_duty(SERVO_LEDC_MODE, channel);
-    ESP_LOGI(TAG, "Servo %d actual duty: %d (expected: %d)", servo_id, actual_duty, duty);
-    
-    // Добавляем небольшую задержку для стабилизации сигнала
-    vTaskDelay(pdMS_TO_TICKS(10));
+    s_duty[servo_id - 1] = duty;
+}
+
+/**
+ * @brief Установить угол сервопривода по калибровочной таблице
+ * @param servo_id ID сервопривода (1 или 2)
+ * @param angle Угол в градусах
+ */
+static void set_servo_angle_immediate(int servo_id, float angle)
+{
+    write_servo_duty(servo_id, angle_to_duty(servo_id - 1, angle));
 }
 
 esp_err_t servo_controller_init(void)
 {
     esp_err_t ret;
     
+    if (!s_lock) {
+        s_lock = xSemaphoreCreateMutex();
+        if (!s_lock) {
+            ESP_LOGE(TAG, "Failed to create servo lock");
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    
+    // Калибровка из NVS; без неё — общий диапазон 800..2500 мкс
+    for (int i = 0; i < SERVO_COUNT; i++) {
+        servo_calibration_default(&s_calibration[i]);
+        servo_calibration_t stored;
+        if (config_storage_load_servo_calibration(i + 1, &stored) == ESP_OK) {
+            if (servo_calibration_is_valid(&stored)) {
+                s_calibration[i] = stored;
+                ESP_LOGI(TAG, "Servo %d calibration loaded: %d points", i + 1, stored.count);
+            } else {
+                ESP_LOGW(TAG, "Servo %d calibration in NVS is invalid, using defaults", i + 1);
+            }
+        }
+        s_calibration_pending[i] = s_calibration[i];
+    }
+    
     // Конфигурация таймера LEDC
     ledc_timer_config_t ledc_timer = {
         .speed_mode = SERVO_LEDC_MODE,
@@ -107,7 +272,7 @@ esp_err_t servo_controller_init(void)
         .timer_sel = SERVO_LEDC_TIMER,
         .intr_type = LEDC_INTR_DISABLE,
         .gpio_num = SERVO1_PIN,
-        .duty = angle_to_duty(90),  // Начальное положение 90 градусов
+        .duty = angle_to_duty(0, 90),  // Начальное положение 90 градусов
         .hpoint = 0
     };
     ret = ledc_channel_config(&ledc_channel_1);
@@ -123,7 +288,7 @@ esp_err_t servo_controller_init(void)
         .timer_sel = SERVO_LEDC_TIMER,
         .intr_type = LEDC_INTR_DISABLE,
         .gpio_num = SERVO2_PIN,
-        .duty = angle_to_duty(90),  // Начальное положение 90 градусов
+        .duty = angle_to_duty(1, 90),  // Начальное положение 90 градусов
         .hpoint = 0
     };
     ret = ledc_channel_config(&ledc_channel_2);
@@ -132,42 +297,206 @@ esp_err_t servo_controller_init(void)
         return ret;
     }
     
-    s_last_step_time = xTaskGetTickCount();
+    for (int i = 0; i < SERVO_COUNT; i++) {
+        s_max_velocity[i] = SERVO_MAX_VELOCITY_DPS;
+        s_max_accel[i] = SERVO_MAX_ACCEL_DPS2;
+        servo_motion_init(&s_motion[i], 90.0f, s_max_velocity[i], s_max_accel[i]);
+        s_duty[i] = angle_to_duty(i, 90.0f);
+    }
+    s_last_frame_time = xTaskGetTickCount();
+    
+    // Без службы затухания работает только программное движение
+    ret = ledc_fade_func_install(0);
+    if (ret == ESP_OK || ret == ESP_ERR_INVALID_STATE) {  // INVALID_STATE — уже установлена
+        s_fade_ready = true;
+        for (int i = 0; i < SERVO_COUNT; i++) {
+            ledc_cbs_t callbacks = { .fade_cb = on_fade_end };
+            if (ledc_cb_register(SERVO_LEDC_MODE, servo_channel(i), &callbacks, (void*)(intptr_t)i) != ESP_OK) {
+                s_fade_ready = false;
+            }
+        }
+    }
+    if (!s_fade_ready) {
+        ESP_LOGW(TAG, "LEDC fade service unavailable, hardware fades disabled");
+    }
     
     ESP_LOGI(TAG, "Servo controller initialized. Servo1 pin: %d, Servo2 pin: %d", SERVO1_PIN, SERVO2_PIN);
     return ESP_OK;
 }
 
 esp_err_t servo_controller_move_to(int servo_id, int angle, bool smooth)
+{
+    return servo_controller_move_to_cdeg(servo_id, (int32_t)angle * 100, smooth);
+}
+
+esp_err_t servo_controller_move_to_cdeg(int servo_id, int32_t angle_cdeg, bool smooth)
 {
     // Ограничиваем угол
-    if (angle < SERVO_MIN_ANGLE) angle = SERVO_MIN_ANGLE;
-    if (angle > SERVO_MAX_ANGLE) angle = SERVO_MAX_ANGLE;
+    if (angle_cdeg < SERVO_MIN_ANGLE * 100) angle_cdeg = SERVO_MIN_ANGLE * 100;
+    if (angle_cdeg > SERVO_MAX_ANGLE * 100) angle_cdeg = SERVO_MAX_ANGLE * 100;
+    float angle = angle_cdeg / 100.0f;
     
-    if (servo_id == 1) {
-        s_target_angle1 = angle;
-        if (smooth) {
-            s_servo_status.moving1 = (s_servo_status.angle1 != angle);
-        } else {
-            s_servo_status.angle1 = angle;
-            s_servo_status.moving1 = false;
-            set_servo_angle_immediate(1, angle);
-        }
-    } else if (servo_id == 2) {
-        s_target_angle2 = angle;
-        if (smooth) {
-            s_servo_status.moving2 = (s_servo_status.angle2 != angle);
-        } else {
-            s_servo_status.angle2 = angle;
-            s_servo_status.moving2 = false;
-            set_servo_angle_immediate(2, angle);
-        }
+    if (servo_id != 1 && servo_id != 2) {
+        ESP_LOGE(TAG, "Invalid servo ID: %d", servo_id);
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    cancel_fade(servo_id - 1);
+    
+    servo_motion_t *motion = &s_motion[servo_id - 1];
+    servo_motion_set_limits(motion, s_max_velocity[servo_id - 1], s_max_accel[servo_id - 1]);
+    if (smooth) {
+        // Профиль перестраивается от текущей скорости, ось не останавливается
+        servo_motion_set_target(motion, angle);
     } else {
+        servo_motion_jump(motion, angle);
+        set_servo_angle_immediate(servo_id, angle);
+    }
+    
+    set_status(servo_id - 1, motion->position, motion->moving);
+    xSemaphoreGive(s_lock);
+    
+    ESP_LOGD(TAG, "Servo %d moving to %.2f degrees (smooth: %s)", servo_id, (double)angle, smooth ? "yes" : "no");
+    return ESP_OK;
+}
+
+/**
+ * @brief Направить ось к цели по профилю, растянутому до total секунд
+ *
+ * Скорость ×k и ускорение ×k² растягивают профиль оси ровно в 1/k раз.
+ * Вызывается под s_lock.
+ * @param duration Время профиля с полными ограничениями, секунды
+ */
+static void stretch_to_locked(int index, float target, float duration, float total)
+{
+    servo_motion_t *motion = &s_motion[index];
+    if (total > 0.0f && duration > 0.0f) {
+        float k = duration / total;
+        servo_motion_set_limits(motion, s_max_velocity[index] * k, s_max_accel[index] * k * k);
+    }
+    servo_motion_set_target(motion, target);
+    set_status(index, motion->position, motion->moving);
+}
+
+esp_err_t servo_controller_move_timed_cdeg(int servo_id, int32_t angle_cdeg, uint32_t duration_ms)
+{
+    if (servo_id != 1 && servo_id != 2) {
         ESP_LOGE(TAG, "Invalid servo ID: %d", servo_id);
         return ESP_ERR_INVALID_ARG;
     }
+    if (angle_cdeg < SERVO_MIN_ANGLE * 100) angle_cdeg = SERVO_MIN_ANGLE * 100;
+    if (angle_cdeg > SERVO_MAX_ANGLE * 100) angle_cdeg = SERVO_MAX_ANGLE * 100;
+    float target = angle_cdeg / 100.0f;
+    float total = (float)duration_ms / 1000.0f;
+    int index = servo_id - 1;
+    
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    cancel_fade(index);
+    servo_motion_set_limits(&s_motion[index], s_max_velocity[index], s_max_accel[index]);
+    float duration = servo_motion_duration(&s_motion[index], target);
+    if (duration > total) {
+        total = duration;
+    }
+    stretch_to_locked(index, target, duration, total);
+    xSemaphoreGive(s_lock);
+    
+    ESP_LOGD(TAG, "Servo %d moving to %.2f degrees in %d ms", servo_id, (double)target, (int)(total * 1000.0f));
+    return ESP_OK;
+}
+
+esp_err_t servo_controller_move_pose(int pan, int tilt, uint32_t duration_ms)
+{
+    return servo_controller_move_pose_cdeg((int32_t)pan * 100, (int32_t)tilt * 100, duration_ms);
+}
+
+esp_err_t servo_controller_move_pose_cdeg(int32_t pan_cdeg, int32_t tilt_cdeg, uint32_t duration_ms)
+{
+    int32_t targets_cdeg[SERVO_COUNT] = { pan_cdeg, tilt_cdeg };
+    float targets[SERVO_COUNT];
+    float durations[SERVO_COUNT];
+    float total = (float)duration_ms / 1000.0f;
+    
+    // Обе оси под одной блокировкой: задание servo видит либо старую позу, либо новую
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    for (int i = 0; i < SERVO_COUNT; i++) {
+        if (targets_cdeg[i] < SERVO_MIN_ANGLE * 100) targets_cdeg[i] = SERVO_MIN_ANGLE * 100;
+        if (targets_cdeg[i] > SERVO_MAX_ANGLE * 100) targets_cdeg[i] = SERVO_MAX_ANGLE * 100;
+        targets[i] = targets_cdeg[i] / 100.0f;
+        
+        cancel_fade(i);
+        servo_motion_set_limits(&s_motion[i], s_max_velocity[i], s_max_accel[i]);
+        durations[i] = servo_motion_duration(&s_motion[i], targets[i]);
+        if (durations[i] > total) {
+            total = durations[i];
+        }
+    }
+    
+    // Обе оси растянуты до total и приходят к цели одновременно
+    for (int i = 0; i < SERVO_COUNT; i++) {
+        stretch_to_locked(i, targets[i], durations[i], total);
+    }
+    xSemaphoreGive(s_lock);
     
-    ESP_LOGI(TAG, "Servo %d moving to %d degrees (smooth: %s)", servo_id, angle, smooth ? "yes" : "no");
+    ESP_LOGD(TAG, "Pose pan=%.2f tilt=%.2f in %d ms", (double)targets[0], (double)targets[1], (int)(total * 1000.0f));
+    return ESP_OK;
+}
+
+esp_err_t servo_controller_fade_to(int servo_id, int angle, uint32_t duration_ms)
+{
+    return servo_controller_fade_to_cdeg(servo_id, (int32_t)angle * 100, duration_ms);
+}
+
+esp_err_t servo_controller_fade_to_cdeg(int servo_id, int32_t angle_cdeg, uint32_t duration_ms)
+{
+    if (servo_id != 1 && servo_id != 2) {
+        ESP_LOGE(TAG, "Invalid servo ID: %d", servo_id);
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!s_fade_ready) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    
+    if (angle_cdeg < SERVO_MIN_ANGLE * 100) angle_cdeg = SERVO_MIN_ANGLE * 100;
+    if (angle_cdeg > SERVO_MAX_ANGLE * 100) angle_cdeg = SERVO_MAX_ANGLE * 100;
+    float angle = angle_cdeg / 100.0f;
+    
+    int index = servo_id - 1;
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    cancel_fade(index);
+    
+    // Программный профиль останавливается там, где ось сейчас
+    servo_motion_t *motion = &s_motion[index];
+    servo_motion_jump(motion, motion->position);
+    if (angle_to_duty(index, motion->position) != s_duty[index]) {
+        set_servo_angle_immediate(servo_id, motion->position);
+    }
+    
+    uint32_t target_duty = angle_to_duty(index, angle);
+    servo_fade_plan(&s_fade[index], s_duty[index], target_duty, duration_ms,
+                    SERVO_LEDC_FREQUENCY, esp_timer_get_time());
+    if (s_fade[index].steps == 0) {
+        xSemaphoreGive(s_lock);
+        return ESP_OK;
+    }
+    
+    atomic_store(&s_fade_done[index], false);
+    esp_err_t ret = ledc_set_fade_time_and_start(SERVO_LEDC_MODE, servo_channel(index), target_duty,
+                                                 duration_ms, LEDC_FADE_NO_WAIT);
+    if (ret != ESP_OK) {
+        xSemaphoreGive(s_lock);
+        ESP_LOGE(TAG, "Failed to start fade for servo %d: %s", servo_id, esp_err_to_name(ret));
+        return ret;
+    }
+    
+    s_fade_active[index] = true;
+    motion->target = angle;
+    set_status(index, motion->position, true);
+    uint32_t fade_ms = (uint32_t)((servo_fade_end_us(&s_fade[index]) - s_fade[index].started_us) / 1000);
+    xSemaphoreGive(s_lock);
+    
+    ESP_LOGD(TAG, "Servo %d fading to %.2f degrees in %u ms (LEDC: %u ms)", servo_id, (double)angle,
+             (unsigned)duration_ms, (unsigned)fade_ms);
     return ESP_OK;
 }
 
@@ -177,56 +506,237 @@ esp_err_t servo_controller_get_status(servo_status_t* status)
         return ESP_ERR_INVALID_ARG;
     }
     
+    xSemaphoreTake(s_lock, portMAX_DELAY);
     *status = s_servo_status;
+    xSemaphoreGive(s_lock);
+    return ESP_OK;
+}
+
+esp_err_t servo_controller_set_motion_limits(int servo_id, float max_velocity_dps, float max_accel_dps2)
+{
+    if (servo_id < 0 || servo_id > SERVO_COUNT || max_velocity_dps <= 0.0f || max_accel_dps2 <= 0.0f) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    for (int i = 0; i < SERVO_COUNT; i++) {
+        if (servo_id == 0 || servo_id == i + 1) {
+            s_max_velocity[i] = max_velocity_dps;
+            s_max_accel[i] = max_accel_dps2;
+            servo_motion_set_limits(&s_motion[i], max_velocity_dps, max_accel_dps2);
+        }
+    }
+    xSemaphoreGive(s_lock);
+    
+    ESP_LOGI(TAG, "Servo %d motion limits: %.0f deg/s, %.0f deg/s^2",
+             servo_id, (double)max_velocity_dps, (double)max_accel_dps2);
+    return ESP_OK;
+}
+
+esp_err_t servo_controller_get_output_stats(servo_output_stats_t* stats)
+{
+    if (stats == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    *stats = s_output_stats;
+    xSemaphoreGive(s_lock);
+    return ESP_OK;
+}
+
+esp_err_t servo_controller_set_pulse_us(int servo_id, uint16_t pulse_us)
+{
+    if ((servo_id != 1 && servo_id != 2) ||
+        pulse_us < SERVO_CALIBRATION_PULSE_MIN_US || pulse_us > SERVO_CALIBRATION_PULSE_MAX_US) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    int index = servo_id - 1;
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    cancel_fade(index);
+    write_servo_duty(servo_id, pulse_to_duty(pulse_us));
+    
+    // Профиль продолжит с угла, который этот импульс даёт по текущей таблице
+    servo_motion_jump(&s_motion[index], duty_to_angle(index, s_duty[index]));
+    set_status(index, s_motion[index].position, false);
+    uint32_t duty = s_duty[index];
+    xSemaphoreGive(s_lock);
+    
+    ESP_LOGI(TAG, "Servo %d raw pulse %u us (duty %u)", servo_id, (unsigned)pulse_us, (unsigned)duty);
+    return ESP_OK;
+}
+
+esp_err_t servo_controller_calibration_set_limits(int servo_id, uint16_t min_pulse_us, uint16_t max_pulse_us)
+{
+    if (servo_id != 1 && servo_id != 2) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    servo_calibration_t calibration;
+    servo_calibration_linear(&calibration, SERVO_MIN_ANGLE * 100, min_pulse_us,
+                             SERVO_MAX_ANGLE * 100, max_pulse_us);
+    if (!servo_calibration_is_valid(&calibration)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    s_calibration_pending[servo_id - 1] = calibration;
+    xSemaphoreGive(s_lock);
+    ESP_LOGI(TAG, "Servo %d calibration limits: %u..%u us",
+             servo_id, (unsigned)min_pulse_us, (unsigned)max_pulse_us);
+    return ESP_OK;
+}
+
+esp_err_t servo_controller_calibration_record(int servo_id, int32_t angle_cdeg)
+{
+    if (servo_id != 1 && servo_id != 2) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    // Записываем импульс, который реально выдаёт LEDC, с учётом квантования duty
+    int index = servo_id - 1;
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    uint16_t pulse_us = (uint16_t)lroundf(duty_to_pulse_us(s_duty[index]));
+    bool recorded = servo_calibration_set_point(&s_calibration_pending[index], angle_cdeg, pulse_us);
+    int count = s_calibration_pending[index].count;
+    xSemaphoreGive(s_lock);
+    
+    if (!recorded) {
+        ESP_LOGW(TAG, "Servo %d calibration point rejected: %d cdeg, %u us",
+                 servo_id, (int)angle_cdeg, (unsigned)pulse_us);
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    ESP_LOGI(TAG, "Servo %d calibration point: %d cdeg -> %u us (%d points)",
+             servo_id, (int)angle_cdeg, (unsigned)pulse_us, count);
+    return ESP_OK;
+}
+
+esp_err_t servo_controller_calibration_apply(int servo_id, bool persist)
+{
+    if (servo_id != 1 && servo_id != 2) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    int index = servo_id - 1;
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    if (!servo_calibration_is_valid(&s_calibration_pending[index])) {
+        xSemaphoreGive(s_lock);
+        ESP_LOGW(TAG, "Servo %d calibration is not monotonic, not applied", servo_id);
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    // Таблицу меняем под блокировкой: задание servo не увидит её наполовину записанной.
+    // Ось остаётся на прежнем угле, но уже по новой таблице
+    cancel_fade(index);
+    s_calibration[index] = s_calibration_pending[index];
+    set_servo_angle_immediate(servo_id, s_motion[index].position);
+    servo_calibration_t applied = s_calibration[index];
+    xSemaphoreGive(s_lock);
+    
+    // Запись в NVS долгая, задание servo её не ждёт
+    if (persist) {
+        return config_storage_save_servo_calibration(servo_id, &applied);
+    }
+    return ESP_OK;
+}
+
+esp_err_t servo_controller_calibration_reset(int servo_id)
+{
+    if (servo_id != 1 && servo_id != 2) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    int index = servo_id - 1;
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    cancel_fade(index);
+    servo_calibration_default(&s_calibration_pending[index]);
+    s_calibration[index] = s_calibration_pending[index];
+    set_servo_angle_immediate(servo_id, s_motion[index].position);
+    xSemaphoreGive(s_lock);
+    
+    return config_storage_save_servo_calibration(servo_id, NULL);
+}
+
+esp_err_t servo_controller_get_calibration(int servo_id, servo_calibration_t* calibration)
+{
+    if ((servo_id != 1 && servo_id != 2) || calibration == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    *calibration = s_calibration[servo_id - 1];
+    xSemaphoreGive(s_lock);
     return ESP_OK;
 }
 
 void servo_controller_task(void)
 {
     TickType_t current_time = xTaskGetTickCount();
+    TickType_t elapsed = current_time - s_last_frame_time;
     
-    // Проверяем, прошло ли достаточно времени с последнего шага
-    if ((current_time - s_last_step_time) < pdMS_TO_TICKS(SERVO_STEP_DELAY_MS)) {
+    // Duty обновляется не чаще, чем сервопривод принимает импульсы
+    if (elapsed < pdMS_TO_TICKS(SERVO_FRAME_MS)) {
         return;
     }
     
-    s_last_step_time = current_time;
-    
-    // Плавное движение первого сервопривода
-    if (s_servo_status.moving1) {
-        if (s_servo_status.angle1 != s_target_angle1) {
-            int step = (s_target_angle1 > s_servo_status.angle1) ? 1 : -1;
-            s_servo_status.angle1 += step;
-            set_servo_angle_immediate(1, s_servo_status.angle1);
-            
-            if (s_servo_status.angle1 == s_target_angle1) {
-                s_servo_status.moving1 = false;
-                ESP_LOGI(TAG, "Servo 1 reached target angle: %d", s_target_angle1);
-            }
-        } else {
-            s_servo_status.moving1 = false;
-        }
+    // Цель как раз меняют: кадр уйдёт на следующем вызове с большим dt,
+    // а задание не ждёт чужую блокировку дольше своего срока
+    if (xSemaphoreTake(s_lock, 0) != pdTRUE) {
+        return;
     }
     
-    // Плавное движение второго сервопривода
-    if (s_servo_status.moving2) {
-        if (s_servo_status.angle2 != s_target_angle2) {
-            int step = (s_target_angle2 > s_servo_status.angle2) ? 1 : -1;
-            s_servo_status.angle2 += step;
-            set_servo_angle_immediate(2, s_servo_status.angle2);
-            
-            if (s_servo_status.angle2 == s_target_angle2) {
-                s_servo_status.moving2 = false;
-                ESP_LOGI(TAG, "Servo 2 reached target angle: %d", s_target_angle2);
+    s_last_frame_time = current_time;
+    float dt_s = (float)(elapsed * portTICK_PERIOD_MS) / 1000.0f;
+    
+    for (int i = 0; i < SERVO_COUNT; i++) {
+        servo_motion_t *motion = &s_motion[i];
+        
+        if (s_fade_active[i]) {
+            // Duty меняет LEDC; здесь только положение для статуса
+            if (atomic_load(&s_fade_done[i])) {
+                s_fade_active[i] = false;
+                s_duty[i] = s_fade[i].target_duty;
+                servo_motion_jump(motion, motion->target);
+                set_status(i, motion->position, false);
+                ESP_LOGD(TAG, "Servo %d fade finished at %.1f", i + 1, (double)motion->target);
+            } else {
+                uint32_t duty = servo_fade_duty_at(&s_fade[i], esp_timer_get_time());
+                motion->position = duty_to_angle(i, duty);
+                set_status(i, motion->position, true);
             }
-        } else {
-            s_servo_status.moving2 = false;
+            continue;
         }
+        
+        if (!motion->moving) {
+            continue;
+        }
+        
+        bool moving = servo_motion_step(motion, dt_s);
+        set_servo_angle_immediate(i + 1, motion->position);
+        if (!moving) {
+            // Ограничения согласованного движения действуют только до прихода в цель
+            servo_motion_set_limits(motion, s_max_velocity[i], s_max_accel[i]);
+            ESP_LOGD(TAG, "Servo %d reached target angle: %.1f", i + 1, (double)motion->target);
+        }
+        set_status(i, motion->position, motion->moving);
     }
+    xSemaphoreGive(s_lock);
 }
 
 void servo_controller_deinit(void)
 {
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    for (int i = 0; i < SERVO_COUNT; i++) {
+        cancel_fade(i);
+    }
+    xSemaphoreGive(s_lock);
+    if (s_fade_ready) {
+        ledc_fade_func_uninstall();
+        s_fade_ready = false;
+    }
+    
     // Остановка каналов LEDC
     ledc_stop(SERVO_LEDC_MODE, SERVO_LEDC_CHANNEL_1, 0);
     ledc_stop(SERVO_LEDC_MODE, SERVO_LEDC_CHANNEL_2, 0);
@@ -267,7 +777,9 @@ esp_err_t servo_controller_test(int servo_id)
         
         for (int j = 0; j < num_angles; j++) {
             ESP_LOGI(TAG, "Servo %d -> %d degrees", servo, test_angles[j]);
+            xSemaphoreTake(s_lock, portMAX_DELAY);
             set_servo_angle_immediate(servo, test_angles[j]);
+            xSemaphoreGive(s_lock);
             vTaskDelay(pdMS_TO_TICKS(1000)); // 1 секунда на позицию
         }
         
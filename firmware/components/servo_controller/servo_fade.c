@@ -0,0 +1,63 @@
+#include "servo_fade.h"
+
+void servo_fade_plan(servo_fade_t *fade, uint32_t start_duty, uint32_t target_duty,
+                     uint32_t duration_ms, uint32_t pwm_freq_hz, int64_t now_us)
+{
+    uint32_t delta = target_duty > start_duty ? target_duty - start_duty : start_duty - target_duty;
+    uint32_t total_cycles = (uint32_t)(((uint64_t)duration_ms * pwm_freq_hz) / 1000u);
+
+    fade->start_duty = start_duty;
+    fade->target_duty = target_duty;
+    fade->period_us = pwm_freq_hz > 0 ? 1000000u / pwm_freq_hz : 0;
+    fade->started_us = now_us;
+
+    if (delta == 0) {
+        fade->scale = 0;
+        fade->cycle_num = 0;
+        fade->steps = 0;
+        return;
+    }
+
+    if (total_cycles == 0) {
+        // Слишком короткое затухание — один шаг сразу на всю разность
+        fade->scale = delta;
+        fade->cycle_num = 1;
+    } else if (total_cycles > delta) {
+        // Медленное затухание: по одному отсчёту раз в несколько периодов
+        fade->scale = 1;
+        fade->cycle_num = total_cycles / delta;
+        if (fade->cycle_num > SERVO_FADE_CYCLE_NUM_MAX) {
+            fade->cycle_num = SERVO_FADE_CYCLE_NUM_MAX;
+        }
+    } else {
+        // Быстрое затухание: несколько отсчётов на каждом периоде
+        fade->scale = delta / total_cycles;
+        fade->cycle_num = 1;
+    }
+
+    // Последний шаг короче scale и сразу выставляет target_duty
+    fade->steps = (delta + fade->scale - 1) / fade->scale;
+}
+
+int64_t servo_fade_end_us(const servo_fade_t *fade)
+{
+    return fade->started_us + (int64_t)fade->steps * fade->cycle_num * fade->period_us;
+}
+
+uint32_t servo_fade_duty_at(const servo_fade_t *fade, int64_t now_us)
+{
+    if (fade->steps == 0 || now_us >= servo_fade_end_us(fade)) {
+        return fade->target_duty;
+    }
+    if (now_us <= fade->started_us) {
+        return fade->start_duty;
+    }
+
+    uint64_t step_us = (uint64_t)fade->cycle_num * fade->period_us;
+    uint32_t done = (uint32_t)((uint64_t)(now_us - fade->started_us) / step_us);
+    uint32_t moved = done * fade->scale;
+
+    return fade->target_duty > fade->start_duty
+        ? fade->start_duty + moved
+        : fade->start_duty - moved;
+}
@@ -0,0 +1,84 @@
+#include "servo_motion.h"
+
+#include <math.h>
+
+// Ближе этого ось считается пришедшей в цель
+#define SERVO_MOTION_POSITION_EPSILON 0.01f
+
+void servo_motion_init(servo_motion_t *motion, float position, float max_velocity, float max_accel)
+{
+    motion->position = position;
+    motion->velocity = 0.0f;
+    motion->target = position;
+    motion->moving = false;
+    servo_motion_set_limits(motion, max_velocity, max_accel);
+}
+
+void servo_motion_set_limits(servo_motion_t *motion, float max_velocity, float max_accel)
+{
+    motion->max_velocity = max_velocity > 0.0f ? max_velocity : 1.0f;
+    motion->max_accel = max_accel > 0.0f ? max_accel : 1.0f;
+}
+
+void servo_motion_set_target(servo_motion_t *motion, float target)
+{
+    motion->target = target;
+    motion->moving = motion->moving || fabsf(target - motion->position) > SERVO_MOTION_POSITION_EPSILON;
+}
+
+void servo_motion_jump(servo_motion_t *motion, float position)
+{
+    motion->position = position;
+    motion->target = position;
+    motion->velocity = 0.0f;
+    motion->moving = false;
+}
+
+float servo_motion_duration(const servo_motion_t *motion, float target)
+{
+    float distance = fabsf(target - motion->position);
+    float v = motion->max_velocity;
+    float a = motion->max_accel;
+
+    // Треугольный профиль, если до полной скорости разогнаться не успеваем
+    if (distance < v * v / a) {
+        return 2.0f * sqrtf(distance / a);
+    }
+    return distance / v + v / a;
+}
+
+bool servo_motion_step(servo_motion_t *motion, float dt_s)
+{
+    if (!motion->moving || dt_s <= 0.0f) {
+        return motion->moving;
+    }
+
+    float error = motion->target - motion->position;
+    float dv_max = motion->max_accel * dt_s;
+
+    // Наибольшая скорость, с которой ещё можно затормозить точно в цели.
+    // Поправка на dv_max/2 учитывает дискретность кадра и убирает дрожание у цели.
+    float half_dv = 0.5f * dv_max;
+    float stop_speed = sqrtf(half_dv * half_dv + 2.0f * motion->max_accel * fabsf(error)) - half_dv;
+    float desired = fminf(motion->max_velocity, stop_speed);
+    desired = copysignf(desired, error);
+
+    float dv = desired - motion->velocity;
+    if (dv > dv_max) {
+        dv = dv_max;
+    } else if (dv < -dv_max) {
+        dv = -dv_max;
+    }
+    motion->velocity += dv;
+    motion->position += motion->velocity * dt_s;
+
+    // Цель достигнута или пересечена на этом кадре
+    float remaining = motion->target - motion->position;
+    bool crossed = (remaining > 0.0f) != (error > 0.0f);
+    if (fabsf(remaining) <= SERVO_MOTION_POSITION_EPSILON ||
+        (crossed && fabsf(motion->velocity) <= 2.0f * dv_max)) {
+        servo_motion_jump(motion, motion->target);
+    }
+
+    return motion->moving;
+}
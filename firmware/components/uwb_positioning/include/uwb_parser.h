@@ -0,0 +1,127 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Разбор байтового потока MK8000 без привязки к UART и ESP-IDF.
+ * Заголовок не тянет зависимостей ESP-IDF, поэтому парсер собирается
+ * и на хосте (см. firmware/host_bench).
+ */
+
+#define UWB_PEER_ID_LEN 32
+#define UWB_PARSER_LINE_BUFFER_SIZE 128
+#define UWB_FRAME_SIZE 8
+#define UWB_FRAME_HEADER 0xF0
+#define UWB_FRAME_PAYLOAD_LEN 0x05
+#define UWB_FRAME_TAIL 0xAA
+
+/*
+ * Пир идентифицируется 16-битным адресом MK8000. Строковый peerId
+ * ("uwb_XXXX") собирается только при сериализации. Пиры с произвольным
+ * именем из текстового протокола хранят имя, а peer_addr для них —
+ * хеш имени.
+ */
+typedef struct {
+    uint16_t peer_addr;                 ///< Адрес MK8000 или хеш имени
+    bool peer_named;                    ///< Пир задан произвольным именем
+    char peer_name[UWB_PEER_ID_LEN];    ///< Имя пира (только при peer_named)
+    float distance_m;           ///< Сырое расстояние
+    float filtered_distance_m;  ///< Сглаженное расстояние (заполняет uwb_range_store)
+    int rssi_dbm;
+    int64_t updated_at_ms;
+    bool valid;
+} uwb_range_t;
+
+typedef enum {
+    UWB_PARSER_EVENT_FRAME_RANGE,       ///< Корректный бинарный кадр, заполнен range
+    UWB_PARSER_EVENT_FRAME_INVALID,     ///< Кадр собран, но не прошёл проверку, заполнен frame
+    UWB_PARSER_EVENT_FRAME_BAD_LENGTH,  ///< Неожиданный байт длины после 0xF0, заполнен byte
+    UWB_PARSER_EVENT_LINE_RANGE,        ///< Текстовая строка с расстоянием, заполнены line и range
+    UWB_PARSER_EVENT_LINE_INVALID,      ///< Текстовая строка не распознана, заполнен line
+    UWB_PARSER_EVENT_LINE_OVERFLOW,     ///< Слишком длинная строка отброшена, заполнен line
+    UWB_PARSER_EVENT_DISCARDED_BYTE,    ///< Байт вне кадра и вне текста, заполнен byte
+} uwb_parser_event_type_t;
+
+typedef struct {
+    uwb_parser_event_type_t type;
+    const uwb_range_t *range;
+    const uint8_t *frame;
+    const char *line;
+    uint8_t byte;
+} uwb_parser_event_t;
+
+typedef void (*uwb_parser_event_cb_t)(const uwb_parser_event_t *event, void *ctx);
+
+typedef struct {
+    uint8_t frame_buffer[UWB_FRAME_SIZE];
+    size_t frame_length;
+    char line_buffer[UWB_PARSER_LINE_BUFFER_SIZE];
+    size_t line_length;
+    uwb_parser_event_cb_t callback;
+    void *callback_ctx;
+} uwb_parser_t;
+
+/**
+ * @brief Инициализация состояния парсера
+ * @param parser Состояние парсера
+ * @param callback Обработчик событий разбора (может быть NULL)
+ * @param ctx Пользовательский контекст для обработчика
+ */
+void uwb_parser_init(uwb_parser_t *parser, uwb_parser_event_cb_t callback, void *ctx);
+
+/**
+ * @brief Сброс недособранного кадра и строки
+ */
+void uwb_parser_reset(uwb_parser_t *parser);
+
+/**
+ * @brief Передать очередную порцию байтов в парсер
+ * @param parser Состояние парсера
+ * @param data Принятые байты
+ * @param len Количество байтов
+ * @param now_ms Метка времени для найденных расстояний
+ * @return Количество завершённых текстовых строк в этой порции
+ */
+size_t uwb_parser_feed(uwb_parser_t *parser, const uint8_t *data, size_t len, int64_t now_ms);
+
+/**
+ * @brief Разбор одного бинарного кадра F0 05 <addr> <dist_cm> <rssi> AA
+ * @return true если кадр корректен и range заполнен
+ */
+bool uwb_parser_parse_frame(const uint8_t *frame, int64_t now_ms, uwb_range_t *range);
+
+/**
+ * @brief Заполнить идентификатор пира в range по строковому peerId
+ *
+ * "uwb_XXXX" (четыре заглавные hex-цифры) превращается в адрес, любое
+ * другое имя сохраняется как есть.
+ * @return false если имя пустое или не помещается в UWB_PEER_ID_LEN
+ */
+bool uwb_parser_set_peer(uwb_range_t *range, const char *peer_id, size_t len);
+
+/**
+ * @brief Совпадают ли идентификаторы пиров
+ */
+bool uwb_range_same_peer(const uwb_range_t *a, const uwb_range_t *b);
+
+/**
+ * @brief Записать строковый peerId ("uwb_XXXX" или имя) в buffer
+ * @return Длина строки без завершающего нуля
+ */
+size_t uwb_range_format_peer_id(const uwb_range_t *range, char *buffer, size_t buffer_size);
+
+/**
+ * @brief Разбор текстовой строки вида DIST,<peer>,<meters> и её вариантов
+ * @return true если строка распознана и range заполнен
+ */
+bool uwb_parser_parse_range_line(const char *line, int64_t now_ms, uwb_range_t *range);
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "esp_err.h"
+#include "uwb_parser.h"
+#include "uwb_range_store.h"
 #include <stdbool.h>
 #include <stdint.h>
 #include <stddef.h>
@@ -9,17 +11,6 @@
 extern "C" {
 #endif
 
-#define UWB_MAX_RANGES 3
-#define UWB_PEER_ID_LEN 32
-
-typedef struct {
-    char peer_id[UWB_PEER_ID_LEN];
-    float distance_m;
-    int rssi_dbm;
-    int64_t updated_at_ms;
-    bool valid;
-} uwb_range_t;
-
 typedef struct {
     int uart_num;
     int tx_pin;
@@ -31,6 +22,9 @@ typedef struct {
     uint8_t period;
     uint16_t local_address;
     uint16_t peer0_address;
+    bool rx_task_enabled;   ///< Читать UART в отдельной задаче по событиям драйвера
+    int rx_task_core;       ///< Ядро для задачи чтения
+    int rx_task_priority;   ///< Приоритет задачи чтения
 } uwb_positioning_config_t;
 
 typedef struct {
@@ -40,6 +34,7 @@ typedef struct {
     uint32_t invalid_frames;
     uint32_t parsed_lines;
     uint32_t invalid_lines;
+    uint32_t rx_overflows;
     int64_t last_byte_at_ms;
     char last_rx_hex[96];
     bool auto_config_enabled;
@@ -50,9 +45,23 @@ typedef struct {
     uint16_t peer0_address;
 } uwb_positioning_stats_t;
 
+/*
+ * Уведомление об изменении расстояния: вызывается из задачи разбора UART,
+ * когда сглаженное расстояние до пира сдвинулось на порог
+ * CONFIG_UWB_POSITIONING_CHANGE_THRESHOLD_MM или появился новый пир.
+ * Обработчик не должен блокироваться — только отметить, что есть новые данные.
+ */
+typedef void (*uwb_positioning_change_cb_t)(void *ctx);
+
 esp_err_t uwb_positioning_init(const uwb_positioning_config_t *config);
+/* Опрос UART из задания uwb; ничего не делает, если работает задача чтения */
 void uwb_positioning_task(void);
+/* Безопасно вызывать из любой задачи: каждая запись копируется целиком */
 size_t uwb_positioning_get_ranges(uwb_range_t *ranges, size_t max_ranges);
+/* Последние сырые измерения пира, от старых к новым */
+size_t uwb_positioning_get_history(const char *peer_id, uwb_range_sample_t *samples, size_t max_samples);
+/* Один обработчик на модуль; NULL отключает уведомления */
+void uwb_positioning_set_change_callback(uwb_positioning_change_cb_t callback, void *ctx);
 bool uwb_positioning_is_ready(void);
 void uwb_positioning_get_stats(uwb_positioning_stats_t *stats);
 
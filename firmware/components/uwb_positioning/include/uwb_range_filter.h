@@ -0,0 +1,47 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Сглаживание расстояния до одного пира в фиксированной точке.
+ * Повторяет smoothDistance из backend/server/utils/positioningRuntime.ts:
+ * медиана по 7 последним измерениям, EMA с уменьшенным коэффициентом для
+ * выбросов и мёртвая зона публикации.
+ */
+
+#define UWB_FILTER_SAMPLE_COUNT 7
+#define UWB_FILTER_ALPHA_Q16 14418          // 0.22
+#define UWB_FILTER_OUTLIER_ALPHA_Q16 5243   // 0.08
+#define UWB_FILTER_OUTLIER_GATE_MM 350
+#define UWB_FILTER_DEADBAND_MM 100
+
+typedef struct {
+    uint32_t samples_mm[UWB_FILTER_SAMPLE_COUNT];
+    uint8_t head;
+    uint8_t count;
+    int32_t filtered_q8;    ///< Сглаженное значение, мм * 256
+    uint32_t published_mm;  ///< Значение после мёртвой зоны
+    bool initialized;
+} uwb_range_filter_t;
+
+/**
+ * @brief Сбросить состояние фильтра (новый пир)
+ */
+void uwb_range_filter_reset(uwb_range_filter_t *filter);
+
+/**
+ * @brief Добавить сырое измерение
+ * @param filter Состояние фильтра
+ * @param raw_mm Сырое расстояние в миллиметрах
+ * @return Опубликованное сглаженное расстояние в миллиметрах
+ */
+uint32_t uwb_range_filter_update(uwb_range_filter_t *filter, uint32_t raw_mm);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,126 @@
+#pragma once
+
+#ifdef ESP_PLATFORM
+#include "sdkconfig.h"
+#endif
+
+#include "uwb_parser.h"
+#include "uwb_range_filter.h"
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Таблица последних расстояний до пиров с публикацией через seqlock.
+ *
+ * Писатель один (задача разбора UART), читателей может быть несколько
+ * (heartbeat, httpd). Писатель никогда не ждёт читателей; читатель повторяет
+ * копирование слота, если во время чтения слот был перезаписан, и поэтому
+ * всегда получает целостную запись uwb_range_t.
+ *
+ * Писатель находит слот пира через хеш-индекс по адресу (открытая адресация,
+ * линейное пробирование) и при заполнении таблицы вытесняет пир, дольше всех
+ * не присылавший измерений (LRU). Индекс и LRU-список принадлежат только
+ * писателю; читатели обходят слоты напрямую.
+ */
+
+#ifndef UWB_MAX_RANGES
+#ifdef CONFIG_UWB_POSITIONING_MAX_PEERS
+#define UWB_MAX_RANGES CONFIG_UWB_POSITIONING_MAX_PEERS
+#else
+#define UWB_MAX_RANGES 12
+#endif
+#endif
+
+// Индекс заполнен не более чем наполовину, размер — степень двойки
+#if UWB_MAX_RANGES <= 4
+#define UWB_RANGE_INDEX_SIZE 8
+#elif UWB_MAX_RANGES <= 8
+#define UWB_RANGE_INDEX_SIZE 16
+#elif UWB_MAX_RANGES <= 16
+#define UWB_RANGE_INDEX_SIZE 32
+#elif UWB_MAX_RANGES <= 32
+#define UWB_RANGE_INDEX_SIZE 64
+#elif UWB_MAX_RANGES <= 64
+#define UWB_RANGE_INDEX_SIZE 128
+#else
+#error "UWB_MAX_RANGES must not exceed 64"
+#endif
+
+#define UWB_RANGE_HISTORY_LEN 8
+
+typedef struct {
+    float distance_m;
+    int rssi_dbm;
+    int64_t at_ms;
+} uwb_range_sample_t;
+
+typedef struct {
+    atomic_uint seq;    ///< Нечётное значение — слот в процессе записи
+    uwb_range_t latest;
+    uwb_range_sample_t history[UWB_RANGE_HISTORY_LEN];
+    uint8_t history_head;
+    uint8_t history_count;
+    uwb_range_filter_t filter;
+    uint32_t reported_mm;   ///< Сглаженное расстояние на момент последнего уведомления
+} uwb_range_slot_t;
+
+typedef struct {
+    uwb_range_slot_t slots[UWB_MAX_RANGES];
+    uint8_t index[UWB_RANGE_INDEX_SIZE];    ///< Номер слота + 1, 0 — пусто
+    uint8_t lru_prev[UWB_MAX_RANGES];
+    uint8_t lru_next[UWB_MAX_RANGES];
+    uint8_t lru_head;                       ///< Самый свежий слот
+    uint8_t lru_tail;                       ///< Кандидат на вытеснение
+    uint8_t used;
+    uint32_t change_threshold_mm;           ///< Порог изменения для upsert, 0 — любое измерение
+} uwb_range_store_t;
+
+/**
+ * @brief Очистить таблицу (только пока нет параллельных читателей)
+ */
+void uwb_range_store_reset(uwb_range_store_t *store);
+
+/**
+ * @brief Задать порог, с которого upsert сообщает об изменении расстояния
+ */
+void uwb_range_store_set_change_threshold(uwb_range_store_t *store, uint32_t threshold_mm);
+
+/**
+ * @brief Записать новое расстояние (только из задачи-писателя)
+ *
+ * Обновляет слот пира или занимает свободный; при отсутствии свободных
+ * вытесняет самый давно обновлявшийся (O(1) в среднем). Пропускает измерение через фильтр
+ * пира и сохраняет результат в filtered_distance_m.
+ * @return true для нового пира или если сглаженное расстояние ушло от
+ *         последнего сообщённого не меньше чем на change_threshold_mm
+ */
+bool uwb_range_store_upsert(uwb_range_store_t *store, const uwb_range_t *range);
+
+/**
+ * @brief Получить целостные копии актуальных расстояний
+ * @param ranges Буфер для результата
+ * @param max_ranges Размер буфера
+ * @param now_ms Текущее время
+ * @param stale_after_ms Записи старше этого возраста пропускаются
+ * @return Количество скопированных записей
+ */
+size_t uwb_range_store_snapshot(uwb_range_store_t *store, uwb_range_t *ranges, size_t max_ranges,
+                                int64_t now_ms, int64_t stale_after_ms);
+
+/**
+ * @brief Получить историю сырых измерений пира (от старых к новым)
+ * @param peer_id Строковый peerId в том виде, в каком он сериализуется
+ * @return Количество скопированных измерений, 0 если пир не найден
+ */
+size_t uwb_range_store_get_history(uwb_range_store_t *store, const char *peer_id,
+                                   uwb_range_sample_t *samples, size_t max_samples);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,437 @@
+#include "uwb_parser.h"
+
+#include <string.h>
+
+#define UWB_PEER_PREFIX "uwb_"
+#define UWB_PEER_PREFIX_LEN 4
+#define UWB_PEER_HEX_DIGITS 4
+
+static const char s_hex_digits[] = "0123456789ABCDEF";
+
+static void emit_event(uwb_parser_t *parser, const uwb_parser_event_t *event)
+{
+    if (parser->callback != NULL) {
+        parser->callback(event, parser->callback_ctx);
+    }
+}
+
+static void trim_line(char *line)
+{
+    size_t len = strlen(line);
+    while (len > 0) {
+        char c = line[len - 1];
+        if (c != '\r' && c != '\n' && c != ' ' && c != '\t') {
+            break;
+        }
+        line[--len] = '\0';
+    }
+}
+
+/*
+ * Текстовые форматы в порядке приоритета. Разбор выполняется за один проход
+ * по строке: сначала запоминаются позиции разделителей, затем форматы из
+ * таблицы проверяются без повторного сканирования.
+ */
+typedef struct {
+    const char *prefix;
+    size_t prefix_len;
+    char separator;
+} uwb_line_format_t;
+
+static const uwb_line_format_t s_line_formats[] = {
+    {"DIST,", 5, ','},
+    {"DIST:", 5, ':'},
+    {"", 0, ','},
+    {"", 0, ':'},
+};
+
+#define UWB_LINE_SEPARATOR_SLOTS 2
+#define UWB_LINE_MAX_DISTANCE_MM 100000u
+
+typedef struct {
+    size_t positions[UWB_LINE_SEPARATOR_SLOTS];
+    size_t count;
+} uwb_separator_positions_t;
+
+static void remember_separator(uwb_separator_positions_t *positions, size_t index)
+{
+    if (positions->count < UWB_LINE_SEPARATOR_SLOTS) {
+        positions->positions[positions->count++] = index;
+    }
+}
+
+static bool find_separator(const uwb_separator_positions_t *positions, size_t from, size_t *index)
+{
+    for (size_t i = 0; i < positions->count; i++) {
+        if (positions->positions[i] >= from) {
+            *index = positions->positions[i];
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool is_scanf_space(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
+}
+
+/**
+ * @brief Разбор десятичного расстояния в метрах в миллиметры
+ *
+ * Принимает то же, что и %f для показаний MK8000: пробелы, знак, целую и
+ * дробную часть. Дробная часть округляется до миллиметра, хвост после числа
+ * игнорируется. Экспоненциальная запись, inf и nan отвергаются.
+ */
+static bool decode_distance_mm(const char *text, uint32_t *distance_mm)
+{
+    const char *p = text;
+    while (is_scanf_space(*p)) {
+        p++;
+    }
+
+    bool negative = false;
+    if (*p == '+' || *p == '-') {
+        negative = (*p == '-');
+        p++;
+    }
+
+    uint32_t whole_m = 0;
+    size_t digits = 0;
+    while (*p >= '0' && *p <= '9') {
+        if (whole_m <= UWB_LINE_MAX_DISTANCE_MM) {
+            whole_m = whole_m * 10u + (uint32_t)(*p - '0');
+        }
+        digits++;
+        p++;
+    }
+
+    uint32_t fraction_mm = 0;
+    if (*p == '.') {
+        p++;
+        uint32_t scale = 100;
+        bool round_up = false;
+        size_t fraction_digits = 0;
+        while (*p >= '0' && *p <= '9') {
+            if (fraction_digits < 3) {
+                fraction_mm += (uint32_t)(*p - '0') * scale;
+                scale /= 10u;
+            } else if (fraction_digits == 3) {
+                round_up = (*p >= '5');
+            }
+            fraction_digits++;
+            p++;
+        }
+        digits += fraction_digits;
+        if (round_up) {
+            fraction_mm++;
+        }
+    }
+
+    if (digits == 0 || *p == 'e' || *p == 'E') {
+        return false;
+    }
+
+    if (whole_m > UWB_LINE_MAX_DISTANCE_MM / 1000u) {
+        return false;
+    }
+
+    uint32_t value_mm = whole_m * 1000u + fraction_mm;
+    if (value_mm > UWB_LINE_MAX_DISTANCE_MM || (negative && value_mm != 0)) {
+        return false;
+    }
+
+    *distance_mm = value_mm;
+    return true;
+}
+
+static int upper_hex_value(char c)
+{
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+static uint16_t hash_peer_name(const char *name, size_t len)
+{
+    // FNV-1a, свёрнутый до 16 бит
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= (uint8_t)name[i];
+        hash *= 16777619u;
+    }
+    return (uint16_t)((hash >> 16) ^ (hash & 0xFFFFu));
+}
+
+bool uwb_parser_set_peer(uwb_range_t *range, const char *peer_id, size_t len)
+{
+    if (len == 0 || len >= UWB_PEER_ID_LEN) {
+        return false;
+    }
+
+    // Только каноническая форма, чтобы при сериализации получить ту же строку
+    if (len == UWB_PEER_PREFIX_LEN + UWB_PEER_HEX_DIGITS &&
+        memcmp(peer_id, UWB_PEER_PREFIX, UWB_PEER_PREFIX_LEN) == 0) {
+        uint16_t addr = 0;
+        size_t i = UWB_PEER_PREFIX_LEN;
+        for (; i < len; i++) {
+            int digit = upper_hex_value(peer_id[i]);
+            if (digit < 0) {
+                break;
+            }
+            addr = (uint16_t)((addr << 4) | (uint16_t)digit);
+        }
+        if (i == len) {
+            range->peer_addr = addr;
+            range->peer_named = false;
+            range->peer_name[0] = '\0';
+            return true;
+        }
+    }
+
+    memcpy(range->peer_name, peer_id, len);
+    range->peer_name[len] = '\0';
+    range->peer_addr = hash_peer_name(peer_id, len);
+    range->peer_named = true;
+    return true;
+}
+
+bool uwb_range_same_peer(const uwb_range_t *a, const uwb_range_t *b)
+{
+    if (a->peer_addr != b->peer_addr || a->peer_named != b->peer_named) {
+        return false;
+    }
+    return !a->peer_named || strncmp(a->peer_name, b->peer_name, UWB_PEER_ID_LEN) == 0;
+}
+
+size_t uwb_range_format_peer_id(const uwb_range_t *range, char *buffer, size_t buffer_size)
+{
+    if (buffer == NULL || buffer_size == 0) {
+        return 0;
+    }
+
+    if (range->peer_named) {
+        const char *end = memchr(range->peer_name, '\0', UWB_PEER_ID_LEN);
+        size_t len = end != NULL ? (size_t)(end - range->peer_name) : UWB_PEER_ID_LEN - 1;
+        if (len >= buffer_size) {
+            len = buffer_size - 1;
+        }
+        memcpy(buffer, range->peer_name, len);
+        buffer[len] = '\0';
+        return len;
+    }
+
+    char formatted[UWB_PEER_PREFIX_LEN + UWB_PEER_HEX_DIGITS + 1];
+    memcpy(formatted, UWB_PEER_PREFIX, UWB_PEER_PREFIX_LEN);
+    for (size_t i = 0; i < UWB_PEER_HEX_DIGITS; i++) {
+        unsigned shift = (unsigned)(UWB_PEER_HEX_DIGITS - 1 - i) * 4u;
+        formatted[UWB_PEER_PREFIX_LEN + i] = s_hex_digits[(range->peer_addr >> shift) & 0x0Fu];
+    }
+    formatted[sizeof(formatted) - 1] = '\0';
+
+    size_t len = sizeof(formatted) - 1;
+    if (len >= buffer_size) {
+        len = buffer_size - 1;
+    }
+    memcpy(buffer, formatted, len);
+    buffer[len] = '\0';
+    return len;
+}
+
+bool uwb_parser_parse_range_line(const char *line, int64_t now_ms, uwb_range_t *range)
+{
+    uwb_separator_positions_t commas = {0};
+    uwb_separator_positions_t colons = {0};
+    size_t len = 0;
+
+    for (; line[len] != '\0'; len++) {
+        if (line[len] == ',') {
+            remember_separator(&commas, len);
+        } else if (line[len] == ':') {
+            remember_separator(&colons, len);
+        }
+    }
+
+    for (size_t i = 0; i < sizeof(s_line_formats) / sizeof(s_line_formats[0]); i++) {
+        const uwb_line_format_t *format = &s_line_formats[i];
+        if (len < format->prefix_len || memcmp(line, format->prefix, format->prefix_len) != 0) {
+            continue;
+        }
+
+        size_t separator_index;
+        const uwb_separator_positions_t *positions = (format->separator == ',') ? &commas : &colons;
+        if (!find_separator(positions, format->prefix_len, &separator_index)) {
+            continue;
+        }
+
+        size_t peer_len = separator_index - format->prefix_len;
+        if (peer_len == 0 || peer_len >= UWB_PEER_ID_LEN) {
+            continue;
+        }
+
+        uint32_t distance_mm;
+        if (!decode_distance_mm(line + separator_index + 1, &distance_mm)) {
+            continue;
+        }
+
+        memset(range, 0, sizeof(*range));
+        uwb_parser_set_peer(range, line + format->prefix_len, peer_len);
+        range->distance_m = (float)distance_mm / 1000.0f;
+        range->rssi_dbm = 0;
+        range->updated_at_ms = now_ms;
+        range->valid = true;
+        return true;
+    }
+
+    return false;
+}
+
+bool uwb_parser_parse_frame(const uint8_t *frame, int64_t now_ms, uwb_range_t *range)
+{
+    if (frame[0] != UWB_FRAME_HEADER ||
+        frame[1] != UWB_FRAME_PAYLOAD_LEN ||
+        frame[7] != UWB_FRAME_TAIL) {
+        return false;
+    }
+
+    uint16_t peer_addr = (uint16_t)frame[2] | ((uint16_t)frame[3] << 8);
+    uint16_t distance_cm = (uint16_t)frame[4] | ((uint16_t)frame[5] << 8);
+    int rssi_dbm = (int)frame[6] - 256;
+
+    if (distance_cm > 10000) {
+        return false;
+    }
+
+    memset(range, 0, sizeof(*range));
+    range->peer_addr = peer_addr;
+    range->distance_m = (float)distance_cm / 100.0f;
+    range->rssi_dbm = rssi_dbm;
+    range->updated_at_ms = now_ms;
+    range->valid = true;
+    return true;
+}
+
+static void process_frame(uwb_parser_t *parser, int64_t now_ms)
+{
+    uwb_range_t range;
+    uwb_parser_event_t event = {0};
+
+    if (uwb_parser_parse_frame(parser->frame_buffer, now_ms, &range)) {
+        event.type = UWB_PARSER_EVENT_FRAME_RANGE;
+        event.range = &range;
+    } else {
+        event.type = UWB_PARSER_EVENT_FRAME_INVALID;
+    }
+    event.frame = parser->frame_buffer;
+    emit_event(parser, &event);
+}
+
+static void process_line(uwb_parser_t *parser, int64_t now_ms)
+{
+    char *line = parser->line_buffer;
+    trim_line(line);
+    if (line[0] == '\0') {
+        return;
+    }
+
+    uwb_range_t range;
+    uwb_parser_event_t event = {0};
+    event.line = line;
+
+    if (uwb_parser_parse_range_line(line, now_ms, &range)) {
+        event.type = UWB_PARSER_EVENT_LINE_RANGE;
+        event.range = &range;
+    } else {
+        event.type = UWB_PARSER_EVENT_LINE_INVALID;
+    }
+    emit_event(parser, &event);
+}
+
+static void process_byte(uwb_parser_t *parser, uint8_t byte, int64_t now_ms, size_t *processed_lines)
+{
+    if (parser->frame_length == 0) {
+        if (byte == UWB_FRAME_HEADER) {
+            parser->frame_buffer[parser->frame_length++] = byte;
+            return;
+        }
+    } else {
+        parser->frame_buffer[parser->frame_length++] = byte;
+
+        if (parser->frame_length == 2 && parser->frame_buffer[1] != UWB_FRAME_PAYLOAD_LEN) {
+            uwb_parser_event_t event = {
+                .type = UWB_PARSER_EVENT_FRAME_BAD_LENGTH,
+                .byte = parser->frame_buffer[1],
+            };
+            parser->frame_length = 0;
+            emit_event(parser, &event);
+            return;
+        }
+
+        if (parser->frame_length == UWB_FRAME_SIZE) {
+            process_frame(parser, now_ms);
+            parser->frame_length = 0;
+        }
+
+        return;
+    }
+
+    char c = (char)byte;
+    if (c == '\n' || c == '\r') {
+        if (parser->line_length > 0) {
+            parser->line_buffer[parser->line_length] = '\0';
+            process_line(parser, now_ms);
+            parser->line_length = 0;
+            (*processed_lines)++;
+        }
+        return;
+    }
+
+    if (c >= 32 && c <= 126) {
+        if (parser->line_length < (sizeof(parser->line_buffer) - 1)) {
+            parser->line_buffer[parser->line_length++] = c;
+        } else {
+            parser->line_buffer[sizeof(parser->line_buffer) - 1] = '\0';
+            uwb_parser_event_t event = {
+                .type = UWB_PARSER_EVENT_LINE_OVERFLOW,
+                .line = parser->line_buffer,
+            };
+            emit_event(parser, &event);
+            parser->line_length = 0;
+        }
+        return;
+    }
+
+    uwb_parser_event_t event = {
+        .type = UWB_PARSER_EVENT_DISCARDED_BYTE,
+        .byte = byte,
+    };
+    emit_event(parser, &event);
+}
+
+void uwb_parser_init(uwb_parser_t *parser, uwb_parser_event_cb_t callback, void *ctx)
+{
+    memset(parser, 0, sizeof(*parser));
+    parser->callback = callback;
+    parser->callback_ctx = ctx;
+}
+
+void uwb_parser_reset(uwb_parser_t *parser)
+{
+    memset(parser->line_buffer, 0, sizeof(parser->line_buffer));
+    parser->line_length = 0;
+    memset(parser->frame_buffer, 0, sizeof(parser->frame_buffer));
+    parser->frame_length = 0;
+}
+
+size_t uwb_parser_feed(uwb_parser_t *parser, const uint8_t *data, size_t len, int64_t now_ms)
+{
+    size_t processed_lines = 0;
+    for (size_t i = 0; i < len; i++) {
+        process_byte(parser, data[i], now_ms, &processed_lines);
+    }
+    return processed_lines;
+}
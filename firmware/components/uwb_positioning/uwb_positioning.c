@@ -1,25 +1,37 @@
 #include "uwb_positioning.h"
+#include "uwb_parser.h"
+#include "uwb_range_store.h"
 
 #include "driver/uart.h"
 #include "esp_log.h"
 #include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
 #include <inttypes.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
 #define UWB_RX_BUFFER_SIZE 1024
-#define UWB_LINE_BUFFER_SIZE 128
+#define UWB_RX_CHUNK_SIZE 128
+#define UWB_RX_EVENT_QUEUE_SIZE 20
+#define UWB_RX_TIMEOUT_SYMBOLS 3
+#define UWB_RX_FULL_THRESHOLD 64
+#define UWB_RX_PATTERN_QUEUE_SIZE 16
+#define UWB_RX_TASK_STACK_SIZE 4096
+#define UWB_RX_IDLE_WAIT_MS 1000
 #define UWB_MAX_LINES_PER_POLL 8
-#define UWB_FRAME_SIZE 8
-#define UWB_FRAME_HEADER 0xF0
-#define UWB_FRAME_PAYLOAD_LEN 0x05
-#define UWB_FRAME_TAIL 0xAA
 #define UWB_STALE_AFTER_MS 5000
 #define UWB_LOG_INTERVAL_MS 1000
 #define UWB_AT_RESPONSE_BUFFER_SIZE 160
 
+#ifdef CONFIG_UWB_POSITIONING_CHANGE_THRESHOLD_MM
+#define UWB_CHANGE_THRESHOLD_MM CONFIG_UWB_POSITIONING_CHANGE_THRESHOLD_MM
+#else
+#define UWB_CHANGE_THRESHOLD_MM 50
+#endif
+
 static const char *TAG = "UWB_POSITIONING";
 
 static uwb_positioning_config_t s_config = {
@@ -33,112 +45,34 @@ static uwb_positioning_config_t s_config = {
     .period = 5,
     .local_address = 0x0000,
     .peer0_address = 0x0001,
+    .rx_task_enabled = false,
+    .rx_task_core = 1,
+    .rx_task_priority = 6,
 };
 
 static bool s_ready = false;
 static int64_t s_last_log_ms = 0;
 static int64_t s_last_rx_diag_ms = 0;
-static uwb_range_t s_ranges[UWB_MAX_RANGES] = {0};
+static uwb_range_store_t s_range_store;
 static uwb_positioning_stats_t s_stats = {0};
-static char s_line_buffer[UWB_LINE_BUFFER_SIZE];
-static size_t s_line_length = 0;
-static uint8_t s_frame_buffer[UWB_FRAME_SIZE];
-static size_t s_frame_length = 0;
+// Статистику пишет задача uwb_rx на своём ядре, читает heartbeat на другом
+static portMUX_TYPE s_stats_lock = portMUX_INITIALIZER_UNLOCKED;
+static uwb_parser_t s_parser;
+static QueueHandle_t s_uart_queue = NULL;
+static TaskHandle_t s_rx_task = NULL;
+static uwb_positioning_change_cb_t s_change_cb = NULL;
+static void *s_change_cb_ctx = NULL;
 
 static int64_t now_ms(void)
 {
     return esp_timer_get_time() / 1000;
 }
 
-static void trim_line(char *line)
-{
-    size_t len = strlen(line);
-    while (len > 0) {
-        char c = line[len - 1];
-        if (c != '\r' && c != '\n' && c != ' ' && c != '\t') {
-            break;
-        }
-        line[--len] = '\0';
-    }
-}
-
-static bool parse_range_line(const char *line, uwb_range_t *range)
-{
-    char peer_id[UWB_PEER_ID_LEN] = {0};
-    float distance_m = 0.0f;
-
-    if (sscanf(line, "DIST,%31[^,],%f", peer_id, &distance_m) == 2 ||
-        sscanf(line, "DIST:%31[^:]:%f", peer_id, &distance_m) == 2 ||
-        sscanf(line, "%31[^,],%f", peer_id, &distance_m) == 2 ||
-        sscanf(line, "%31[^:]:%f", peer_id, &distance_m) == 2) {
-        if (peer_id[0] == '\0' || distance_m < 0.0f || distance_m > 100.0f) {
-            return false;
-        }
-
-        memset(range, 0, sizeof(*range));
-        snprintf(range->peer_id, sizeof(range->peer_id), "%s", peer_id);
-        range->distance_m = distance_m;
-        range->rssi_dbm = 0;
-        range->updated_at_ms = now_ms();
-        range->valid = true;
-        return true;
-    }
-
-    return false;
-}
-
-static bool parse_mk8000_frame(const uint8_t *frame, uwb_range_t *range)
+static void count_stat(uint32_t *counter)
 {
-    if (frame[0] != UWB_FRAME_HEADER ||
-        frame[1] != UWB_FRAME_PAYLOAD_LEN ||
-        frame[7] != UWB_FRAME_TAIL) {
-        return false;
-    }
-
-    uint16_t peer_addr = (uint16_t)frame[2] | ((uint16_t)frame[3] << 8);
-    uint16_t distance_cm = (uint16_t)frame[4] | ((uint16_t)frame[5] << 8);
-    int rssi_dbm = (int)frame[6] - 256;
-
-    if (distance_cm > 10000) {
-        return false;
-    }
-
-    memset(range, 0, sizeof(*range));
-    snprintf(range->peer_id, sizeof(range->peer_id), "uwb_%04X", peer_addr);
-    range->distance_m = (float)distance_cm / 100.0f;
-    range->rssi_dbm = rssi_dbm;
-    range->updated_at_ms = now_ms();
-    range->valid = true;
-    return true;
-}
-
-static void upsert_range(const uwb_range_t *range)
-{
-    size_t free_index = UWB_MAX_RANGES;
-
-    for (size_t i = 0; i < UWB_MAX_RANGES; i++) {
-        if (s_ranges[i].valid && strncmp(s_ranges[i].peer_id, range->peer_id, UWB_PEER_ID_LEN) == 0) {
-            s_ranges[i] = *range;
-            return;
-        }
-
-        if (!s_ranges[i].valid && free_index == UWB_MAX_RANGES) {
-            free_index = i;
-        }
-    }
-
-    if (free_index < UWB_MAX_RANGES) {
-        s_ranges[free_index] = *range;
-        return;
-    }
-
-    size_t oldest_index = 0;
-    for (size_t i = 1; i < UWB_MAX_RANGES; i++) {
-        if (s_ranges[i].updated_at_ms < s_ranges[oldest_index].updated_at_ms) {
-            oldest_index = i;
-        }
-    }
-    s_ranges[oldest_index] = *range;
+    portENTER_CRITICAL(&s_stats_lock);
+    (*counter)++;
+    portEXIT_CRITICAL(&s_stats_lock);
 }
 
 static bool should_log_now(void)
@@ -152,46 +86,71 @@ static bool should_log_now(void)
     return true;
 }
 
-static void process_mk8000_frame(const uint8_t *frame)
+static void store_range(const uwb_range_t *range)
 {
-    uwb_range_t range;
-    if (parse_mk8000_frame(frame, &range)) {
-        s_stats.parsed_frames++;
-        upsert_range(&range);
-        ESP_LOGI(TAG, "Parsed MK8000 range: peer=%s distance=%.2fm rssi=%ddBm",
-                 range.peer_id, (double)range.distance_m, range.rssi_dbm);
-        return;
-    }
-
-    s_stats.invalid_frames++;
-    if (should_log_now()) {
-        ESP_LOGW(TAG,
-                 "Invalid MK8000 frame: %02X %02X %02X %02X %02X %02X %02X %02X",
-                 frame[0], frame[1], frame[2], frame[3],
-                 frame[4], frame[5], frame[6], frame[7]);
+    if (uwb_range_store_upsert(&s_range_store, range) && s_change_cb != NULL) {
+        s_change_cb(s_change_cb_ctx);
     }
 }
 
-static void process_uart_line(char *line)
+static void handle_parser_event(const uwb_parser_event_t *event, void *ctx)
 {
-    trim_line(line);
-    if (line[0] == '\0') {
-        return;
-    }
+    (void)ctx;
+
+    switch (event->type) {
+        case UWB_PARSER_EVENT_FRAME_RANGE:
+            count_stat(&s_stats.parsed_frames);
+            store_range(event->range);
+            ESP_LOGI(TAG, "Parsed MK8000 range: peer=uwb_%04X distance=%.2fm rssi=%ddBm",
+                     event->range->peer_addr, (double)event->range->distance_m, event->range->rssi_dbm);
+            break;
 
-    ESP_LOGI(TAG, "UWB UART line: %s", line);
+        case UWB_PARSER_EVENT_FRAME_INVALID:
+            count_stat(&s_stats.invalid_frames);
+            if (should_log_now()) {
+                const uint8_t *frame = event->frame;
+                ESP_LOGW(TAG,
+                         "Invalid MK8000 frame: %02X %02X %02X %02X %02X %02X %02X %02X",
+                         frame[0], frame[1], frame[2], frame[3],
+                         frame[4], frame[5], frame[6], frame[7]);
+            }
+            break;
 
-    uwb_range_t range;
-    if (parse_range_line(line, &range)) {
-        s_stats.parsed_lines++;
-        upsert_range(&range);
-        ESP_LOGI(TAG, "Parsed UWB range: peer=%s distance=%.3fm",
-                 range.peer_id, (double)range.distance_m);
-        return;
-    }
+        case UWB_PARSER_EVENT_FRAME_BAD_LENGTH:
+            count_stat(&s_stats.invalid_frames);
+            if (should_log_now()) {
+                ESP_LOGW(TAG, "Dropping MK8000 frame with unexpected length byte: 0x%02X", event->byte);
+            }
+            break;
+
+        case UWB_PARSER_EVENT_LINE_RANGE: {
+            char peer_id[UWB_PEER_ID_LEN];
+            ESP_LOGI(TAG, "UWB UART line: %s", event->line);
+            count_stat(&s_stats.parsed_lines);
+            store_range(event->range);
+            uwb_range_format_peer_id(event->range, peer_id, sizeof(peer_id));
+            ESP_LOGI(TAG, "Parsed UWB range: peer=%s distance=%.3fm",
+                     peer_id, (double)event->range->distance_m);
+            break;
+        }
+
+        case UWB_PARSER_EVENT_LINE_INVALID:
+            ESP_LOGI(TAG, "UWB UART line: %s", event->line);
+            count_stat(&s_stats.invalid_lines);
+            ESP_LOGW(TAG, "UWB line format is not recognized yet");
+            break;
 
-    s_stats.invalid_lines++;
-    ESP_LOGW(TAG, "UWB line format is not recognized yet");
+        case UWB_PARSER_EVENT_LINE_OVERFLOW:
+            ESP_LOGW(TAG, "Dropping overlong UWB UART line: %s", event->line);
+            break;
+
+        case UWB_PARSER_EVENT_DISCARDED_BYTE:
+            count_stat(&s_stats.discarded_bytes);
+            if (should_log_now()) {
+                ESP_LOGW(TAG, "Discarding non-frame non-text UWB byte: 0x%02X", event->byte);
+            }
+            break;
+    }
 }
 
 static void log_rx_diagnostics(const uint8_t *bytes, int bytes_read)
@@ -232,23 +191,28 @@ static void remember_rx_hex(const uint8_t *bytes, int bytes_read)
         return;
     }
 
+    char hex[sizeof(s_stats.last_rx_hex)] = {0};
     size_t offset = 0;
     int dump_len = bytes_read < 16 ? bytes_read : 16;
-    memset(s_stats.last_rx_hex, 0, sizeof(s_stats.last_rx_hex));
-    for (int i = 0; i < dump_len && offset < sizeof(s_stats.last_rx_hex); i++) {
-        int written = snprintf(s_stats.last_rx_hex + offset,
-                               sizeof(s_stats.last_rx_hex) - offset,
+    for (int i = 0; i < dump_len && offset < sizeof(hex); i++) {
+        int written = snprintf(hex + offset, sizeof(hex) - offset,
                                "%02X%s", bytes[i], i == dump_len - 1 ? "" : " ");
         if (written <= 0) {
             break;
         }
         offset += (size_t)written;
     }
+
+    portENTER_CRITICAL(&s_stats_lock);
+    memcpy(s_stats.last_rx_hex, hex, sizeof(hex));
+    portEXIT_CRITICAL(&s_stats_lock);
 }
 
 static void reset_parser_state(void)
 {
-    memset(s_ranges, 0, sizeof(s_ranges));
+    uwb_range_store_reset(&s_range_store);
+    uwb_range_store_set_change_threshold(&s_range_store, UWB_CHANGE_THRESHOLD_MM);
+    portENTER_CRITICAL(&s_stats_lock);
     memset(&s_stats, 0, sizeof(s_stats));
     s_stats.auto_config_enabled = s_config.auto_config_enabled;
     s_stats.role = s_config.role;
@@ -256,10 +220,8 @@ static void reset_parser_state(void)
     s_stats.period = s_config.period;
     s_stats.local_address = s_config.local_address;
     s_stats.peer0_address = s_config.peer0_address;
-    memset(s_line_buffer, 0, sizeof(s_line_buffer));
-    s_line_length = 0;
-    memset(s_frame_buffer, 0, sizeof(s_frame_buffer));
-    s_frame_length = 0;
+    portEXIT_CRITICAL(&s_stats_lock);
+    uwb_parser_init(&s_parser, handle_parser_event, NULL);
 }
 
 static esp_err_t write_at_command(const char *command)
@@ -340,59 +302,101 @@ static void configure_mk8000(void)
     ESP_LOGI(TAG, "MK8000 auto-configuration finished");
 }
 
-static void process_rx_byte(uint8_t byte, int *processed_lines)
+static size_t consume_rx_bytes(const uint8_t *bytes, int bytes_read)
 {
-    if (s_frame_length == 0) {
-        if (byte == UWB_FRAME_HEADER) {
-            s_frame_buffer[s_frame_length++] = byte;
-            return;
-        }
-    } else {
-        s_frame_buffer[s_frame_length++] = byte;
+    int64_t received_ms = now_ms();
+    portENTER_CRITICAL(&s_stats_lock);
+    s_stats.total_bytes += (uint32_t)bytes_read;
+    s_stats.last_byte_at_ms = received_ms;
+    portEXIT_CRITICAL(&s_stats_lock);
+    remember_rx_hex(bytes, bytes_read);
+    log_rx_diagnostics(bytes, bytes_read);
+
+    return uwb_parser_feed(&s_parser, bytes, (size_t)bytes_read, received_ms);
+}
 
-        if (s_frame_length == 2 && s_frame_buffer[1] != UWB_FRAME_PAYLOAD_LEN) {
-            s_stats.invalid_frames++;
-            if (should_log_now()) {
-                ESP_LOGW(TAG, "Dropping MK8000 frame with unexpected length byte: 0x%02X", s_frame_buffer[1]);
-            }
-            s_frame_length = 0;
-            return;
-        }
+static void drain_uart_rx(void)
+{
+    uint8_t rx_buffer[UWB_RX_CHUNK_SIZE];
 
-        if (s_frame_length == UWB_FRAME_SIZE) {
-            process_mk8000_frame(s_frame_buffer);
-            s_frame_length = 0;
+    while (1) {
+        int bytes_read = uart_read_bytes(s_config.uart_num, rx_buffer, sizeof(rx_buffer), 0);
+        if (bytes_read <= 0) {
+            break;
         }
-
-        return;
+        consume_rx_bytes(rx_buffer, bytes_read);
     }
+}
 
-    char c = (char)byte;
-    if (c == '\n' || c == '\r') {
-        if (s_line_length > 0) {
-            s_line_buffer[s_line_length] = '\0';
-            process_uart_line(s_line_buffer);
-            s_line_length = 0;
-            (*processed_lines)++;
+/**
+ * @brief Задача чтения UART по событиям драйвера
+ *
+ * Просыпается по таймауту приёма, порогу FIFO или символу '\n' и разбирает
+ * данные сразу, не дожидаясь очередного выпуска задания uwb.
+ */
+static void uwb_rx_task(void *pvParameters)
+{
+    uart_event_t event;
+
+    ESP_LOGI(TAG, "UWB UART reader task started on core %d", s_config.rx_task_core);
+
+    while (1) {
+        if (xQueueReceive(s_uart_queue, &event, pdMS_TO_TICKS(UWB_RX_IDLE_WAIT_MS)) != pdTRUE) {
+            log_rx_diagnostics(NULL, 0);
+            continue;
         }
-        return;
-    }
 
-    if (c >= 32 && c <= 126) {
-        if (s_line_length < (sizeof(s_line_buffer) - 1)) {
-            s_line_buffer[s_line_length++] = c;
-        } else {
-            s_line_buffer[sizeof(s_line_buffer) - 1] = '\0';
-            ESP_LOGW(TAG, "Dropping overlong UWB UART line: %s", s_line_buffer);
-            s_line_length = 0;
+        switch (event.type) {
+            case UART_DATA:
+                drain_uart_rx();
+                break;
+
+            case UART_PATTERN_DET:
+                drain_uart_rx();
+                // Позиции шаблона не используются: данные уже вычитаны целиком
+                uart_pattern_queue_reset(s_config.uart_num, UWB_RX_PATTERN_QUEUE_SIZE);
+                break;
+
+            case UART_FIFO_OVF:
+            case UART_BUFFER_FULL:
+                count_stat(&s_stats.rx_overflows);
+                if (should_log_now()) {
+                    ESP_LOGW(TAG, "UWB UART overflow (%s), flushing input",
+                             event.type == UART_FIFO_OVF ? "fifo" : "ring buffer");
+                }
+                uart_flush_input(s_config.uart_num);
+                xQueueReset(s_uart_queue);
+                uwb_parser_reset(&s_parser);
+                break;
+
+            default:
+                break;
         }
-        return;
     }
+}
+
+static esp_err_t start_rx_task(void)
+{
+    uart_set_rx_timeout(s_config.uart_num, UWB_RX_TIMEOUT_SYMBOLS);
+    uart_set_rx_full_threshold(s_config.uart_num, UWB_RX_FULL_THRESHOLD);
+    uart_enable_pattern_det_baud_intr(s_config.uart_num, '\n', 1, 9, 0, 0);
+    uart_pattern_queue_reset(s_config.uart_num, UWB_RX_PATTERN_QUEUE_SIZE);
 
-    s_stats.discarded_bytes++;
-    if (should_log_now()) {
-        ESP_LOGW(TAG, "Discarding non-frame non-text UWB byte: 0x%02X", byte);
+    // События, накопленные во время AT-конфигурации, уже не актуальны
+    uart_flush_input(s_config.uart_num);
+    xQueueReset(s_uart_queue);
+
+    BaseType_t created = xTaskCreatePinnedToCore(uwb_rx_task, "uwb_rx",
+                                                 UWB_RX_TASK_STACK_SIZE, NULL,
+                                                 s_config.rx_task_priority, &s_rx_task,
+                                                 s_config.rx_task_core);
+    if (created != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create UWB reader task, falling back to polling");
+        s_rx_task = NULL;
+        return ESP_ERR_NO_MEM;
     }
+
+    return ESP_OK;
 }
 
 esp_err_t uwb_positioning_init(const uwb_positioning_config_t *config)
@@ -410,7 +414,9 @@ esp_err_t uwb_positioning_init(const uwb_positioning_config_t *config)
         .source_clk = UART_SCLK_DEFAULT,
     };
 
-    esp_err_t ret = uart_driver_install(s_config.uart_num, UWB_RX_BUFFER_SIZE, 0, 0, NULL, 0);
+    esp_err_t ret = uart_driver_install(s_config.uart_num, UWB_RX_BUFFER_SIZE, 0,
+                                        s_config.rx_task_enabled ? UWB_RX_EVENT_QUEUE_SIZE : 0,
+                                        s_config.rx_task_enabled ? &s_uart_queue : NULL, 0);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to install UART driver: %s", esp_err_to_name(ret));
         return ret;
@@ -437,6 +443,10 @@ esp_err_t uwb_positioning_init(const uwb_positioning_config_t *config)
     s_last_rx_diag_ms = s_last_log_ms;
     s_ready = true;
 
+    if (s_config.rx_task_enabled) {
+        start_rx_task();
+    }
+
     ESP_LOGI(TAG, "Initialized UWB UART: uart=%d tx=GPIO%d rx=GPIO%d baud=%d",
              s_config.uart_num, s_config.tx_pin, s_config.rx_pin, s_config.baud_rate);
     ESP_LOGI(TAG, "MK8000 config: auto=%s role=%d pid=%u period=%u local=%04X peer0=%04X",
@@ -445,18 +455,19 @@ esp_err_t uwb_positioning_init(const uwb_positioning_config_t *config)
              s_config.local_address, s_config.peer0_address);
     ESP_LOGI(TAG, "Expecting MK8000 binary frames: F0 05 <addr_lo> <addr_hi> <dist_lo> <dist_hi> <rssi> AA");
     ESP_LOGI(TAG, "Diagnostic text lines like 'DIST,<peer>,<meters>' remain supported");
+    ESP_LOGI(TAG, "UART reading mode: %s", s_rx_task != NULL ? "event-driven task" : "polling");
 
     return ESP_OK;
 }
 
 void uwb_positioning_task(void)
 {
-    if (!s_ready) {
+    if (!s_ready || s_rx_task != NULL) {
         return;
     }
 
-    uint8_t rx_buffer[128];
-    int processed_lines = 0;
+    uint8_t rx_buffer[UWB_RX_CHUNK_SIZE];
+    size_t processed_lines = 0;
 
     while (processed_lines < UWB_MAX_LINES_PER_POLL) {
         int bytes_read = uart_read_bytes(s_config.uart_num, rx_buffer, sizeof(rx_buffer), 0);
@@ -465,14 +476,7 @@ void uwb_positioning_task(void)
             break;
         }
 
-        s_stats.total_bytes += (uint32_t)bytes_read;
-        s_stats.last_byte_at_ms = now_ms();
-        remember_rx_hex(rx_buffer, bytes_read);
-        log_rx_diagnostics(rx_buffer, bytes_read);
-
-        for (int i = 0; i < bytes_read; i++) {
-            process_rx_byte(rx_buffer[i], &processed_lines);
-        }
+        processed_lines += consume_rx_bytes(rx_buffer, bytes_read);
     }
 }
 
@@ -482,15 +486,18 @@ size_t uwb_positioning_get_ranges(uwb_range_t *ranges, size_t max_ranges)
         return 0;
     }
 
-    size_t count = 0;
-    int64_t current_ms = now_ms();
-    for (size_t i = 0; i < UWB_MAX_RANGES && count < max_ranges; i++) {
-        if (s_ranges[i].valid && (current_ms - s_ranges[i].updated_at_ms) <= UWB_STALE_AFTER_MS) {
-            ranges[count++] = s_ranges[i];
-        }
-    }
+    return uwb_range_store_snapshot(&s_range_store, ranges, max_ranges, now_ms(), UWB_STALE_AFTER_MS);
+}
+
+size_t uwb_positioning_get_history(const char *peer_id, uwb_range_sample_t *samples, size_t max_samples)
+{
+    return uwb_range_store_get_history(&s_range_store, peer_id, samples, max_samples);
+}
 
-    return count;
+void uwb_positioning_set_change_callback(uwb_positioning_change_cb_t callback, void *ctx)
+{
+    s_change_cb_ctx = ctx;
+    s_change_cb = callback;
 }
 
 bool uwb_positioning_is_ready(void)
@@ -503,5 +510,7 @@ void uwb_positioning_get_stats(uwb_positioning_stats_t *stats)
     if (stats == NULL) {
         return;
     }
+    portENTER_CRITICAL(&s_stats_lock);
     *stats = s_stats;
+    portEXIT_CRITICAL(&s_stats_lock);
 }
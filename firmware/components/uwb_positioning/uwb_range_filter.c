@@ -0,0 +1,65 @@
+#include "uwb_range_filter.h"
+
+#include <string.h>
+
+static uint32_t window_median(const uwb_range_filter_t *filter)
+{
+    uint32_t sorted[UWB_FILTER_SAMPLE_COUNT];
+    size_t count = filter->count;
+
+    memcpy(sorted, filter->samples_mm, count * sizeof(sorted[0]));
+    for (size_t i = 1; i < count; i++) {
+        uint32_t value = sorted[i];
+        size_t j = i;
+        while (j > 0 && sorted[j - 1] > value) {
+            sorted[j] = sorted[j - 1];
+            j--;
+        }
+        sorted[j] = value;
+    }
+
+    size_t middle = count / 2;
+    if (count % 2 == 0) {
+        return (sorted[middle - 1] + sorted[middle]) / 2;
+    }
+    return sorted[middle];
+}
+
+void uwb_range_filter_reset(uwb_range_filter_t *filter)
+{
+    memset(filter, 0, sizeof(*filter));
+}
+
+uint32_t uwb_range_filter_update(uwb_range_filter_t *filter, uint32_t raw_mm)
+{
+    if (!filter->initialized) {
+        filter->filtered_q8 = (int32_t)(raw_mm << 8);
+        filter->published_mm = raw_mm;
+        filter->initialized = true;
+    }
+
+    // Окно хранится кольцом: порядок для медианы не важен
+    filter->samples_mm[filter->head] = raw_mm;
+    filter->head = (uint8_t)((filter->head + 1) % UWB_FILTER_SAMPLE_COUNT);
+    if (filter->count < UWB_FILTER_SAMPLE_COUNT) {
+        filter->count++;
+    }
+
+    int32_t median_q8 = (int32_t)(window_median(filter) << 8);
+    int32_t delta_q8 = median_q8 - filter->filtered_q8;
+    int32_t gate_q8 = UWB_FILTER_OUTLIER_GATE_MM << 8;
+    int32_t alpha_q16 = (delta_q8 > gate_q8 || delta_q8 < -gate_q8)
+        ? UWB_FILTER_OUTLIER_ALPHA_Q16
+        : UWB_FILTER_ALPHA_Q16;
+    filter->filtered_q8 += (int32_t)(((int64_t)delta_q8 * alpha_q16) / 65536);
+
+    uint32_t filtered_mm = (uint32_t)((filter->filtered_q8 + 128) >> 8);
+    uint32_t published_delta = filtered_mm > filter->published_mm
+        ? filtered_mm - filter->published_mm
+        : filter->published_mm - filtered_mm;
+    if (published_delta >= UWB_FILTER_DEADBAND_MM) {
+        filter->published_mm = filtered_mm;
+    }
+
+    return filter->published_mm;
+}
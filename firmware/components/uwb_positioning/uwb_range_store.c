@@ -0,0 +1,285 @@
+#include "uwb_range_store.h"
+
+#include <string.h>
+
+#ifdef ESP_PLATFORM
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#endif
+
+// После стольких неудачных попыток читатель уступает процессор писателю
+#define UWB_SEQLOCK_SPINS_BEFORE_YIELD 16
+
+#define UWB_RANGE_INDEX_MASK (UWB_RANGE_INDEX_SIZE - 1)
+#define UWB_RANGE_NONE 0xFF
+
+static void seqlock_backoff(unsigned *spins)
+{
+    if (++(*spins) < UWB_SEQLOCK_SPINS_BEFORE_YIELD) {
+        return;
+    }
+    *spins = 0;
+#ifdef ESP_PLATFORM
+    // Писатель мог быть вытеснен посреди записи задачей с тем же или более
+    // высоким приоритетом на этом же ядре — даём ему доработать
+    vTaskDelay(1);
+#endif
+}
+
+static void write_begin(uwb_range_slot_t *slot)
+{
+    unsigned seq = atomic_load_explicit(&slot->seq, memory_order_relaxed);
+    atomic_store_explicit(&slot->seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+}
+
+static void write_end(uwb_range_slot_t *slot)
+{
+    unsigned seq = atomic_load_explicit(&slot->seq, memory_order_relaxed);
+    atomic_store_explicit(&slot->seq, seq + 1, memory_order_release);
+}
+
+static unsigned read_begin(const uwb_range_slot_t *slot)
+{
+    unsigned spins = 0;
+    unsigned seq;
+    while ((seq = atomic_load_explicit(&slot->seq, memory_order_acquire)) & 1u) {
+        seqlock_backoff(&spins);
+    }
+    return seq;
+}
+
+static bool read_retry(const uwb_range_slot_t *slot, unsigned seq)
+{
+    atomic_thread_fence(memory_order_acquire);
+    return atomic_load_explicit(&slot->seq, memory_order_relaxed) != seq;
+}
+
+static uint32_t write_slot(uwb_range_slot_t *slot, const uwb_range_t *range, bool new_peer)
+{
+    write_begin(slot);
+
+    if (new_peer) {
+        slot->history_head = 0;
+        slot->history_count = 0;
+        uwb_range_filter_reset(&slot->filter);
+    }
+
+    uint32_t raw_mm = (uint32_t)(range->distance_m * 1000.0f + 0.5f);
+    uint32_t filtered_mm = uwb_range_filter_update(&slot->filter, raw_mm);
+
+    slot->latest = *range;
+    slot->latest.filtered_distance_m = (float)filtered_mm / 1000.0f;
+
+    uwb_range_sample_t *sample = &slot->history[slot->history_head];
+    sample->distance_m = range->distance_m;
+    sample->rssi_dbm = range->rssi_dbm;
+    sample->at_ms = range->updated_at_ms;
+    slot->history_head = (uint8_t)((slot->history_head + 1) % UWB_RANGE_HISTORY_LEN);
+    if (slot->history_count < UWB_RANGE_HISTORY_LEN) {
+        slot->history_count++;
+    }
+
+    write_end(slot);
+    return filtered_mm;
+}
+
+static bool report_change(const uwb_range_store_t *store, uwb_range_slot_t *slot,
+                          uint32_t filtered_mm, bool new_peer)
+{
+    // reported_mm читает и пишет только писатель, поэтому вне seqlock
+    uint32_t delta = filtered_mm > slot->reported_mm
+        ? filtered_mm - slot->reported_mm
+        : slot->reported_mm - filtered_mm;
+    if (!new_peer && delta < store->change_threshold_mm) {
+        return false;
+    }
+    slot->reported_mm = filtered_mm;
+    return true;
+}
+
+static size_t index_home(const uwb_range_t *range)
+{
+    // Мультипликативное перемешивание: адреса якорей обычно идут подряд
+    uint32_t key = (uint32_t)range->peer_addr | (range->peer_named ? 0x10000u : 0u);
+    return (size_t)((key * 2654435761u) >> 16) & UWB_RANGE_INDEX_MASK;
+}
+
+static size_t index_find(const uwb_range_store_t *store, const uwb_range_t *range, bool *found)
+{
+    size_t pos = index_home(range);
+    while (store->index[pos] != 0) {
+        const uwb_range_t *latest = &store->slots[store->index[pos] - 1].latest;
+        if (uwb_range_same_peer(latest, range)) {
+            *found = true;
+            return pos;
+        }
+        pos = (pos + 1) & UWB_RANGE_INDEX_MASK;
+    }
+    *found = false;
+    return pos;
+}
+
+static void index_remove(uwb_range_store_t *store, const uwb_range_t *range)
+{
+    bool found;
+    size_t hole = index_find(store, range, &found);
+    if (!found) {
+        return;
+    }
+
+    // Удаление со сдвигом назад, чтобы не копить надгробия
+    store->index[hole] = 0;
+    size_t pos = hole;
+    for (;;) {
+        pos = (pos + 1) & UWB_RANGE_INDEX_MASK;
+        if (store->index[pos] == 0) {
+            break;
+        }
+        size_t home = index_home(&store->slots[store->index[pos] - 1].latest);
+        bool stays = (hole <= pos) ? (hole < home && home <= pos) : (hole < home || home <= pos);
+        if (stays) {
+            continue;
+        }
+        store->index[hole] = store->index[pos];
+        store->index[pos] = 0;
+        hole = pos;
+    }
+}
+
+static void lru_unlink(uwb_range_store_t *store, uint8_t slot)
+{
+    uint8_t prev = store->lru_prev[slot];
+    uint8_t next = store->lru_next[slot];
+    if (prev != UWB_RANGE_NONE) {
+        store->lru_next[prev] = next;
+    } else {
+        store->lru_head = next;
+    }
+    if (next != UWB_RANGE_NONE) {
+        store->lru_prev[next] = prev;
+    } else {
+        store->lru_tail = prev;
+    }
+}
+
+static void lru_push_front(uwb_range_store_t *store, uint8_t slot)
+{
+    store->lru_prev[slot] = UWB_RANGE_NONE;
+    store->lru_next[slot] = store->lru_head;
+    if (store->lru_head != UWB_RANGE_NONE) {
+        store->lru_prev[store->lru_head] = slot;
+    } else {
+        store->lru_tail = slot;
+    }
+    store->lru_head = slot;
+}
+
+void uwb_range_store_reset(uwb_range_store_t *store)
+{
+    memset(store, 0, sizeof(*store));
+    store->lru_head = UWB_RANGE_NONE;
+    store->lru_tail = UWB_RANGE_NONE;
+}
+
+void uwb_range_store_set_change_threshold(uwb_range_store_t *store, uint32_t threshold_mm)
+{
+    store->change_threshold_mm = threshold_mm;
+}
+
+bool uwb_range_store_upsert(uwb_range_store_t *store, const uwb_range_t *range)
+{
+    // Индекс, LRU и поля слотов меняет только писатель, поэтому читать их
+    // здесь можно без seqlock
+    bool found;
+    size_t pos = index_find(store, range, &found);
+
+    if (found) {
+        uint8_t slot = (uint8_t)(store->index[pos] - 1);
+        uint32_t filtered_mm = write_slot(&store->slots[slot], range, false);
+        if (store->lru_head != slot) {
+            lru_unlink(store, slot);
+            lru_push_front(store, slot);
+        }
+        return report_change(store, &store->slots[slot], filtered_mm, false);
+    }
+
+    uint8_t slot;
+    if (store->used < UWB_MAX_RANGES) {
+        slot = store->used++;
+    } else {
+        slot = store->lru_tail;
+        lru_unlink(store, slot);
+        index_remove(store, &store->slots[slot].latest);
+        // Сдвиг мог занять найденную ранее свободную позицию
+        pos = index_find(store, range, &found);
+    }
+
+    uint32_t filtered_mm = write_slot(&store->slots[slot], range, true);
+    store->index[pos] = (uint8_t)(slot + 1);
+    lru_push_front(store, slot);
+    return report_change(store, &store->slots[slot], filtered_mm, true);
+}
+
+size_t uwb_range_store_snapshot(uwb_range_store_t *store, uwb_range_t *ranges, size_t max_ranges,
+                                int64_t now_ms, int64_t stale_after_ms)
+{
+    size_t count = 0;
+
+    for (size_t i = 0; i < UWB_MAX_RANGES && count < max_ranges; i++) {
+        const uwb_range_slot_t *slot = &store->slots[i];
+        uwb_range_t copy;
+        unsigned seq;
+
+        do {
+            seq = read_begin(slot);
+            copy = slot->latest;
+        } while (read_retry(slot, seq));
+
+        if (copy.valid && (now_ms - copy.updated_at_ms) <= stale_after_ms) {
+            ranges[count++] = copy;
+        }
+    }
+
+    return count;
+}
+
+size_t uwb_range_store_get_history(uwb_range_store_t *store, const char *peer_id,
+                                   uwb_range_sample_t *samples, size_t max_samples)
+{
+    if (peer_id == NULL || samples == NULL || max_samples == 0) {
+        return 0;
+    }
+
+    uwb_range_t key = {0};
+    if (!uwb_parser_set_peer(&key, peer_id, strlen(peer_id))) {
+        return 0;
+    }
+
+    for (size_t i = 0; i < UWB_MAX_RANGES; i++) {
+        const uwb_range_slot_t *slot = &store->slots[i];
+        size_t count;
+        bool matched;
+        unsigned seq;
+
+        do {
+            seq = read_begin(slot);
+            matched = slot->latest.valid && uwb_range_same_peer(&slot->latest, &key);
+            count = 0;
+            if (matched) {
+                size_t available = slot->history_count;
+                size_t skip = available > max_samples ? available - max_samples : 0;
+                size_t start = (slot->history_head + UWB_RANGE_HISTORY_LEN - available) % UWB_RANGE_HISTORY_LEN;
+                for (size_t j = skip; j < available; j++) {
+                    samples[count++] = slot->history[(start + j) % UWB_RANGE_HISTORY_LEN];
+                }
+            }
+        } while (read_retry(slot, seq));
+
+        if (matched) {
+            return count;
+        }
+    }
+
+    return 0;
+}
@@ -1,10 +1,15 @@
 #include "web_server.h"
 #include "wifi_manager.h"
 #include "servo_controller.h"
+#include "servo_calibration.h"
 #include "led_controller.h"
+#include "scheduler.h"
+#include "websocket_client.h"
 #include "cJSON.h"
+#include "json_writer.h"
 #include "esp_log.h"
 #include "esp_spiffs.h"
+#include <math.h>
 #include <string.h>
 
 static const char *TAG = "WEB_SERVER";
@@ -12,6 +17,10 @@ static const char *TAG = "WEB_SERVER";
 static httpd_handle_t s_server = NULL;
 static device_config_t* s_device_config = NULL;
 
+// httpd обслуживает запросы в одной задаче, поэтому буфер ответа общий
+#define STATUS_JSON_BUFFER_SIZE 4096
+static char s_status_json[STATUS_JSON_BUFFER_SIZE];
+
 /**
  * @brief Инициализация SPIFFS
  */
@@ -94,6 +103,32 @@ static esp_err_t root_handler(httpd_req_t* req)
     return ESP_OK;
 }
 
+/**
+ * @brief Статус одного сервопривода вместе с его калибровочной таблицей
+ */
+static void write_servo_status(json_writer_t* json, int servo_id, int angle, int32_t angle_cdeg, bool moving)
+{
+    json_writer_object_begin(json);
+    json_writer_field_int(json, "angle", angle);
+    json_writer_field_int(json, "angleCdeg", angle_cdeg);
+    json_writer_field_bool(json, "moving", moving);
+    
+    servo_calibration_t calibration;
+    if (servo_controller_get_calibration(servo_id, &calibration) == ESP_OK) {
+        // Точки [угол в сотых градуса, импульс в мкс]
+        json_writer_key(json, "calibration");
+        json_writer_array_begin(json);
+        for (int i = 0; i < calibration.count; i++) {
+            json_writer_array_begin(json);
+            json_writer_uint(json, calibration.angle_cdeg[i]);
+            json_writer_uint(json, calibration.pulse_us[i]);
+            json_writer_array_end(json);
+        }
+        json_writer_array_end(json);
+    }
+    json_writer_object_end(json);
+}
+
 /**
  * @brief Обработчик статуса устройства
  */
@@ -101,58 +136,163 @@ static esp_err_t status_handler(httpd_req_t* req)
 {
     servo_status_t servo_status;
     servo_controller_get_status(&servo_status);
+    servo_output_stats_t servo_output;
+    servo_controller_get_output_stats(&servo_output);
     
-    cJSON* json = cJSON_CreateObject();
+    json_writer_t json;
+    json_writer_init(&json, s_status_json, sizeof(s_status_json));
+    json_writer_object_begin(&json);
     
     // WiFi статус
+    char ip_str[16];
+    esp_netif_ip_info_t ip_info;
     if (wifi_manager_is_connected()) {
-        cJSON_AddStringToObject(json, "wifi", "connected");
+        json_writer_field_string(&json, "wifi", "connected");
         
-        esp_netif_ip_info_t ip_info;
         if (wifi_manager_get_ip(&ip_info) == ESP_OK) {
-            char ip_str[16];
             sprintf(ip_str, IPSTR, IP2STR(&ip_info.ip));
-            cJSON_AddStringToObject(json, "ip", ip_str);
+            json_writer_field_string(&json, "ip", ip_str);
         } else {
-            cJSON_AddStringToObject(json, "ip", "0.0.0.0");
+            json_writer_field_string(&json, "ip", "0.0.0.0");
         }
     } else {
-        cJSON_AddStringToObject(json, "wifi", "ap");
+        json_writer_field_string(&json, "wifi", "ap");
         
-        esp_netif_ip_info_t ip_info;
         if (wifi_manager_get_ap_ip(&ip_info) == ESP_OK) {
-            char ip_str[16];
             sprintf(ip_str, IPSTR, IP2STR(&ip_info.ip));
-            cJSON_AddStringToObject(json, "ip", ip_str);
+            json_writer_field_string(&json, "ip", ip_str);
         } else {
-            cJSON_AddStringToObject(json, "ip", "192.168.4.1"); // Default AP IP
+            json_writer_field_string(&json, "ip", "192.168.4.1"); // Default AP IP
         }
     }
     
     // Device ID
-    cJSON_AddStringToObject(json, "deviceId", s_device_config->device_id);
+    json_writer_field_string(&json, "deviceId", s_device_config->device_id);
     
     // Backend URL
-    cJSON_AddStringToObject(json, "backendUrl", s_device_config->backend_url);
+    json_writer_field_string(&json, "backendUrl", s_device_config->backend_url);
     
     // WiFi credentials (для заполнения формы)
-    cJSON_AddStringToObject(json, "wifiSsid", s_device_config->wifi_ssid);
-    cJSON_AddStringToObject(json, "wifiPass", s_device_config->wifi_pass);
+    json_writer_field_string(&json, "wifiSsid", s_device_config->wifi_ssid);
+    json_writer_field_string(&json, "wifiPass", s_device_config->wifi_pass);
     
     // Статус сервоприводов
-    cJSON* servo1 = cJSON_CreateObject();
-    cJSON_AddNumberToObject(servo1, "angle", servo_status.angle1);
-    cJSON_AddBoolToObject(servo1, "moving", servo_status.moving1);
-    cJSON_AddItemToObject(json, "servo1", servo1);
+    json_writer_key(&json, "servo1");
+    write_servo_status(&json, 1, servo_status.angle1, servo_status.angle1_cdeg, servo_status.moving1);
+    
+    json_writer_key(&json, "servo2");
+    write_servo_status(&json, 2, servo_status.angle2, servo_status.angle2_cdeg, servo_status.moving2);
+    
+    // Время записи duty в LEDC из задания servo
+    json_writer_key(&json, "servoOutput");
+    json_writer_object_begin(&json);
+    json_writer_field_uint(&json, "writes", servo_output.writes);
+    json_writer_field_uint(&json, "errors", servo_output.errors);
+    json_writer_field_uint(&json, "lastUs", servo_output.last_us);
+    json_writer_field_uint(&json, "maxUs", servo_output.max_us);
+    json_writer_field_uint(&json, "avgUs",
+                           servo_output.writes > 0 ? servo_output.total_us / servo_output.writes : 0);
+    json_writer_object_end(&json);
+
+    // Бюджет кадра LED: ленты передаются параллельно
+    led_frame_budget_t led_budget;
+    led_controller_get_frame_budget(&led_budget);
+    json_writer_key(&json, "led");
+    json_writer_object_begin(&json);
+    json_writer_field_int(&json, "strips", led_budget.strip_count);
+    json_writer_field_int(&json, "leds", led_budget.led_count);
+    json_writer_field_uint(&json, "periodUs", led_budget.frame_period_us);
+    json_writer_field_uint(&json, "wireUs", led_budget.wire_us);
+    json_writer_field_uint(&json, "serialWireUs", led_budget.serial_wire_us);
+    json_writer_field_uint(&json, "measuredUs", led_budget.measured_us);
+    json_writer_object_end(&json);
+
+    // Очередь исходящих сообщений WebSocket
+    ws_outbox_stats_t outbox;
+    if (websocket_client_get_outbox_stats(&outbox) == ESP_OK) {
+        static const char* const outbox_classes[WS_OUTBOX_CLASS_COUNT] = { "control", "telemetry", "diagnostics" };
+        json_writer_key(&json, "outbox");
+        json_writer_object_begin(&json);
+        json_writer_field_uint(&json, "depth", outbox.depth);
+        json_writer_field_uint(&json, "maxDepth", outbox.max_depth);
+        json_writer_field_uint(&json, "bytes", outbox.bytes);
+        json_writer_field_uint(&json, "maxBytes", outbox.max_bytes);
+        for (int c = 0; c < WS_OUTBOX_CLASS_COUNT; c++) {
+            const ws_outbox_class_stats_t* cls = &outbox.classes[c];
+            json_writer_key(&json, outbox_classes[c]);
+            json_writer_object_begin(&json);
+            json_writer_field_uint(&json, "enqueued", cls->enqueued);
+            json_writer_field_uint(&json, "sent", cls->sent);
+            json_writer_field_uint(&json, "failed", cls->failed);
+            json_writer_field_uint(&json, "dropped", cls->dropped);
+            json_writer_field_uint(&json, "rejected", cls->rejected);
+            json_writer_field_uint(&json, "lastLatencyUs", cls->last_latency_us);
+            json_writer_field_uint(&json, "maxLatencyUs", cls->max_latency_us);
+            json_writer_field_uint(&json, "avgLatencyUs",
+                                   cls->sent > 0 ? (uint32_t)(cls->total_latency_us / cls->sent) : 0);
+            json_writer_object_end(&json);
+        }
+        json_writer_object_end(&json);
+    }
+
+    ws_reassembly_stats_t inbound;
+    if (websocket_client_get_inbound_stats(&inbound) == ESP_OK) {
+        json_writer_key(&json, "inbound");
+        json_writer_object_begin(&json);
+        json_writer_field_uint(&json, "messages", inbound.messages);
+        json_writer_field_uint(&json, "reassembled", inbound.reassembled);
+        json_writer_field_uint(&json, "binary", inbound.binary);
+        json_writer_field_uint(&json, "oversized", inbound.oversized);
+        json_writer_field_uint(&json, "protocolErrors", inbound.protocol_errors);
+        json_writer_field_uint(&json, "maxBytes", inbound.max_len);
+        json_writer_field_uint(&json, "limitBytes", WS_REASSEMBLY_SIZE);
+        json_writer_object_end(&json);
+    }
+
+    // Задания планировщиков: время выполнения, пропуски сроков, гистограмма
+    json_writer_key(&json, "jobs");
+    json_writer_array_begin(&json);
+    scheduler_job_stats_t job;
+    for (int i = 0; scheduler_get_job_stats(i, &job) == ESP_OK; i++) {
+        json_writer_object_begin(&json);
+        json_writer_field_string(&json, "name", job.name);
+        json_writer_field_string(&json, "scheduler", job.scheduler);
+        json_writer_field_uint(&json, "periodMs", job.period_ms);
+        json_writer_field_uint(&json, "deadlineMs", job.deadline_ms);
+        json_writer_field_uint(&json, "runs", job.runs);
+        json_writer_field_uint(&json, "misses", job.misses);
+        json_writer_field_uint(&json, "skipped", job.skipped);
+        json_writer_field_uint(&json, "lastUs", job.last_us);
+        json_writer_field_uint(&json, "maxUs", job.max_us);
+        json_writer_field_uint(&json, "avgUs", job.runs > 0 ? (uint32_t)(job.total_us / job.runs) : 0);
+        json_writer_field_uint(&json, "maxLatencyUs", job.max_latency_us);
+        json_writer_key(&json, "histogram");
+        json_writer_array_begin(&json);
+        for (int b = 0; b < SCHEDULER_HISTOGRAM_BUCKETS; b++) {
+            json_writer_uint(&json, job.histogram[b]);
+        }
+        json_writer_array_end(&json);
+        json_writer_object_end(&json);
+    }
+    json_writer_array_end(&json);
+
+    // Верхние границы корзин гистограммы, мкс; последняя корзина без границы
+    json_writer_key(&json, "histogramBucketsUs");
+    json_writer_array_begin(&json);
+    for (int b = 0; b < SCHEDULER_HISTOGRAM_BUCKETS - 1; b++) {
+        json_writer_uint(&json, scheduler_histogram_bucket_us(b));
+    }
+    json_writer_array_end(&json);
     
-    cJSON* servo2 = cJSON_CreateObject();
-    cJSON_AddNumberToObject(servo2, "angle", servo_status.angle2);
-    cJSON_AddBoolToObject(servo2, "moving", servo_status.moving2);
-    cJSON_AddItemToObject(json, "servo2", servo2);
+    json_writer_object_end(&json);
+    size_t len = json_writer_finish(&json);
+    if (len == 0) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "JSON serialization failed");
+        return ESP_ERR_NO_MEM;
+    }
     
-    esp_err_t ret = send_json_response(req, json, 200);
-    cJSON_Delete(json);
-    return ret;
+    httpd_resp_set_type(req, "application/json");
+    return httpd_resp_send(req, s_status_json, len);
 }
 
 /**
@@ -342,6 +482,18 @@ static esp_err_t config_handler(httpd_req_t* req)
     return (save_ret == ESP_OK) ? ESP_OK : ESP_FAIL;
 }
 
+/**
+ * @brief Число JSON в диапазоне [min, max]
+ *
+ * Проверяется double до округления или сужения: lround вне диапазона long
+ * и приведение к uint16_t отрицательных значений не определены или
+ * заворачиваются.
+ */
+static bool json_number_in_range(const cJSON* item, double min, double max)
+{
+    return cJSON_IsNumber(item) && item->valuedouble >= min && item->valuedouble <= max;
+}
+
 /**
  * @brief Обработчик управления сервоприводами
  */
@@ -383,8 +535,9 @@ static esp_err_t servo_handler(httpd_req_t* req)
     cJSON* id_item = cJSON_GetObjectItem(json, "id");
     cJSON* angle_item = cJSON_GetObjectItem(json, "angle");
     cJSON* smooth_item = cJSON_GetObjectItem(json, "smooth");
+    cJSON* duration_item = cJSON_GetObjectItem(json, "durationMs");
     
-    if (!cJSON_IsNumber(id_item) || !cJSON_IsNumber(angle_item)) {
+    if (!cJSON_IsNumber(id_item) || !json_number_in_range(angle_item, 0.0, 180.0)) {
         cJSON* error_json = cJSON_CreateObject();
         cJSON_AddStringToObject(error_json, "error", "invalid parameters");
         send_json_response(req, error_json, 400);
@@ -394,8 +547,9 @@ static esp_err_t servo_handler(httpd_req_t* req)
     }
     
     int id = id_item->valueint;
-    int angle = angle_item->valueint;
+    int32_t angle_cdeg = (int32_t)lround(angle_item->valuedouble * 100.0);
     bool smooth = cJSON_IsBool(smooth_item) ? cJSON_IsTrue(smooth_item) : true;
+    int duration_ms = cJSON_IsNumber(duration_item) ? duration_item->valueint : 0;
     
     if (id < 1 || id > 2) {
         cJSON* error_json = cJSON_CreateObject();
@@ -408,8 +562,17 @@ static esp_err_t servo_handler(httpd_req_t* req)
     
     cJSON_Delete(json);
     
-    // Управляем сервоприводом
-    esp_err_t servo_ret = servo_controller_move_to(id, angle, smooth);
+    // Управляем сервоприводом: с durationMs — аппаратным затуханием LEDC,
+    // а без него — программным профилем за то же время
+    esp_err_t servo_ret;
+    if (duration_ms > 0) {
+        servo_ret = servo_controller_fade_to_cdeg(id, angle_cdeg, (uint32_t)duration_ms);
+        if (servo_ret != ESP_OK && servo_ret != ESP_ERR_INVALID_ARG) {
+            servo_ret = servo_controller_move_timed_cdeg(id, angle_cdeg, (uint32_t)duration_ms);
+        }
+    } else {
+        servo_ret = servo_controller_move_to_cdeg(id, angle_cdeg, smooth);
+    }
     
     cJSON* response_json = cJSON_CreateObject();
     if (servo_ret == ESP_OK) {
@@ -424,6 +587,88 @@ static esp_err_t servo_handler(httpd_req_t* req)
     return servo_ret;
 }
 
+/**
+ * @brief Обработчик калибровки сервоприводов
+ *
+ * Шаги калибровки (см. servo_controller.h) по полю action:
+ * "pulse" {pulseUs}, "limits" {minUs, maxUs}, "record" {angle},
+ * "apply" {persist?}, "reset". Таблица видна в /api/status.
+ */
+static esp_err_t servo_calibration_handler(httpd_req_t* req)
+{
+    // Читаем тело запроса
+    char* content = malloc(req->content_len + 1);
+    if (content == NULL) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Memory allocation failed");
+        return ESP_ERR_NO_MEM;
+    }
+    
+    int ret = httpd_req_recv(req, content, req->content_len);
+    if (ret <= 0) {
+        free(content);
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Failed to read request body");
+        return ESP_FAIL;
+    }
+    
+    content[req->content_len] = '\0';
+    
+    cJSON* json = cJSON_Parse(content);
+    free(content);
+    
+    cJSON* id_item = cJSON_GetObjectItem(json, "id");
+    cJSON* action_item = cJSON_GetObjectItem(json, "action");
+    if (json == NULL || !cJSON_IsNumber(id_item) || !cJSON_IsString(action_item)) {
+        cJSON* error_json = cJSON_CreateObject();
+        cJSON_AddStringToObject(error_json, "error", "invalid parameters");
+        send_json_response(req, error_json, 400);
+        cJSON_Delete(error_json);
+        cJSON_Delete(json);
+        return ESP_FAIL;
+    }
+    
+    int id = id_item->valueint;
+    const char* action = action_item->valuestring;
+    cJSON* pulse_item = cJSON_GetObjectItem(json, "pulseUs");
+    cJSON* min_item = cJSON_GetObjectItem(json, "minUs");
+    cJSON* max_item = cJSON_GetObjectItem(json, "maxUs");
+    cJSON* angle_item = cJSON_GetObjectItem(json, "angle");
+    cJSON* persist_item = cJSON_GetObjectItem(json, "persist");
+    
+    // Импульсы и угол вне диапазона — 400, как и прочие неверные параметры
+    esp_err_t servo_ret = ESP_ERR_INVALID_ARG;
+    if (strcmp(action, "pulse") == 0 &&
+        json_number_in_range(pulse_item, SERVO_CALIBRATION_PULSE_MIN_US, SERVO_CALIBRATION_PULSE_MAX_US)) {
+        servo_ret = servo_controller_set_pulse_us(id, (uint16_t)pulse_item->valueint);
+    } else if (strcmp(action, "limits") == 0 &&
+               json_number_in_range(min_item, SERVO_CALIBRATION_PULSE_MIN_US, SERVO_CALIBRATION_PULSE_MAX_US) &&
+               json_number_in_range(max_item, SERVO_CALIBRATION_PULSE_MIN_US, SERVO_CALIBRATION_PULSE_MAX_US)) {
+        servo_ret = servo_controller_calibration_set_limits(id, (uint16_t)min_item->valueint,
+                                                            (uint16_t)max_item->valueint);
+    } else if (strcmp(action, "record") == 0 && json_number_in_range(angle_item, 0.0, 180.0)) {
+        servo_ret = servo_controller_calibration_record(id, (int32_t)lround(angle_item->valuedouble * 100.0));
+    } else if (strcmp(action, "apply") == 0) {
+        bool persist = cJSON_IsBool(persist_item) ? cJSON_IsTrue(persist_item) : true;
+        servo_ret = servo_controller_calibration_apply(id, persist);
+    } else if (strcmp(action, "reset") == 0) {
+        servo_ret = servo_controller_calibration_reset(id);
+    }
+    
+    cJSON_Delete(json);
+    
+    cJSON* response_json = cJSON_CreateObject();
+    if (servo_ret == ESP_OK) {
+        cJSON_AddStringToObject(response_json, "status", "ok");
+        send_json_response(req, response_json, 200);
+    } else {
+        cJSON_AddStringToObject(response_json, "status", "error");
+        cJSON_AddStringToObject(response_json, "error", esp_err_to_name(servo_ret));
+        send_json_response(req, response_json, servo_ret == ESP_ERR_INVALID_ARG ? 400 : 500);
+    }
+    cJSON_Delete(response_json);
+    
+    return servo_ret;
+}
+
 /**
  * @brief Обработчик управления LED
  */
@@ -593,6 +838,14 @@ esp_err_t web_server_init(device_config_t* config)
     };
     httpd_register_uri_handler(s_server, &servo_uri);
     
+    httpd_uri_t servo_calibration_uri = {
+        .uri = "/api/servo/calibration",
+        .method = HTTP_POST,
+        .handler = servo_calibration_handler,
+        .user_ctx = NULL
+    };
+    httpd_register_uri_handler(s_server, &servo_calibration_uri);
+    
     httpd_uri_t led_uri = {
         .uri = "/api/led",
         .method = HTTP_POST,
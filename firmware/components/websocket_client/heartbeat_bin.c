@@ -0,0 +1,137 @@
+#include "heartbeat_bin.h"
+
+#include <string.h>
+
+typedef struct {
+    uint8_t *data;
+    size_t size;
+    size_t length;
+    bool overflow;
+} bin_writer_t;
+
+static void put_bytes(bin_writer_t *writer, const void *bytes, size_t len)
+{
+    if (writer->overflow || writer->size - writer->length < len) {
+        writer->overflow = true;
+        return;
+    }
+    memcpy(writer->data + writer->length, bytes, len);
+    writer->length += len;
+}
+
+static void put_u8(bin_writer_t *writer, uint8_t value)
+{
+    put_bytes(writer, &value, 1);
+}
+
+static void put_u16(bin_writer_t *writer, uint16_t value)
+{
+    uint8_t bytes[2] = {(uint8_t)value, (uint8_t)(value >> 8)};
+    put_bytes(writer, bytes, sizeof(bytes));
+}
+
+static void put_u32(bin_writer_t *writer, uint32_t value)
+{
+    uint8_t bytes[4] = {
+        (uint8_t)value, (uint8_t)(value >> 8), (uint8_t)(value >> 16), (uint8_t)(value >> 24),
+    };
+    put_bytes(writer, bytes, sizeof(bytes));
+}
+
+static uint32_t meters_to_mm(float meters)
+{
+    return meters > 0.0f ? (uint32_t)(meters * 1000.0f + 0.5f) : 0;
+}
+
+static int hex_value(char c)
+{
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    return -1;
+}
+
+// last_rx_hex хранится как "F0 05 ..." — передаём сами байты
+static size_t decode_last_rx(const char *hex, uint8_t *bytes)
+{
+    size_t count = 0;
+    for (const char *p = hex; p[0] != '\0' && p[1] != '\0' && count < HEARTBEAT_BIN_LAST_RX_MAX;) {
+        int high = hex_value(p[0]);
+        int low = hex_value(p[1]);
+        if (high < 0 || low < 0) {
+            p++;
+            continue;
+        }
+        bytes[count++] = (uint8_t)((high << 4) | low);
+        p += 2;
+    }
+    return count;
+}
+
+size_t heartbeat_bin_encode(uint8_t *buffer, size_t buffer_size,
+                            const servo_status_t *servo, bool uwb_ready,
+                            const uwb_positioning_stats_t *stats,
+                            const uwb_range_t *ranges, size_t range_count)
+{
+    bin_writer_t writer = {.data = buffer, .size = buffer_size};
+    uint8_t last_rx[HEARTBEAT_BIN_LAST_RX_MAX];
+    size_t last_rx_len = decode_last_rx(stats->last_rx_hex, last_rx);
+
+    if (range_count > UINT8_MAX) {
+        range_count = UINT8_MAX;
+    }
+
+    uint8_t flags = 0;
+    if (uwb_ready) {
+        flags |= HEARTBEAT_BIN_FLAG_UWB_READY;
+    }
+    if (stats->auto_config_enabled) {
+        flags |= HEARTBEAT_BIN_FLAG_AUTO_CONFIG;
+    }
+
+    put_u8(&writer, HEARTBEAT_BIN_MAGIC);
+    put_u8(&writer, HEARTBEAT_BIN_VERSION);
+    put_u8(&writer, flags);
+    put_u8(&writer, (uint8_t)range_count);
+    put_u16(&writer, (uint16_t)(int16_t)servo->angle1);
+    put_u16(&writer, (uint16_t)(int16_t)servo->angle2);
+    put_u32(&writer, stats->total_bytes);
+    put_u32(&writer, stats->discarded_bytes);
+    put_u32(&writer, stats->parsed_frames);
+    put_u32(&writer, stats->invalid_frames);
+    put_u32(&writer, stats->parsed_lines);
+    put_u32(&writer, stats->invalid_lines);
+    put_u32(&writer, (uint32_t)stats->last_byte_at_ms);
+    put_u8(&writer, (uint8_t)stats->role);
+    put_u8(&writer, stats->pid);
+    put_u8(&writer, stats->period);
+    put_u8(&writer, (uint8_t)last_rx_len);
+    put_u16(&writer, stats->local_address);
+    put_u16(&writer, stats->peer0_address);
+    put_bytes(&writer, last_rx, last_rx_len);
+
+    for (size_t i = 0; i < range_count; i++) {
+        const uwb_range_t *range = &ranges[i];
+
+        put_u8(&writer, range->peer_named ? HEARTBEAT_BIN_RANGE_FLAG_NAMED : 0);
+        put_u16(&writer, range->peer_addr);
+        if (range->peer_named) {
+            const char *end = memchr(range->peer_name, '\0', UWB_PEER_ID_LEN);
+            size_t name_len = end != NULL ? (size_t)(end - range->peer_name) : UWB_PEER_ID_LEN - 1;
+            put_u8(&writer, (uint8_t)name_len);
+            put_bytes(&writer, range->peer_name, name_len);
+        }
+        put_u32(&writer, meters_to_mm(range->distance_m));
+        put_u32(&writer, meters_to_mm(range->filtered_distance_m));
+        put_u8(&writer, (uint8_t)(int8_t)range->rssi_dbm);
+        put_u32(&writer, (uint32_t)range->updated_at_ms);
+    }
+
+    return writer.overflow ? 0 : writer.length;
+}
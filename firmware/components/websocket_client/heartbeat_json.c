@@ -0,0 +1,136 @@
+#include "heartbeat_json.h"
+#include "json_writer.h"
+
+#include <string.h>
+
+// Расстояния приходят с точностью до миллиметра
+#define HEARTBEAT_JSON_DISTANCE_DECIMALS 3
+
+// Поле пишется в опорном heartbeat всегда, в разностном — только если изменилось
+#define HEARTBEAT_CHANGED(field) (base == NULL || state->field != base->field)
+
+static void write_servo(json_writer_t *writer, const char *key, int angle)
+{
+    json_writer_key(writer, key);
+    json_writer_object_begin(writer);
+    json_writer_field_int(writer, "angle", angle);
+    json_writer_object_end(writer);
+}
+
+static void write_ranges(json_writer_t *writer, const uwb_range_t *ranges, size_t range_count,
+                         bool with_timestamp)
+{
+    json_writer_key(writer, "ranges");
+    json_writer_array_begin(writer);
+    for (size_t i = 0; i < range_count; i++) {
+        char peer_id[UWB_PEER_ID_LEN];
+        uwb_range_format_peer_id(&ranges[i], peer_id, sizeof(peer_id));
+
+        json_writer_object_begin(writer);
+        json_writer_field_string(writer, "peerId", peer_id);
+        json_writer_field_float(writer, "distanceM", ranges[i].distance_m, HEARTBEAT_JSON_DISTANCE_DECIMALS);
+        json_writer_field_float(writer, "filteredDistanceM", ranges[i].filtered_distance_m,
+                                HEARTBEAT_JSON_DISTANCE_DECIMALS);
+        if (with_timestamp) {
+            json_writer_field_int(writer, "updatedAtMs", ranges[i].updated_at_ms);
+        }
+        json_writer_field_int(writer, "rssiDbm", ranges[i].rssi_dbm);
+        json_writer_object_end(writer);
+    }
+    json_writer_array_end(writer);
+}
+
+size_t heartbeat_json_encode(char *buffer, size_t buffer_size, const char *device_id, uint32_t seq,
+                             const heartbeat_state_t *state, const heartbeat_state_t *base,
+                             const uwb_range_t *ranges)
+{
+    const uwb_positioning_stats_t *stats = &state->stats;
+    json_writer_t writer;
+    json_writer_init(&writer, buffer, buffer_size);
+
+    json_writer_object_begin(&writer);
+    json_writer_field_string(&writer, "type", "heartbeat");
+    json_writer_field_uint(&writer, "seq", seq);
+    if (base == NULL) {
+        json_writer_field_bool(&writer, "keyframe", true);
+        json_writer_field_string(&writer, "deviceId", device_id);
+    }
+
+    if (HEARTBEAT_CHANGED(servo.angle1)) {
+        write_servo(&writer, "servo1", state->servo.angle1);
+    }
+    if (HEARTBEAT_CHANGED(servo.angle2)) {
+        write_servo(&writer, "servo2", state->servo.angle2);
+    }
+
+    json_writer_key(&writer, "uwb");
+    json_writer_object_begin(&writer);
+
+    write_ranges(&writer, ranges, state->range_count, true);
+
+    if (HEARTBEAT_CHANGED(uwb_ready)) {
+        json_writer_field_bool(&writer, "ready", state->uwb_ready);
+    }
+    if (HEARTBEAT_CHANGED(range_count)) {
+        json_writer_field_uint(&writer, "rangeCount", state->range_count);
+    }
+    if (HEARTBEAT_CHANGED(stats.total_bytes)) {
+        json_writer_field_uint(&writer, "uartBytes", stats->total_bytes);
+    }
+    if (HEARTBEAT_CHANGED(stats.discarded_bytes)) {
+        json_writer_field_uint(&writer, "discardedBytes", stats->discarded_bytes);
+    }
+    if (HEARTBEAT_CHANGED(stats.parsed_frames)) {
+        json_writer_field_uint(&writer, "parsedFrames", stats->parsed_frames);
+    }
+    if (HEARTBEAT_CHANGED(stats.invalid_frames)) {
+        json_writer_field_uint(&writer, "invalidFrames", stats->invalid_frames);
+    }
+    if (HEARTBEAT_CHANGED(stats.parsed_lines)) {
+        json_writer_field_uint(&writer, "parsedLines", stats->parsed_lines);
+    }
+    if (HEARTBEAT_CHANGED(stats.invalid_lines)) {
+        json_writer_field_uint(&writer, "invalidLines", stats->invalid_lines);
+    }
+    if (HEARTBEAT_CHANGED(stats.last_byte_at_ms)) {
+        json_writer_field_int(&writer, "lastByteAtMs", stats->last_byte_at_ms);
+    }
+    if (base == NULL || strcmp(stats->last_rx_hex, base->stats.last_rx_hex) != 0) {
+        json_writer_field_string(&writer, "lastRxHex", stats->last_rx_hex);
+    }
+    if (HEARTBEAT_CHANGED(stats.auto_config_enabled)) {
+        json_writer_field_bool(&writer, "autoConfig", stats->auto_config_enabled);
+    }
+    if (HEARTBEAT_CHANGED(stats.role)) {
+        json_writer_field_int(&writer, "role", stats->role);
+    }
+    if (HEARTBEAT_CHANGED(stats.pid)) {
+        json_writer_field_uint(&writer, "pid", stats->pid);
+    }
+    if (HEARTBEAT_CHANGED(stats.period)) {
+        json_writer_field_uint(&writer, "period", stats->period);
+    }
+    if (HEARTBEAT_CHANGED(stats.local_address)) {
+        json_writer_field_uint(&writer, "localAddress", stats->local_address);
+    }
+    if (HEARTBEAT_CHANGED(stats.peer0_address)) {
+        json_writer_field_uint(&writer, "peer0Address", stats->peer0_address);
+    }
+    json_writer_object_end(&writer);
+
+    json_writer_object_end(&writer);
+    return json_writer_finish(&writer);
+}
+
+size_t heartbeat_json_encode_ranges(char *buffer, size_t buffer_size,
+                                    const uwb_range_t *ranges, size_t range_count)
+{
+    json_writer_t writer;
+    json_writer_init(&writer, buffer, buffer_size);
+
+    json_writer_object_begin(&writer);
+    json_writer_field_string(&writer, "type", "ranges");
+    write_ranges(&writer, ranges, range_count, false);
+    json_writer_object_end(&writer);
+    return json_writer_finish(&writer);
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "config_storage.h"
+#include "uwb_positioning.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Бинарный heartbeat (версия 1). Отправляется binary-кадром WebSocket, если
+ * бэкенд подтвердил формат "bin1" в ответе на register. Все многобайтовые
+ * поля little-endian. Декодер: backend/server/utils/binaryHeartbeat.ts.
+ *
+ * Заголовок (44 байта):
+ *   0  u8   магия 0xB1
+ *   1  u8   версия
+ *   2  u8   флаги: bit0 uwb ready, bit1 autoConfig
+ *   3  u8   количество расстояний
+ *   4  i16  угол servo1
+ *   6  i16  угол servo2
+ *   8  u32  uartBytes, discardedBytes, parsedFrames, invalidFrames,
+ *           parsedLines, invalidLines, lastByteAtMs (7 полей)
+ *  36  u8   role, pid, period
+ *  39  u8   длина lastRx (до 16)
+ *  40  u16  localAddress, peer0Address
+ *  44  u8[] последние принятые байты UART
+ *
+ * Расстояние (16 байт + имя):
+ *   u8  флаги: bit0 пир задан именем
+ *   u16 адрес MK8000 (или хеш имени)
+ *   [u8 длина, u8[] имя] — только для именованного пира
+ *   u32 distance, мм
+ *   u32 filteredDistance, мм
+ *   i8  rssi, дБм
+ *   u32 updatedAtMs
+ */
+
+#define HEARTBEAT_BIN_MAGIC 0xB1
+#define HEARTBEAT_BIN_VERSION 1
+#define HEARTBEAT_BIN_FORMAT "bin1"
+
+#define HEARTBEAT_BIN_HEADER_SIZE 44
+#define HEARTBEAT_BIN_LAST_RX_MAX 16
+#define HEARTBEAT_BIN_RANGE_SIZE 16
+#define HEARTBEAT_BIN_MAX_SIZE (HEARTBEAT_BIN_HEADER_SIZE + HEARTBEAT_BIN_LAST_RX_MAX + \
+                                UWB_MAX_RANGES * (HEARTBEAT_BIN_RANGE_SIZE + UWB_PEER_ID_LEN))
+
+#define HEARTBEAT_BIN_FLAG_UWB_READY 0x01
+#define HEARTBEAT_BIN_FLAG_AUTO_CONFIG 0x02
+#define HEARTBEAT_BIN_RANGE_FLAG_NAMED 0x01
+
+/**
+ * @brief Закодировать heartbeat в буфер без выделения памяти
+ * @param buffer Буфер размером не меньше HEARTBEAT_BIN_MAX_SIZE
+ * @param buffer_size Размер буфера
+ * @return Длина сообщения, 0 если буфер мал
+ */
+size_t heartbeat_bin_encode(uint8_t *buffer, size_t buffer_size,
+                            const servo_status_t *servo, bool uwb_ready,
+                            const uwb_positioning_stats_t *stats,
+                            const uwb_range_t *ranges, size_t range_count);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "config_storage.h"
+#include "uwb_positioning.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Текстовый heartbeat в компактном JSON, записываемый json_writer без кучи.
+ * Набор полей совпадает с прежним cJSON-вариантом и HeartbeatMsg в _ws.ts.
+ *
+ * Heartbeat бывает опорным (keyframe: все поля и deviceId) или разностным:
+ * только поля, изменившиеся относительно последнего подтверждённого бэкендом
+ * состояния. Массив ranges передаётся всегда — это живые данные, и бэкенд
+ * продлевает по нему срок жизни расстояний.
+ */
+
+#define HEARTBEAT_JSON_BASE_SIZE 640
+#define HEARTBEAT_JSON_RANGE_SIZE (128 + 2 * UWB_PEER_ID_LEN)
+#define HEARTBEAT_JSON_MAX_SIZE (HEARTBEAT_JSON_BASE_SIZE + UWB_MAX_RANGES * HEARTBEAT_JSON_RANGE_SIZE)
+#define HEARTBEAT_JSON_RANGES_MAX_SIZE (64 + UWB_MAX_RANGES * HEARTBEAT_JSON_RANGE_SIZE)
+
+/** Состояние устройства, которое переносит heartbeat */
+typedef struct {
+    servo_status_t servo;
+    bool uwb_ready;
+    uwb_positioning_stats_t stats;
+    size_t range_count;
+} heartbeat_state_t;
+
+/**
+ * @brief Записать heartbeat в буфер
+ * @param buffer Буфер размером не меньше HEARTBEAT_JSON_MAX_SIZE
+ * @param seq Номер heartbeat, бэкенд возвращает его в ack
+ * @param state Текущее состояние
+ * @param base Подтверждённое состояние для разностного heartbeat, NULL — опорный
+ * @param ranges Расстояния (state->range_count записей)
+ * @return Длина JSON без завершающего нуля, 0 если буфер мал
+ */
+size_t heartbeat_json_encode(char *buffer, size_t buffer_size, const char *device_id, uint32_t seq,
+                             const heartbeat_state_t *state, const heartbeat_state_t *base,
+                             const uwb_range_t *ranges);
+
+/**
+ * @brief Записать сообщение ranges — только расстояния, без диагностики
+ *
+ * Отправляется при заметном изменении расстояний чаще heartbeat, поэтому
+ * у записей нет updatedAtMs: бэкенд отмечает время приёма сам.
+ * @param buffer Буфер размером не меньше HEARTBEAT_JSON_RANGES_MAX_SIZE
+ * @return Длина JSON без завершающего нуля, 0 если буфер мал
+ */
+size_t heartbeat_json_encode_ranges(char *buffer, size_t buffer_size,
+                                    const uwb_range_t *ranges, size_t range_count);
+
+#ifdef __cplusplus
+}
+#endif
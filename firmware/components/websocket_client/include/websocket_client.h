@@ -3,6 +3,8 @@
 #include "esp_err.h"
 #include "esp_websocket_client.h"
 #include "config_storage.h"
+#include "ws_outbox.h"
+#include "ws_reassembly.h"
 #include <stdbool.h>
 
 #ifdef __cplusplus
@@ -35,8 +37,10 @@ esp_err_t websocket_client_stop(void);
 bool websocket_client_is_connected(void);
 
 /**
- * @brief Отправить heartbeat сообщение
- * @return ESP_OK при успехе
+ * @brief Поставить heartbeat в очередь отправки
+ *
+ * Не ждёт сети: сообщение отправит задача ws_sender.
+ * @return ESP_OK, если heartbeat поставлен в очередь
  */
 esp_err_t websocket_client_send_heartbeat(void);
 
@@ -46,6 +50,20 @@ esp_err_t websocket_client_send_heartbeat(void);
  */
 void websocket_client_heartbeat_task(void);
 
+/**
+ * @brief Получить глубину очереди отправки и задержки по классам
+ * @param stats Результат
+ * @return ESP_OK при успехе, ESP_ERR_INVALID_STATE до первой инициализации
+ */
+esp_err_t websocket_client_get_outbox_stats(ws_outbox_stats_t* stats);
+
+/**
+ * @brief Получить счётчики сборки входящих сообщений
+ * @param stats Результат
+ * @return ESP_OK при успехе, ESP_ERR_INVALID_STATE до первой инициализации
+ */
+esp_err_t websocket_client_get_inbound_stats(ws_reassembly_stats_t* stats);
+
 /**
  * @brief Деинициализация WebSocket клиента
  */
@@ -0,0 +1,134 @@
+#pragma once
+
+#include "led_controller.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Разбор входящих команд WebSocket прямо в буфере кадра: без копии, без
+ * DOM и без кучи. Верхний объект сканируется один раз в таблицу полей
+ * (ключ -> участок значения), тип выбирается по длине имени, а разбор
+ * команды проверяет поля и диапазоны и заполняет типизированную
+ * структуру. Строки (ws_span_t) указывают в исходный буфер и живут,
+ * пока жив он; escape-последовательности в них не раскрываются. Модуль
+ * не зависит от ESP-IDF и собирается на хосте.
+ */
+
+#define WS_COMMAND_MAX_FIELDS 16   ///< Поля сверх этого числа пропускаются
+#define WS_COMMAND_MAX_DEPTH 8     ///< Допустимая вложенность JSON
+#define WS_COMMAND_BATCH_MAX_OPS 8 ///< Операций в одном batch
+
+typedef enum {
+    WS_COMMAND_SET_SERVO = 0,
+    WS_COMMAND_SET_POSE,
+    WS_COMMAND_SET_LED_COLOR,
+    WS_COMMAND_SET_LED_EFFECT,
+    WS_COMMAND_SET_LED_BRIGHTNESS,
+    WS_COMMAND_CLEAR_LEDS,
+    WS_COMMAND_ACK,
+    WS_COMMAND_ERROR,
+    WS_COMMAND_BATCH,
+    WS_COMMAND_COUNT,
+} ws_command_type_t;
+
+typedef enum {
+    WS_COMMAND_OK = 0,
+    WS_COMMAND_MALFORMED,       ///< Не JSON-объект или превышена вложенность
+    WS_COMMAND_NO_TYPE,         ///< Нет строкового поля type
+    WS_COMMAND_UNKNOWN_TYPE,
+    WS_COMMAND_INVALID,         ///< Обязательное поле отсутствует или вне диапазона
+    WS_COMMAND_FAILED,          ///< Не от разбора: контроллер отказался выполнить команду
+} ws_command_status_t;
+
+/** Участок исходного буфера */
+typedef struct {
+    const char *ptr;
+    size_t len;
+} ws_span_t;
+
+/** set_servo: {"id":1|2,"angle":0..180 (дробный),"durationMs":..} */
+typedef struct {
+    uint8_t id;
+    int32_t angle_cdeg;
+    uint32_t duration_ms;       ///< 0 — плавное движение без заданного времени
+} ws_cmd_servo_t;
+
+/** set_pose: {"pan":0..180,"tilt":0..180,"durationMs":..} */
+typedef struct {
+    int pan;
+    int tilt;
+    uint32_t duration_ms;
+} ws_cmd_pose_t;
+
+/** ack: {"action":..,"seq":..,"resync":true,"heartbeatFormat":..} */
+typedef struct {
+    ws_span_t action;
+    ws_span_t heartbeat_format;
+    bool has_seq;
+    uint32_t seq;
+    bool resync;
+} ws_cmd_ack_t;
+
+/**
+ * batch: {"ops":[{"type":"set_led_color",..},{"type":"set_pose",..},..]}
+ *
+ * Операции — команды управления (не ack, error и batch). Разбор проверяет
+ * каждую; если хоть одна неверна, отклоняется весь пакет. Сами операции
+ * остаются участками буфера, их разбирает ws_command_parse_op.
+ */
+typedef struct {
+    uint8_t count;
+    ws_span_t ops[WS_COMMAND_BATCH_MAX_OPS];
+} ws_cmd_batch_t;
+
+/** Разобранная и проверенная команда */
+typedef struct {
+    ws_command_type_t type;
+    bool has_seq;               ///< Бэкенд ждёт command_ack с этим номером
+    uint32_t seq;               ///< Поле "seq" верхнего объекта
+    union {
+        ws_cmd_servo_t servo;
+        ws_cmd_pose_t pose;
+        led_rgb_t led_color;            ///< set_led_color: {"r":..,"g":..,"b":..}
+        led_effect_t led_effect;        ///< set_led_effect, формат см. ws_command.c
+        uint8_t led_brightness;         ///< set_led_brightness: {"brightness":0..255}
+        ws_cmd_ack_t ack;
+        ws_span_t error;                ///< error: {"error":".."}, пустой если поля нет
+        ws_cmd_batch_t batch;
+    };
+} ws_command_t;
+
+/**
+ * @brief Разобрать команду
+ * @param data Текст кадра (без завершающего нуля)
+ * @param command Результат; при ошибке заполнены только has_seq и seq
+ *                (кроме WS_COMMAND_MALFORMED)
+ * @return WS_COMMAND_OK или причина отказа
+ */
+ws_command_status_t ws_command_parse(const char *data, size_t len, ws_command_t *command);
+
+/**
+ * @brief Разобрать операцию пакета, проверенную ws_command_parse
+ * @param op Участок из ws_cmd_batch_t.ops
+ * @param command Результат
+ * @return WS_COMMAND_OK или причина отказа
+ */
+ws_command_status_t ws_command_parse_op(const ws_span_t *op, ws_command_t *command);
+
+/** Имя команды в протоколе */
+const char *ws_command_name(ws_command_type_t type);
+
+/** Короткое описание статуса для журнала */
+const char *ws_command_status_name(ws_command_status_t status);
+
+/** Совпадает ли участок с C-строкой */
+bool ws_span_equals(ws_span_t span, const char *text);
+
+#ifdef __cplusplus
+}
+#endif
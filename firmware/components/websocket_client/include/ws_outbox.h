@@ -0,0 +1,108 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Ограниченная очередь исходящих сообщений WebSocket. Сообщения лежат
+ * подряд в общем байтовом буфере (без кучи) и выдаются по классам
+ * приоритета, внутри класса — по порядку постановки.
+ *
+ * При нехватке места вытесняется самое старое сообщение самого младшего
+ * класса, не старше нового, если так вообще можно освободить место;
+ * управляющие сообщения не вытесняются никогда.
+ * Сообщение с ненулевым kind заменяет ожидающее сообщение того же вида:
+ * устаревшая телеметрия не отправляется. Модуль не зависит от ESP-IDF и
+ * не потокобезопасен: блокировку держит вызывающий.
+ */
+
+#ifdef CONFIG_WS_CLIENT_OUTBOX_SIZE
+#define WS_OUTBOX_SIZE CONFIG_WS_CLIENT_OUTBOX_SIZE
+#else
+#define WS_OUTBOX_SIZE 6144
+#endif
+#define WS_OUTBOX_MAX_MESSAGES 16
+
+/** Класс приоритета; меньшее значение отправляется раньше */
+typedef enum {
+    WS_OUTBOX_CONTROL = 0,      ///< Регистрация, подтверждения команд
+    WS_OUTBOX_TELEMETRY,        ///< Поток расстояний
+    WS_OUTBOX_DIAGNOSTICS,      ///< Heartbeat
+    WS_OUTBOX_CLASS_COUNT,
+} ws_outbox_class_t;
+
+/** Сообщение в очереди */
+typedef struct {
+    uint8_t cls;
+    uint8_t kind;
+    bool binary;
+    uint16_t offset;
+    uint16_t len;
+    int64_t enqueued_us;
+} ws_outbox_message_t;
+
+/** Счётчики класса */
+typedef struct {
+    uint32_t enqueued;
+    uint32_t sent;
+    uint32_t failed;            ///< Ушли в отправку, но send вернул ошибку
+    uint32_t dropped;           ///< Вытеснены, заменены более свежими или сброшены
+    uint32_t rejected;          ///< Не поместились в очередь
+    uint32_t last_latency_us;   ///< От постановки до конца отправки
+    uint32_t max_latency_us;
+    uint64_t total_latency_us;
+} ws_outbox_class_stats_t;
+
+typedef struct {
+    ws_outbox_class_stats_t classes[WS_OUTBOX_CLASS_COUNT];
+    uint16_t depth;
+    uint16_t max_depth;
+    uint16_t bytes;
+    uint16_t max_bytes;
+} ws_outbox_stats_t;
+
+typedef struct {
+    ws_outbox_message_t messages[WS_OUTBOX_MAX_MESSAGES];  // В порядке постановки
+    uint8_t data[WS_OUTBOX_SIZE];                          // Данные в том же порядке, без промежутков
+    uint16_t count;
+    uint16_t used;
+    ws_outbox_stats_t stats;
+} ws_outbox_t;
+
+void ws_outbox_init(ws_outbox_t *outbox);
+
+/**
+ * @brief Поставить сообщение в очередь, вытеснив при нужде менее важные
+ * @param kind Вид сообщения; 0 — сообщение ничего не заменяет
+ * @param now_us Время постановки для учёта задержки
+ * @return false, если места нет даже после вытеснения
+ */
+bool ws_outbox_push(ws_outbox_t *outbox, ws_outbox_class_t cls, uint8_t kind, bool binary,
+                    const void *data, size_t len, int64_t now_us);
+
+/**
+ * @brief Забрать самое важное сообщение
+ * @param buffer Буфер размером не меньше WS_OUTBOX_SIZE
+ * @param message Описание забранного сообщения (для ws_outbox_complete)
+ * @return Длина сообщения, 0 если очередь пуста
+ */
+size_t ws_outbox_pop(ws_outbox_t *outbox, void *buffer, size_t buffer_size, ws_outbox_message_t *message);
+
+/**
+ * @brief Учесть результат отправки забранного сообщения
+ */
+void ws_outbox_complete(ws_outbox_t *outbox, const ws_outbox_message_t *message, bool sent, int64_t now_us);
+
+/**
+ * @brief Сбросить все ожидающие сообщения (учитываются как dropped)
+ */
+void ws_outbox_clear(ws_outbox_t *outbox);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Сборка входящих сообщений WebSocket из кусков. esp_websocket_client
+ * отдаёт кадр частями не больше buffer_size (payload_offset / payload_len),
+ * а сообщение может состоять из нескольких кадров (FIN и кадры
+ * продолжения). Части складываются подряд в ограниченный буфер;
+ * сообщение, которое в него не помещается, отбрасывается целиком.
+ *
+ * Сообщение из одного куска отдаётся прямо из буфера кадра, без копии.
+ * Модуль не зависит от ESP-IDF и не потокобезопасен.
+ */
+
+#ifdef CONFIG_WS_CLIENT_MAX_MESSAGE_SIZE
+#define WS_REASSEMBLY_SIZE CONFIG_WS_CLIENT_MAX_MESSAGE_SIZE
+#else
+#define WS_REASSEMBLY_SIZE 4096
+#endif
+
+/** Коды операций кадра (RFC 6455) */
+enum {
+    WS_OPCODE_CONTINUATION = 0x0,
+    WS_OPCODE_TEXT = 0x1,
+    WS_OPCODE_BINARY = 0x2,
+    WS_OPCODE_CLOSE = 0x8,
+};
+
+typedef enum {
+    WS_REASSEMBLY_PENDING = 0,  ///< Ждём следующих кусков
+    WS_REASSEMBLY_COMPLETE,     ///< Сообщение собрано
+    WS_REASSEMBLY_DROPPED,      ///< Сообщение отброшено: велико или нарушен порядок кусков
+    WS_REASSEMBLY_IGNORED,      ///< Управляющий кадр, его обрабатывает клиент
+} ws_reassembly_status_t;
+
+/** Собранное сообщение; data действительно до следующего вызова ws_reassembly_feed */
+typedef struct {
+    const char *data;
+    size_t len;
+    bool binary;
+} ws_reassembly_message_t;
+
+typedef struct {
+    uint32_t messages;          ///< Собрано сообщений
+    uint32_t reassembled;       ///< Из них пришли несколькими кусками
+    uint32_t binary;            ///< Из них двоичных
+    uint32_t oversized;         ///< Отброшено: больше WS_REASSEMBLY_SIZE
+    uint32_t protocol_errors;   ///< Отброшено: кусок не на своём месте
+    uint32_t max_len;           ///< Самое длинное собранное сообщение
+} ws_reassembly_stats_t;
+
+typedef struct {
+    char data[WS_REASSEMBLY_SIZE];
+    size_t len;
+    size_t frame_base;          // Смещение текущего кадра в сообщении
+    uint8_t opcode;
+    bool active;                // Сообщение начато и ещё не закончено
+    bool overflow;              // Не помещается: пропускаем куски до конца
+    ws_reassembly_stats_t stats;
+} ws_reassembly_t;
+
+void ws_reassembly_init(ws_reassembly_t *reassembly);
+
+/**
+ * @brief Сбросить недособранное сообщение (при разрыве соединения)
+ */
+void ws_reassembly_reset(ws_reassembly_t *reassembly);
+
+/**
+ * @brief Передать очередной кусок кадра
+ *
+ * @param opcode Код операции кадра
+ * @param fin Последний кадр сообщения
+ * @param data Данные куска
+ * @param len Длина куска
+ * @param payload_len Полная длина кадра
+ * @param payload_offset Смещение куска в кадре
+ * @param message Собранное сообщение при WS_REASSEMBLY_COMPLETE
+ */
+ws_reassembly_status_t ws_reassembly_feed(ws_reassembly_t *reassembly, uint8_t opcode, bool fin,
+                                          const char *data, size_t len, size_t payload_len,
+                                          size_t payload_offset, ws_reassembly_message_t *message);
+
+#ifdef __cplusplus
+}
+#endif
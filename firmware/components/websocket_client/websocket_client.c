@@ -1,15 +1,42 @@
 #include "websocket_client.h"
+#include "heartbeat_bin.h"
+#include "heartbeat_json.h"
+#include "ws_outbox.h"
+#include "ws_command.h"
+#include "ws_reassembly.h"
+#include "json_writer.h"
 #include "servo_controller.h"
 #include "led_controller.h"
 #include "uwb_positioning.h"
-#include "cJSON.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/semphr.h"
+#include <stdatomic.h>
 #include <string.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 #define WS_HEARTBEAT_INTERVAL_MS 1000
+#define WS_REGISTER_BUFFER_SIZE 160
+#define WS_COMMAND_ACK_BUFFER_SIZE 128
+#define WS_LOG_MESSAGE_MAX 96           // Сколько символов отклонённого сообщения попадает в журнал
+#define WS_SENDER_TASK_STACK_SIZE 4096
+#define WS_SENDER_TASK_PRIORITY 4       // Как у планировщика network: ниже control
+
+#ifdef CONFIG_WS_CLIENT_HEARTBEAT_KEYFRAME_INTERVAL
+#define WS_HEARTBEAT_KEYFRAME_INTERVAL CONFIG_WS_CLIENT_HEARTBEAT_KEYFRAME_INTERVAL
+#else
+#define WS_HEARTBEAT_KEYFRAME_INTERVAL 30
+#endif
+
+#ifdef CONFIG_WS_CLIENT_RANGE_STREAM_MAX_HZ
+#define WS_RANGE_STREAM_MAX_HZ CONFIG_WS_CLIENT_RANGE_STREAM_MAX_HZ
+#else
+#define WS_RANGE_STREAM_MAX_HZ 20
+#endif
+#define WS_RANGE_STREAM_INTERVAL_MS (1000 / WS_RANGE_STREAM_MAX_HZ)
 
 static const char *TAG = "WS_CLIENT";
 
@@ -18,6 +45,52 @@ static device_config_t s_device_config = {0};
 static bool s_is_connected = false;
 static TickType_t s_last_heartbeat = 0;
 static bool s_last_send_failed = false;  // Флаг последней ошибки отправки
+static bool s_binary_heartbeat = false;  // Бэкенд подтвердил бинарный heartbeat
+
+// Heartbeat и ranges собираются только из задания heartbeat, поэтому буферы общие
+static uwb_range_t s_heartbeat_ranges[UWB_MAX_RANGES];
+static uint8_t s_heartbeat_buffer[HEARTBEAT_BIN_MAX_SIZE];
+static char s_heartbeat_json[HEARTBEAT_JSON_MAX_SIZE];
+
+// Разностный JSON heartbeat: состояние последнего отправленного heartbeat
+// принадлежит заданию heartbeat, задача WebSocket только сообщает о его ack
+static heartbeat_state_t s_heartbeat_state;
+static heartbeat_state_t s_heartbeat_sent;
+static uint32_t s_heartbeat_seq = 0;             // Номер последнего отправленного, 0 — не было
+static uint32_t s_heartbeats_since_keyframe = 0;
+static atomic_uint s_heartbeat_acked_seq;        // Номер из последнего ack heartbeat
+static atomic_bool s_heartbeat_resync;           // Следующий heartbeat должен быть опорным
+
+// Поток расстояний: uwb_positioning отмечает изменение, задание heartbeat
+// отправляет не чаще WS_RANGE_STREAM_MAX_HZ раз в секунду
+static atomic_bool s_ranges_changed;
+static TickType_t s_last_range_push = 0;
+
+// Иначе ws_outbox_push молча отклоняет каждый полный heartbeat и устройство
+// «пропадает» на бэкенде: размер очереди растёт вместе с числом пиров UWB
+_Static_assert(WS_OUTBOX_SIZE >= HEARTBEAT_JSON_MAX_SIZE && WS_OUTBOX_SIZE >= HEARTBEAT_BIN_MAX_SIZE,
+               "CONFIG_WS_CLIENT_OUTBOX_SIZE must hold the largest heartbeat for CONFIG_UWB_POSITIONING_MAX_PEERS");
+
+// Исходящие сообщения ставятся в очередь за микросекунды; отправляет их
+// задача ws_sender. s_send_lock держит отправка, остановка и уничтожение
+// клиента, поэтому клиент не исчезает посреди send
+static ws_outbox_t s_outbox;
+static SemaphoreHandle_t s_outbox_lock = NULL;
+static SemaphoreHandle_t s_send_lock = NULL;
+static TaskHandle_t s_sender_task = NULL;
+static uint8_t s_send_buffer[WS_OUTBOX_SIZE];
+
+// Входящие сообщения больше buffer_size клиент отдаёт кусками; собирает
+// их обработчик событий, он же единственный пишет в s_inbound
+static ws_reassembly_t s_inbound;
+static int64_t s_inbound_started_us = 0;  // Приход первого куска текущего сообщения
+
+// Виды заменяемых сообщений: в очереди остаётся только свежее
+enum {
+    WS_KIND_NONE = 0,
+    WS_KIND_HEARTBEAT,
+    WS_KIND_RANGES,
+};
 
 /**
  * @brief Парсинг URL для получения хоста, порта и пути
@@ -67,9 +140,9 @@ static esp_err_t parse_websocket_url(const char* url, char* host, int* port, cha
 }
 
 /**
- * @brief Отправить JSON сообщение через WebSocket с retry
+ * @brief Отправить кадр через WebSocket с retry
  */
-static esp_err_t send_json_message(cJSON* json)
+static esp_err_t send_payload(const char* payload, size_t msg_len, bool binary)
 {
     if (s_websocket_client == NULL) {
         ESP_LOGE(TAG, "WebSocket client is NULL");
@@ -81,21 +154,14 @@ static esp_err_t send_json_message(cJSON* json)
         return ESP_ERR_INVALID_STATE;
     }
     
-    char* json_string = cJSON_Print(json);
-    if (json_string == NULL) {
-        ESP_LOGE(TAG, "Failed to serialize JSON to string - out of memory?");
-        return ESP_ERR_NO_MEM;
-    }
-    
-    size_t msg_len = strlen(json_string);
-    ESP_LOGD(TAG, "Sending JSON message (%d bytes): %s", msg_len, json_string);
-    
     esp_err_t ret = ESP_FAIL;
     int retry_count = 3;
     
     // Пробуем отправить с retry
     for (int i = 0; i < retry_count; i++) {
-        int sent = esp_websocket_client_send_text(s_websocket_client, json_string, msg_len, pdMS_TO_TICKS(1000));
+        int sent = binary
+            ? esp_websocket_client_send_bin(s_websocket_client, payload, msg_len, pdMS_TO_TICKS(1000))
+            : esp_websocket_client_send_text(s_websocket_client, payload, msg_len, pdMS_TO_TICKS(1000));
         
         if (sent >= 0) {
             ret = ESP_OK;
@@ -103,7 +169,7 @@ static esp_err_t send_json_message(cJSON* json)
             break;
         } else {
             ret = ESP_FAIL;
-            ESP_LOGW(TAG, "Send attempt %d failed: send_text returned %d", i + 1, sent);
+            ESP_LOGW(TAG, "Send attempt %d failed: send returned %d", i + 1, sent);
             
             if (i < retry_count - 1) {
                 ESP_LOGD(TAG, "Retrying in 100ms...");
@@ -117,8 +183,8 @@ static esp_err_t send_json_message(cJSON* json)
         
         // Логируем ошибки только первый раз, потом ждем ACK
         if (!s_last_send_failed || (ret != 0x56)) { // 0x56 - известная ложная ошибка
-            ESP_LOGW(TAG, "esp_websocket_client_send_text failed after %d attempts: %s (error code 0x%x)", 
-                     retry_count, esp_err_to_name(ret), ret);
+            ESP_LOGW(TAG, "esp_websocket_client_send_%s failed after %d attempts: %s (error code 0x%x)", 
+                     binary ? "bin" : "text", retry_count, esp_err_to_name(ret), ret);
                      
             // Проверяем состояние клиента
             if (esp_websocket_client_is_connected(s_websocket_client)) {
@@ -132,123 +198,367 @@ static esp_err_t send_json_message(cJSON* json)
         s_last_send_failed = false;
     }
     
-    free(json_string);
     return ret;
 }
 
 /**
- * @brief Обработка входящих WebSocket сообщений
+ * @brief Поставить сообщение в очередь отправки
+ *
+ * Не блокируется на сети: копирует сообщение и будит ws_sender.
  */
-static esp_err_t handle_websocket_message(const char* data, int len)
+static esp_err_t enqueue_payload(ws_outbox_class_t cls, uint8_t kind, const void* payload, size_t len, bool binary)
 {
-    char* json_str = malloc(len + 1);
-    if (json_str == NULL) {
-        ESP_LOGE(TAG, "Failed to allocate memory for message");
+    if (s_outbox_lock == NULL || !s_is_connected) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    xSemaphoreTake(s_outbox_lock, portMAX_DELAY);
+    bool queued = ws_outbox_push(&s_outbox, cls, kind, binary, payload, len, esp_timer_get_time());
+    xSemaphoreGive(s_outbox_lock);
+
+    if (!queued) {
+        ESP_LOGW(TAG, "Outbound queue full, class %d message (%d bytes) rejected", (int)cls, (int)len);
         return ESP_ERR_NO_MEM;
     }
-    
-    memcpy(json_str, data, len);
-    json_str[len] = '\0';
-    
-    ESP_LOGI(TAG, "Received message: %s", json_str);
-    
-    cJSON* json = cJSON_Parse(json_str);
-    free(json_str);
-    
-    if (json == NULL) {
-        ESP_LOGE(TAG, "Failed to parse JSON message");
-        return ESP_ERR_INVALID_ARG;
+    xTaskNotifyGive(s_sender_task);
+    return ESP_OK;
+}
+
+/**
+ * @brief Задача отправки: выдаёт очередь по приоритету, пока она не опустеет
+ */
+static void sender_task(void* arg)
+{
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        while (1) {
+            ws_outbox_message_t message;
+            xSemaphoreTake(s_outbox_lock, portMAX_DELAY);
+            size_t len = ws_outbox_pop(&s_outbox, s_send_buffer, sizeof(s_send_buffer), &message);
+            xSemaphoreGive(s_outbox_lock);
+            if (len == 0) {
+                break;
+            }
+
+            xSemaphoreTake(s_send_lock, portMAX_DELAY);
+            esp_err_t ret = send_payload((const char*)s_send_buffer, len, message.binary);
+            xSemaphoreGive(s_send_lock);
+
+            xSemaphoreTake(s_outbox_lock, portMAX_DELAY);
+            ws_outbox_complete(&s_outbox, &message, ret == ESP_OK, esp_timer_get_time());
+            xSemaphoreGive(s_outbox_lock);
+        }
     }
-    
-    cJSON* type_item = cJSON_GetObjectItem(json, "type");
-    if (type_item == NULL || !cJSON_IsString(type_item)) {
-        ESP_LOGE(TAG, "Message has no 'type' field");
-        cJSON_Delete(json);
-        return ESP_ERR_INVALID_ARG;
+}
+
+/**
+ * @brief Сбросить неотправленные сообщения: после переподключения они устарели
+ */
+static void clear_outbox(void)
+{
+    if (s_outbox_lock != NULL) {
+        xSemaphoreTake(s_outbox_lock, portMAX_DELAY);
+        ws_outbox_clear(&s_outbox);
+        xSemaphoreGive(s_outbox_lock);
     }
-    
-    const char* type = type_item->valuestring;
-    
-    if (strcmp(type, "set_servo") == 0) {
-        cJSON* id_item = cJSON_GetObjectItem(json, "id");
-        cJSON* angle_item = cJSON_GetObjectItem(json, "angle");
-        
-        if (cJSON_IsNumber(id_item) && cJSON_IsNumber(angle_item)) {
-            int id = id_item->valueint;
-            int angle = angle_item->valueint;
-            
-            if (id >= 1 && id <= 2 && angle >= 0 && angle <= 180) {
-                servo_controller_move_to(id, angle, true);
-                ESP_LOGI(TAG, "Moving servo %d to %d degrees", id, angle);
-            } else {
-                ESP_LOGE(TAG, "Invalid servo command: id=%d, angle=%d", id, angle);
-            }
+}
+
+/**
+ * @brief Перевести один сервопривод
+ *
+ * durationMs — переход за заданное время аппаратным затуханием LEDC; без
+ * службы затухания (или если затухание не запустилось) — программным
+ * профилем, растянутым до того же времени.
+ */
+static esp_err_t move_servo(int id, int32_t angle_cdeg, uint32_t duration_ms)
+{
+    esp_err_t ret;
+
+    if (duration_ms > 0) {
+        ret = servo_controller_fade_to_cdeg(id, angle_cdeg, duration_ms);
+        if (ret != ESP_OK && ret != ESP_ERR_INVALID_ARG) {
+            ret = servo_controller_move_timed_cdeg(id, angle_cdeg, duration_ms);
         }
-    } else if (strcmp(type, "set_led_color") == 0) {
-        cJSON* r_item = cJSON_GetObjectItem(json, "r");
-        cJSON* g_item = cJSON_GetObjectItem(json, "g");
-        cJSON* b_item = cJSON_GetObjectItem(json, "b");
-        
-        if (cJSON_IsNumber(r_item) && cJSON_IsNumber(g_item) && cJSON_IsNumber(b_item)) {
-            led_rgb_t color = {
-                .r = (uint8_t)r_item->valueint,
-                .g = (uint8_t)g_item->valueint,
-                .b = (uint8_t)b_item->valueint
-            };
-            
-            esp_err_t ret = led_controller_set_all_color(&color);
-            if (ret == ESP_OK) {
-                ret = led_controller_update();
-                if (ret == ESP_OK) {
-                    ESP_LOGI(TAG, "LED color set to R=%d G=%d B=%d", color.r, color.g, color.b);
-                } else {
-                    ESP_LOGE(TAG, "Failed to update LED strip");
-                }
-            } else {
-                ESP_LOGE(TAG, "Failed to set LED color");
-            }
+    } else {
+        ret = servo_controller_move_to_cdeg(id, angle_cdeg, true);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to move servo %d: %s", id, esp_err_to_name(ret));
+        return ret;
+    }
+    ESP_LOGD(TAG, "Moving servo %d to %d.%02d degrees", id, (int)(angle_cdeg / 100), (int)(angle_cdeg % 100));
+    return ESP_OK;
+}
+
+/**
+ * @brief Выполнить пакет команд
+ *
+ * Операции сворачиваются по порядку в одно изменение лент (последний
+ * цвет, эффект или выключение и последняя яркость) и одну цель
+ * сервоприводов. Ленты получают один кадр, а обе оси — согласованное
+ * движение, поэтому все изменения пакета появляются одновременно.
+ *
+ * @return ESP_OK или первая ошибка контроллера лент или сервоприводов
+ */
+static esp_err_t execute_batch(const ws_cmd_batch_t* batch)
+{
+    esp_err_t ret = ESP_OK;
+    led_controller_change_t led = { .content = LED_CHANGE_KEEP };
+    bool led_changed = false;
+    bool axis_set[2] = { false, false };
+    int32_t axis_cdeg[2] = { 0, 0 };
+    uint32_t duration_ms = 0;
+
+    for (int i = 0; i < batch->count; i++) {
+        ws_command_t op;
+        if (ws_command_parse_op(&batch->ops[i], &op) != WS_COMMAND_OK) {
+            // Пакет уже проверен ws_command_parse
+            continue;
         }
-    } else if (strcmp(type, "set_led_brightness") == 0) {
-        cJSON* brightness_item = cJSON_GetObjectItem(json, "brightness");
-        
-        if (cJSON_IsNumber(brightness_item)) {
-            uint8_t brightness = (uint8_t)brightness_item->valueint;
-            
-            esp_err_t ret = led_controller_set_brightness(brightness);
-            if (ret == ESP_OK) {
-                // Нужно обновить LED ленту чтобы применить новую яркость
-                ret = led_controller_update();
-                if (ret == ESP_OK) {
-                    ESP_LOGI(TAG, "LED brightness set to %d", brightness);
-                } else {
-                    ESP_LOGE(TAG, "Failed to update LED strip with new brightness");
-                }
-            } else {
-                ESP_LOGE(TAG, "Failed to set LED brightness");
+
+        switch (op.type) {
+        case WS_COMMAND_SET_SERVO:
+            axis_set[op.servo.id - 1] = true;
+            axis_cdeg[op.servo.id - 1] = op.servo.angle_cdeg;
+            duration_ms = op.servo.duration_ms > duration_ms ? op.servo.duration_ms : duration_ms;
+            break;
+
+        case WS_COMMAND_SET_POSE:
+            axis_set[0] = axis_set[1] = true;
+            axis_cdeg[0] = op.pose.pan * 100;
+            axis_cdeg[1] = op.pose.tilt * 100;
+            duration_ms = op.pose.duration_ms > duration_ms ? op.pose.duration_ms : duration_ms;
+            break;
+
+        case WS_COMMAND_SET_LED_COLOR:
+            led.content = LED_CHANGE_COLOR;
+            led.color = op.led_color;
+            led_changed = true;
+            break;
+
+        case WS_COMMAND_SET_LED_EFFECT:
+            // Переход «от текущего» начинается с цвета, заданного раньше в пакете
+            if (op.led_effect.from_current && led.content == LED_CHANGE_COLOR) {
+                op.led_effect.from = led.color;
+                op.led_effect.from_current = false;
+            } else if (op.led_effect.from_current && led.content == LED_CHANGE_CLEAR) {
+                memset(&op.led_effect.from, 0, sizeof(op.led_effect.from));
+                op.led_effect.from_current = false;
             }
+            led.content = LED_CHANGE_EFFECT;
+            led.effect = op.led_effect;
+            led_changed = true;
+            break;
+
+        case WS_COMMAND_SET_LED_BRIGHTNESS:
+            led.set_brightness = true;
+            led.brightness = op.led_brightness;
+            led_changed = true;
+            break;
+
+        case WS_COMMAND_CLEAR_LEDS:
+            led.content = LED_CHANGE_CLEAR;
+            led_changed = true;
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    if (led_changed) {
+        ret = led_controller_apply(&led);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to apply LED changes: %s", esp_err_to_name(ret));
+        }
+    }
+
+    esp_err_t servo_ret = ESP_OK;
+    if (axis_set[0] && axis_set[1]) {
+        servo_ret = servo_controller_move_pose_cdeg(axis_cdeg[0], axis_cdeg[1], duration_ms);
+        if (servo_ret == ESP_OK) {
+            ESP_LOGD(TAG, "Moving to pose pan=%d tilt=%d cdeg", (int)axis_cdeg[0], (int)axis_cdeg[1]);
+        } else {
+            ESP_LOGE(TAG, "Failed to move to pose: %s", esp_err_to_name(servo_ret));
+        }
+    } else if (axis_set[0] || axis_set[1]) {
+        int id = axis_set[0] ? 1 : 2;
+        servo_ret = move_servo(id, axis_cdeg[id - 1], duration_ms);
+    }
+    return ret != ESP_OK ? ret : servo_ret;
+}
+
+/**
+ * @brief Выполнить разобранную и проверенную команду
+ *
+ * @return ESP_OK или ошибка контроллера, отказавшегося её выполнить
+ */
+static esp_err_t execute_command(const ws_command_t* command)
+{
+    esp_err_t ret = ESP_OK;
+
+    switch (command->type) {
+    case WS_COMMAND_SET_SERVO:
+        ret = move_servo(command->servo.id, command->servo.angle_cdeg, command->servo.duration_ms);
+        break;
+
+    case WS_COMMAND_SET_POSE:
+        ret = servo_controller_move_pose(command->pose.pan, command->pose.tilt, command->pose.duration_ms);
+        if (ret == ESP_OK) {
+            ESP_LOGD(TAG, "Moving to pose pan=%d tilt=%d", command->pose.pan, command->pose.tilt);
+        } else {
+            ESP_LOGE(TAG, "Failed to move to pose: %s", esp_err_to_name(ret));
+        }
+        break;
+
+    case WS_COMMAND_SET_LED_COLOR:
+        ret = led_controller_set_all_color(&command->led_color);
+        if (ret == ESP_OK) {
+            ret = led_controller_update();
+        }
+        if (ret == ESP_OK) {
+            ESP_LOGD(TAG, "LED color set to R=%d G=%d B=%d",
+                     command->led_color.r, command->led_color.g, command->led_color.b);
+        } else {
+            ESP_LOGE(TAG, "Failed to set LED color: %s", esp_err_to_name(ret));
         }
-    } else if (strcmp(type, "clear_leds") == 0) {
-        esp_err_t ret = led_controller_clear();
+        break;
+
+    case WS_COMMAND_SET_LED_EFFECT:
+        ret = led_controller_set_effect(&command->led_effect);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to start LED effect: %s", esp_err_to_name(ret));
+        }
+        break;
+
+    case WS_COMMAND_SET_LED_BRIGHTNESS:
+        // Яркость сразу перерисовывает и отправляет кадр
+        ret = led_controller_set_brightness(command->led_brightness);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to set LED brightness: %s", esp_err_to_name(ret));
+        }
+        break;
+
+    case WS_COMMAND_CLEAR_LEDS:
+        ret = led_controller_clear();
         if (ret == ESP_OK) {
-            ESP_LOGI(TAG, "LEDs cleared");
+            ESP_LOGD(TAG, "LEDs cleared");
         } else {
             ESP_LOGE(TAG, "Failed to clear LEDs");
         }
-    } else if (strcmp(type, "ack") == 0) {
-        // Heartbeat ACK - это нормально, сбрасываем флаг ошибки
-        ESP_LOGD(TAG, "Received heartbeat ACK");
+        break;
+
+    case WS_COMMAND_ACK: {
+        const ws_cmd_ack_t* ack = &command->ack;
+        if (ws_span_equals(ack->action, "register")) {
+            // Бэкенд без поддержки бинарного формата просто не вернёт поле
+            s_binary_heartbeat = ws_span_equals(ack->heartbeat_format, HEARTBEAT_BIN_FORMAT);
+            ESP_LOGI(TAG, "Registration acknowledged, heartbeat format: %s",
+                     s_binary_heartbeat ? HEARTBEAT_BIN_FORMAT : "json");
+        }
+
+        if (ws_span_equals(ack->action, "heartbeat")) {
+            if (ack->has_seq) {
+                atomic_store(&s_heartbeat_acked_seq, ack->seq);
+            }
+            // Бэкенд потерял состояние устройства (перезапуск, новая сессия)
+            if (ack->resync) {
+                atomic_store(&s_heartbeat_resync, true);
+                ESP_LOGI(TAG, "Backend requested heartbeat resync");
+            }
+        }
+
         // Если получили ACK, значит предыдущая отправка была успешной несмотря на ошибку
         s_last_send_failed = false;
-    } else if (strcmp(type, "error") == 0) {
-        cJSON* error_item = cJSON_GetObjectItem(json, "error");
-        const char* error_msg = cJSON_IsString(error_item) ? error_item->valuestring : "unknown";
-        ESP_LOGE(TAG, "Server error: %s", error_msg);
-    } else {
-        ESP_LOGW(TAG, "Unknown message type: %s", type);
+        break;
     }
-    
-    cJSON_Delete(json);
-    return ESP_OK;
+
+    case WS_COMMAND_ERROR:
+        ESP_LOGE(TAG, "Server error: %.*s", (int)command->error.len, command->error.ptr);
+        break;
+
+    case WS_COMMAND_BATCH:
+        ret = execute_batch(&command->batch);
+        break;
+
+    default:
+        break;
+    }
+    return ret;
+}
+
+/**
+ * @brief Поставить в очередь подтверждение команды с номером
+ *
+ * Время — по esp_timer устройства: бэкенд вычитает rxUs из acceptedUs,
+ * а сетевую часть задержки оценивает по своему времени ответа. acceptedUs —
+ * момент, когда команда разобрана и передана контроллеру, а не момент
+ * физического изменения: сервопривод сдвинется на ближайшем кадре задания
+ * servo, лента обновится при следующей отправке кадра.
+ */
+static void send_command_ack(uint32_t seq, ws_command_status_t status, int64_t rx_us, int64_t accepted_us)
+{
+    static const char* const status_codes[] = {
+        [WS_COMMAND_OK] = "ok",
+        [WS_COMMAND_MALFORMED] = "malformed",
+        [WS_COMMAND_NO_TYPE] = "no_type",
+        [WS_COMMAND_UNKNOWN_TYPE] = "unknown_type",
+        [WS_COMMAND_INVALID] = "invalid",
+        [WS_COMMAND_FAILED] = "failed",
+    };
+    char buffer[WS_COMMAND_ACK_BUFFER_SIZE];
+    json_writer_t writer;
+
+    json_writer_init(&writer, buffer, sizeof(buffer));
+    json_writer_object_begin(&writer);
+    json_writer_field_string(&writer, "type", "command_ack");
+    json_writer_field_uint(&writer, "seq", seq);
+    json_writer_field_string(&writer, "status", status_codes[status]);
+    json_writer_field_uint(&writer, "rxUs", (uint64_t)rx_us);
+    json_writer_field_uint(&writer, "acceptedUs", (uint64_t)accepted_us);
+    json_writer_object_end(&writer);
+    size_t len = json_writer_finish(&writer);
+
+    if (len == 0 || enqueue_payload(WS_OUTBOX_CONTROL, WS_KIND_NONE, buffer, len, false) != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to queue command ack %u", (unsigned)seq);
+    }
+}
+
+/**
+ * @brief Обработка входящих WebSocket сообщений
+ *
+ * Команда разбирается прямо в буфере кадра, без копии и кучи. Команда
+ * управления с номером подтверждается, когда она передана контроллеру
+ * сервоприводов или лент; само изменение происходит позже, в их заданиях.
+ * Если контроллер отказался её выполнить, ack несёт статус "failed".
+ *
+ * @param rx_us Время прихода первого куска сообщения
+ */
+static esp_err_t handle_websocket_message(const char* data, size_t len, int64_t rx_us)
+{
+    ws_command_t command;
+    ws_command_status_t status = ws_command_parse(data, len, &command);
+    // ack и error от бэкенда — ответы, а не команды, их не подтверждаем
+    bool needs_ack = status != WS_COMMAND_MALFORMED && command.has_seq &&
+                     (status != WS_COMMAND_OK || (command.type != WS_COMMAND_ACK && command.type != WS_COMMAND_ERROR));
+
+    if (status != WS_COMMAND_OK) {
+        ESP_LOGW(TAG, "Rejected message (%s): %.*s", ws_command_status_name(status),
+                 (int)(len > WS_LOG_MESSAGE_MAX ? WS_LOG_MESSAGE_MAX : len), data);
+        if (needs_ack) {
+            send_command_ack(command.seq, status, rx_us, esp_timer_get_time());
+        }
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    ESP_LOGD(TAG, "Received %s (%u bytes)", ws_command_name(command.type), (unsigned)len);
+    esp_err_t ret = execute_command(&command);
+    if (needs_ack) {
+        send_command_ack(command.seq, ret == ESP_OK ? WS_COMMAND_OK : WS_COMMAND_FAILED, rx_us,
+                         esp_timer_get_time());
+    }
+    return ret;
 }
 
 /**
@@ -262,32 +572,60 @@ static void websocket_event_handler(void* handler_args, esp_event_base_t base, i
         case WEBSOCKET_EVENT_CONNECTED:
             ESP_LOGI(TAG, "WebSocket connected");
             s_is_connected = true;
+            s_binary_heartbeat = false;
+            atomic_store(&s_heartbeat_resync, true);
             
             // Отправляем сообщение регистрации
-            cJSON* register_json = cJSON_CreateObject();
-            cJSON_AddStringToObject(register_json, "type", "register");
-            cJSON_AddStringToObject(register_json, "deviceId", s_device_config.device_id);
+            char register_buffer[WS_REGISTER_BUFFER_SIZE];
+            json_writer_t writer;
+            json_writer_init(&writer, register_buffer, sizeof(register_buffer));
+            json_writer_object_begin(&writer);
+            json_writer_field_string(&writer, "type", "register");
+            json_writer_field_string(&writer, "deviceId", s_device_config.device_id);
+#ifdef CONFIG_WS_CLIENT_BINARY_HEARTBEAT
+            json_writer_field_string(&writer, "heartbeatFormat", HEARTBEAT_BIN_FORMAT);
+#endif
+            json_writer_object_end(&writer);
+            size_t register_len = json_writer_finish(&writer);
             
-            esp_err_t ret = send_json_message(register_json);
+            esp_err_t ret = register_len > 0
+                ? enqueue_payload(WS_OUTBOX_CONTROL, WS_KIND_NONE, register_buffer, register_len, false)
+                : ESP_ERR_INVALID_SIZE;
             if (ret == ESP_OK) {
-                ESP_LOGI(TAG, "Registration message sent: deviceId=%s", s_device_config.device_id);
+                ESP_LOGI(TAG, "Registration message queued: deviceId=%s", s_device_config.device_id);
             } else {
-                ESP_LOGE(TAG, "Failed to send registration message");
+                ESP_LOGE(TAG, "Failed to queue registration message");
             }
-            
-            cJSON_Delete(register_json);
             break;
             
         case WEBSOCKET_EVENT_DISCONNECTED:
             ESP_LOGI(TAG, "WebSocket disconnected");
             s_is_connected = false;
+            s_binary_heartbeat = false;
+            atomic_store(&s_heartbeat_resync, true);
+            clear_outbox();
+            ws_reassembly_reset(&s_inbound);
             break;
             
-        case WEBSOCKET_EVENT_DATA:
-            if (data->op_code == 0x01) { // Text frame
-                handle_websocket_message(data->data_ptr, data->data_len);
+        case WEBSOCKET_EVENT_DATA: {
+            // Текстовые и двоичные кадры несут одни и те же JSON-команды
+            if (data->payload_offset == 0 && (data->op_code == WS_OPCODE_TEXT || data->op_code == WS_OPCODE_BINARY)) {
+                s_inbound_started_us = esp_timer_get_time();
+            }
+            ws_reassembly_message_t message;
+            ws_reassembly_status_t status = ws_reassembly_feed(
+                &s_inbound, data->op_code, data->fin, data->data_ptr,
+                data->data_len > 0 ? (size_t)data->data_len : 0,
+                data->payload_len > 0 ? (size_t)data->payload_len : 0,
+                data->payload_offset > 0 ? (size_t)data->payload_offset : 0, &message);
+            if (status == WS_REASSEMBLY_COMPLETE) {
+                handle_websocket_message(message.data, message.len, s_inbound_started_us);
+            } else if (status == WS_REASSEMBLY_DROPPED) {
+                ESP_LOGW(TAG, "Dropped inbound message (frame %d bytes, limit %d)",
+                         data->payload_len, WS_REASSEMBLY_SIZE);
             }
             break;
+        }
             
         case WEBSOCKET_EVENT_ERROR:
             ESP_LOGE(TAG, "WebSocket error");
@@ -300,6 +638,17 @@ static void websocket_event_handler(void* handler_args, esp_event_base_t base, i
     }
 }
 
+#ifdef CONFIG_WS_CLIENT_RANGE_STREAM
+/**
+ * @brief Обработчик изменения расстояний (контекст задачи разбора UART)
+ */
+static void on_ranges_changed(void* ctx)
+{
+    (void)ctx;
+    atomic_store(&s_ranges_changed, true);
+}
+#endif
+
 esp_err_t websocket_client_init(const device_config_t* config)
 {
     if (config == NULL || !config->is_valid) {
@@ -308,6 +657,20 @@ esp_err_t websocket_client_init(const device_config_t* config)
     }
     
     s_device_config = *config;
+
+    // Очередь и задача отправки создаются один раз и переживают переподключения
+    if (s_sender_task == NULL) {
+        ws_outbox_init(&s_outbox);
+        ws_reassembly_init(&s_inbound);
+        s_outbox_lock = xSemaphoreCreateMutex();
+        s_send_lock = xSemaphoreCreateMutex();
+        if (s_outbox_lock == NULL || s_send_lock == NULL ||
+            xTaskCreate(sender_task, "ws_sender", WS_SENDER_TASK_STACK_SIZE, NULL,
+                        WS_SENDER_TASK_PRIORITY, &s_sender_task) != pdPASS) {
+            ESP_LOGE(TAG, "Failed to create WebSocket sender task");
+            return ESP_ERR_NO_MEM;
+        }
+    }
     
     // Парсим URL
     char host[256];
@@ -356,6 +719,10 @@ esp_err_t websocket_client_init(const device_config_t* config)
     }
     
     s_last_heartbeat = xTaskGetTickCount();
+    s_last_range_push = s_last_heartbeat;
+#ifdef CONFIG_WS_CLIENT_RANGE_STREAM
+    uwb_positioning_set_change_callback(on_ranges_changed, NULL);
+#endif
     
     ESP_LOGI(TAG, "WebSocket client initialized");
     return ESP_OK;
@@ -371,7 +738,10 @@ esp_err_t websocket_client_start(void)
     return esp_websocket_client_start(s_websocket_client);
 }
 
-esp_err_t websocket_client_stop(void)
+/**
+ * @brief Остановить клиент (под s_send_lock)
+ */
+static esp_err_t stop_locked(void)
 {
     if (s_websocket_client == NULL) {
         return ESP_OK;
@@ -381,11 +751,125 @@ esp_err_t websocket_client_stop(void)
     return esp_websocket_client_stop(s_websocket_client);
 }
 
+esp_err_t websocket_client_stop(void)
+{
+    if (s_send_lock == NULL) {
+        return ESP_OK;
+    }
+
+    xSemaphoreTake(s_send_lock, portMAX_DELAY);
+    esp_err_t ret = stop_locked();
+    xSemaphoreGive(s_send_lock);
+    clear_outbox();
+    return ret;
+}
+
 bool websocket_client_is_connected(void)
 {
     return s_is_connected;
 }
 
+/**
+ * @brief Отправить heartbeat в бинарном формате bin1 без выделения памяти
+ */
+static esp_err_t send_binary_heartbeat(const servo_status_t* status)
+{
+    uwb_positioning_stats_t uwb_stats = {0};
+    uwb_positioning_get_stats(&uwb_stats);
+    size_t range_count = uwb_positioning_get_ranges(s_heartbeat_ranges, UWB_MAX_RANGES);
+
+    size_t len = heartbeat_bin_encode(s_heartbeat_buffer, sizeof(s_heartbeat_buffer), status,
+                                      uwb_positioning_is_ready(), &uwb_stats,
+                                      s_heartbeat_ranges, range_count);
+    if (len == 0) {
+        ESP_LOGE(TAG, "Binary heartbeat does not fit into %d bytes", (int)sizeof(s_heartbeat_buffer));
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    ESP_LOGD(TAG, "Queueing binary heartbeat (%d bytes, %d ranges)", (int)len, (int)range_count);
+    return enqueue_payload(WS_OUTBOX_DIAGNOSTICS, WS_KIND_HEARTBEAT, s_heartbeat_buffer, len, true);
+}
+
+/**
+ * @brief Можно ли отправить разностный heartbeat относительно s_heartbeat_sent
+ *
+ * Разность допустима, только если бэкенд подтвердил именно последний
+ * отправленный heartbeat: при пропущенном ack неизвестно, какие поля он
+ * применил, и отправляется опорный.
+ */
+static bool heartbeat_delta_allowed(void)
+{
+    bool resync = atomic_exchange(&s_heartbeat_resync, false);
+    if (resync || s_heartbeat_seq == 0) {
+        return false;
+    }
+    if (atomic_load(&s_heartbeat_acked_seq) != s_heartbeat_seq) {
+        ESP_LOGD(TAG, "Heartbeat %u not acknowledged, sending keyframe", (unsigned)s_heartbeat_seq);
+        return false;
+    }
+    return s_heartbeats_since_keyframe < WS_HEARTBEAT_KEYFRAME_INTERVAL;
+}
+
+/**
+ * @brief Отправить heartbeat компактным JSON без выделения памяти
+ *
+ * После регистрации, раз в WS_HEARTBEAT_KEYFRAME_INTERVAL heartbeat и при
+ * пропуске ack отправляется опорный heartbeat, в остальное время — только
+ * изменившиеся поля.
+ */
+static esp_err_t send_json_heartbeat(const servo_status_t* status)
+{
+    heartbeat_state_t* state = &s_heartbeat_state;
+    state->servo = *status;
+    state->uwb_ready = uwb_positioning_is_ready();
+    uwb_positioning_get_stats(&state->stats);
+    state->range_count = uwb_positioning_get_ranges(s_heartbeat_ranges, UWB_MAX_RANGES);
+
+    bool delta = heartbeat_delta_allowed();
+    uint32_t seq = s_heartbeat_seq + 1;
+    if (seq == 0) {
+        seq = 1;
+    }
+
+    size_t len = heartbeat_json_encode(s_heartbeat_json, sizeof(s_heartbeat_json), s_device_config.device_id,
+                                       seq, state, delta ? &s_heartbeat_sent : NULL, s_heartbeat_ranges);
+    if (len == 0) {
+        ESP_LOGE(TAG, "Heartbeat JSON does not fit into %d bytes", (int)sizeof(s_heartbeat_json));
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    // Номер и состояние запоминаются и при ошибке отправки: ack на этот номер
+    // не придёт, и следующий heartbeat станет опорным
+    s_heartbeat_seq = seq;
+    s_heartbeat_sent = *state;
+    s_heartbeats_since_keyframe = delta ? s_heartbeats_since_keyframe + 1 : 0;
+
+    ESP_LOGD(TAG, "Queueing %s heartbeat JSON #%u (%d bytes): %s", delta ? "delta" : "keyframe",
+             (unsigned)seq, (int)len, s_heartbeat_json);
+    return enqueue_payload(WS_OUTBOX_DIAGNOSTICS, WS_KIND_HEARTBEAT, s_heartbeat_json, len, false);
+}
+
+/**
+ * @brief Отправить сообщение ranges с текущими расстояниями
+ */
+static esp_err_t send_range_update(void)
+{
+    size_t range_count = uwb_positioning_get_ranges(s_heartbeat_ranges, UWB_MAX_RANGES);
+    if (range_count == 0) {
+        return ESP_OK;
+    }
+
+    size_t len = heartbeat_json_encode_ranges(s_heartbeat_json, sizeof(s_heartbeat_json),
+                                              s_heartbeat_ranges, range_count);
+    if (len == 0) {
+        ESP_LOGE(TAG, "Ranges JSON does not fit into %d bytes", (int)sizeof(s_heartbeat_json));
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    ESP_LOGD(TAG, "Queueing ranges (%d bytes, %d ranges)", (int)len, (int)range_count);
+    return enqueue_payload(WS_OUTBOX_TELEMETRY, WS_KIND_RANGES, s_heartbeat_json, len, false);
+}
+
 esp_err_t websocket_client_send_heartbeat(void)
 {
     if (!s_is_connected) {
@@ -400,103 +884,17 @@ esp_err_t websocket_client_send_heartbeat(void)
     
     servo_status_t status;
     servo_controller_get_status(&status);
-    
-    cJSON* heartbeat_json = cJSON_CreateObject();
-    if (heartbeat_json == NULL) {
-        ESP_LOGE(TAG, "Failed to create heartbeat JSON object - out of memory?");
-        return ESP_ERR_NO_MEM;
-    }
-
-    cJSON_AddStringToObject(heartbeat_json, "type", "heartbeat");
-    cJSON_AddStringToObject(heartbeat_json, "deviceId", s_device_config.device_id);
-    
-    cJSON* servo1 = cJSON_CreateObject();
-    if (servo1 == NULL) {
-        ESP_LOGE(TAG, "Failed to create servo1 JSON object");
-        cJSON_Delete(heartbeat_json);
-        return ESP_ERR_NO_MEM;
-    }
-    cJSON_AddNumberToObject(servo1, "angle", status.angle1);
-    cJSON_AddItemToObject(heartbeat_json, "servo1", servo1);
-    
-    cJSON* servo2 = cJSON_CreateObject();
-    if (servo2 == NULL) {
-        ESP_LOGE(TAG, "Failed to create servo2 JSON object");
-        cJSON_Delete(heartbeat_json);
-        return ESP_ERR_NO_MEM;
-    }
-    cJSON_AddNumberToObject(servo2, "angle", status.angle2);
-    cJSON_AddItemToObject(heartbeat_json, "servo2", servo2);
-
-    cJSON* uwb = cJSON_CreateObject();
-    cJSON* ranges = cJSON_CreateArray();
-    if (uwb != NULL && ranges != NULL) {
-        uwb_range_t current_ranges[UWB_MAX_RANGES];
-        size_t range_count = uwb_positioning_get_ranges(current_ranges, UWB_MAX_RANGES);
-        uwb_positioning_stats_t uwb_stats = {0};
-        uwb_positioning_get_stats(&uwb_stats);
-
-        for (size_t i = 0; i < range_count; i++) {
-            cJSON* range = cJSON_CreateObject();
-            if (range == NULL) {
-                continue;
-            }
-
-            cJSON_AddStringToObject(range, "peerId", current_ranges[i].peer_id);
-            cJSON_AddNumberToObject(range, "distanceM", current_ranges[i].distance_m);
-            cJSON_AddNumberToObject(range, "updatedAtMs", current_ranges[i].updated_at_ms);
-            cJSON_AddNumberToObject(range, "rssiDbm", current_ranges[i].rssi_dbm);
-            cJSON_AddItemToArray(ranges, range);
-        }
 
-        cJSON_AddItemToObject(uwb, "ranges", ranges);
-        cJSON_AddBoolToObject(uwb, "ready", uwb_positioning_is_ready());
-        cJSON_AddNumberToObject(uwb, "rangeCount", range_count);
-        cJSON_AddNumberToObject(uwb, "uartBytes", uwb_stats.total_bytes);
-        cJSON_AddNumberToObject(uwb, "discardedBytes", uwb_stats.discarded_bytes);
-        cJSON_AddNumberToObject(uwb, "parsedFrames", uwb_stats.parsed_frames);
-        cJSON_AddNumberToObject(uwb, "invalidFrames", uwb_stats.invalid_frames);
-        cJSON_AddNumberToObject(uwb, "parsedLines", uwb_stats.parsed_lines);
-        cJSON_AddNumberToObject(uwb, "invalidLines", uwb_stats.invalid_lines);
-        cJSON_AddNumberToObject(uwb, "lastByteAtMs", uwb_stats.last_byte_at_ms);
-        cJSON_AddStringToObject(uwb, "lastRxHex", uwb_stats.last_rx_hex);
-        cJSON_AddBoolToObject(uwb, "autoConfig", uwb_stats.auto_config_enabled);
-        cJSON_AddNumberToObject(uwb, "role", uwb_stats.role);
-        cJSON_AddNumberToObject(uwb, "pid", uwb_stats.pid);
-        cJSON_AddNumberToObject(uwb, "period", uwb_stats.period);
-        cJSON_AddNumberToObject(uwb, "localAddress", uwb_stats.local_address);
-        cJSON_AddNumberToObject(uwb, "peer0Address", uwb_stats.peer0_address);
-        cJSON_AddItemToObject(heartbeat_json, "uwb", uwb);
-    } else {
-        if (uwb != NULL) cJSON_Delete(uwb);
-        if (ranges != NULL) cJSON_Delete(ranges);
-    }
-    
     ESP_LOGD(TAG, "Sending heartbeat with servo1=%d, servo2=%d", status.angle1, status.angle2);
+
+    esp_err_t ret = s_binary_heartbeat ? send_binary_heartbeat(&status) : send_json_heartbeat(&status);
     
-    esp_err_t ret = send_json_message(heartbeat_json);
-    cJSON_Delete(heartbeat_json);
-    
+    // Отправку и её ошибки ведёт ws_sender; здесь ошибка значит, что
+    // heartbeat не попал в очередь
     if (ret == ESP_OK) {
-        ESP_LOGD(TAG, "Heartbeat sent successfully");
+        ESP_LOGD(TAG, "Heartbeat queued");
     } else {
-        // Не логируем ошибку 0x56 как критическую - это известный баг ESP-IDF
-        if (ret == 0x56) {
-            ESP_LOGD(TAG, "Heartbeat send returned 0x56 (false error - message likely delivered)");
-        } else {
-            ESP_LOGE(TAG, "Failed to send heartbeat: %s (error code 0x%x)", esp_err_to_name(ret), ret);
-            
-            // Дополнительная диагностика
-            if (ret == ESP_ERR_INVALID_STATE) {
-                ESP_LOGE(TAG, "WebSocket client state issue - client may be disconnecting");
-            } else if (ret == ESP_ERR_NO_MEM) {
-                ESP_LOGE(TAG, "Out of memory when sending heartbeat");
-            } else if (ret == ESP_ERR_TIMEOUT) {
-                ESP_LOGE(TAG, "Timeout when sending heartbeat - connection may be slow");
-            } else {
-                ESP_LOGE(TAG, "Unknown error when sending heartbeat");
-            }
-        }
+        ESP_LOGW(TAG, "Failed to queue heartbeat: %s", esp_err_to_name(ret));
     }
     
     return ret;
@@ -513,16 +911,60 @@ void websocket_client_heartbeat_task(void)
         }
         s_last_heartbeat = current_time;
     }
+
+    // Изменившиеся расстояния уходят сразу, но не чаще WS_RANGE_STREAM_MAX_HZ;
+    // всё, что накопилось за интервал, схлопывается в одно сообщение
+    if (atomic_load(&s_ranges_changed) &&
+        (current_time - s_last_range_push) >= pdMS_TO_TICKS(WS_RANGE_STREAM_INTERVAL_MS)) {
+        atomic_store(&s_ranges_changed, false);
+        if (s_is_connected) {
+            send_range_update();
+        }
+        s_last_range_push = current_time;
+    }
+}
+
+esp_err_t websocket_client_get_outbox_stats(ws_outbox_stats_t* stats)
+{
+    if (stats == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_outbox_lock == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    xSemaphoreTake(s_outbox_lock, portMAX_DELAY);
+    *stats = s_outbox.stats;
+    xSemaphoreGive(s_outbox_lock);
+    return ESP_OK;
+}
+
+esp_err_t websocket_client_get_inbound_stats(ws_reassembly_stats_t* stats)
+{
+    if (stats == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_sender_task == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // Счётчики пишет только задача клиента; рассогласование между полями
+    // в один кадр для диагностики несущественно
+    *stats = s_inbound.stats;
+    return ESP_OK;
 }
 
 void websocket_client_deinit(void)
 {
     if (s_websocket_client != NULL) {
-        websocket_client_stop();
+        xSemaphoreTake(s_send_lock, portMAX_DELAY);
+        stop_locked();
         esp_websocket_client_destroy(s_websocket_client);
         s_websocket_client = NULL;
+        xSemaphoreGive(s_send_lock);
     }
     
     s_is_connected = false;
+    clear_outbox();
     ESP_LOGI(TAG, "WebSocket client deinitialized");
 }
@@ -0,0 +1,710 @@
+#include "ws_command.h"
+
+#include <math.h>
+#include <string.h>
+
+typedef struct {
+    const char *p;
+    const char *end;
+} scanner_t;
+
+typedef struct {
+    ws_span_t key;      // Без кавычек
+    ws_span_t value;    // Токен целиком: строка с кавычками, объект со скобками
+} ws_field_t;
+
+typedef struct {
+    ws_field_t items[WS_COMMAND_MAX_FIELDS];
+    int count;
+} ws_fields_t;
+
+typedef bool (*ws_command_parser_t)(const ws_fields_t *fields, ws_command_t *command);
+
+typedef struct {
+    const char *name;
+    ws_command_parser_t parse;
+} ws_command_spec_t;
+
+static bool is_digit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+static void skip_ws(scanner_t *s)
+{
+    while (s->p < s->end && (*s->p == ' ' || *s->p == '\t' || *s->p == '\n' || *s->p == '\r')) {
+        s->p++;
+    }
+}
+
+static bool scan_literal(scanner_t *s, const char *literal)
+{
+    size_t len = strlen(literal);
+    if ((size_t)(s->end - s->p) < len || memcmp(s->p, literal, len) != 0) {
+        return false;
+    }
+    s->p += len;
+    return true;
+}
+
+/**
+ * @brief Пропустить строку; escape-последовательности не раскрываются
+ */
+static bool scan_string(scanner_t *s)
+{
+    if (s->p >= s->end || *s->p != '"') {
+        return false;
+    }
+    s->p++;
+    while (s->p < s->end) {
+        char c = *s->p++;
+        if (c == '"') {
+            return true;
+        }
+        if ((unsigned char)c < 0x20) {
+            return false;
+        }
+        if (c == '\\') {
+            if (s->p >= s->end) {
+                return false;
+            }
+            s->p++;
+        }
+    }
+    return false;
+}
+
+static bool scan_number(scanner_t *s)
+{
+    const char *start = s->p;
+    while (s->p < s->end && (is_digit(*s->p) || *s->p == '-' || *s->p == '+' || *s->p == '.' ||
+                             *s->p == 'e' || *s->p == 'E')) {
+        s->p++;
+    }
+    // Формат числа целиком проверяет parse_number при чтении поля
+    return s->p > start;
+}
+
+static bool scan_value(scanner_t *s, int depth);
+
+/**
+ * @brief Пройти объект; если fields не NULL, записать его поля
+ */
+static bool scan_object(scanner_t *s, int depth, ws_fields_t *fields)
+{
+    if (depth > WS_COMMAND_MAX_DEPTH || s->p >= s->end || *s->p != '{') {
+        return false;
+    }
+    s->p++;
+    skip_ws(s);
+    if (s->p < s->end && *s->p == '}') {
+        s->p++;
+        return true;
+    }
+
+    while (1) {
+        ws_field_t field;
+        skip_ws(s);
+        field.key.ptr = s->p + 1;
+        if (!scan_string(s)) {
+            return false;
+        }
+        field.key.len = (size_t)(s->p - field.key.ptr - 1);
+        skip_ws(s);
+        if (s->p >= s->end || *s->p != ':') {
+            return false;
+        }
+        s->p++;
+        skip_ws(s);
+        field.value.ptr = s->p;
+        if (!scan_value(s, depth + 1)) {
+            return false;
+        }
+        field.value.len = (size_t)(s->p - field.value.ptr);
+        if (fields && fields->count < WS_COMMAND_MAX_FIELDS) {
+            fields->items[fields->count++] = field;
+        }
+        skip_ws(s);
+        if (s->p >= s->end) {
+            return false;
+        }
+        if (*s->p == '}') {
+            s->p++;
+            return true;
+        }
+        if (*s->p != ',') {
+            return false;
+        }
+        s->p++;
+    }
+}
+
+static bool scan_array(scanner_t *s, int depth)
+{
+    if (depth > WS_COMMAND_MAX_DEPTH) {
+        return false;
+    }
+    s->p++;
+    skip_ws(s);
+    if (s->p < s->end && *s->p == ']') {
+        s->p++;
+        return true;
+    }
+
+    while (1) {
+        skip_ws(s);
+        if (!scan_value(s, depth + 1)) {
+            return false;
+        }
+        skip_ws(s);
+        if (s->p >= s->end) {
+            return false;
+        }
+        if (*s->p == ']') {
+            s->p++;
+            return true;
+        }
+        if (*s->p != ',') {
+            return false;
+        }
+        s->p++;
+    }
+}
+
+static bool scan_value(scanner_t *s, int depth)
+{
+    if (s->p >= s->end) {
+        return false;
+    }
+    switch (*s->p) {
+    case '"':
+        return scan_string(s);
+    case '{':
+        return scan_object(s, depth, NULL);
+    case '[':
+        return scan_array(s, depth);
+    case 't':
+        return scan_literal(s, "true");
+    case 'f':
+        return scan_literal(s, "false");
+    case 'n':
+        return scan_literal(s, "null");
+    default:
+        return (*s->p == '-' || is_digit(*s->p)) && scan_number(s);
+    }
+}
+
+bool ws_span_equals(ws_span_t span, const char *text)
+{
+    size_t len = strlen(text);
+    return span.len == len && memcmp(span.ptr, text, len) == 0;
+}
+
+static const ws_span_t *find_field(const ws_fields_t *fields, const char *key)
+{
+    for (int i = 0; i < fields->count; i++) {
+        if (ws_span_equals(fields->items[i].key, key)) {
+            return &fields->items[i].value;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Число JSON целиком в участке; без strtod, которому нужен '\0'
+ */
+static bool parse_number(const ws_span_t *span, double *out)
+{
+    static const double powers[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                     1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+    if (!span) {
+        return false;
+    }
+    const char *p = span->ptr;
+    const char *end = p + span->len;
+    bool negative = false;
+    uint64_t mantissa = 0;
+    int digits = 0;
+    int exponent = 0;
+
+    if (p < end && *p == '-') {
+        negative = true;
+        p++;
+    }
+    if (p >= end || !is_digit(*p)) {
+        return false;
+    }
+    for (; p < end && is_digit(*p); p++) {
+        if (digits < 19) {
+            mantissa = mantissa * 10 + (uint64_t)(*p - '0');
+            digits += mantissa > 0;
+        } else {
+            exponent++;
+        }
+    }
+    if (p < end && *p == '.') {
+        p++;
+        if (p >= end || !is_digit(*p)) {
+            return false;
+        }
+        for (; p < end && is_digit(*p); p++) {
+            if (digits < 19) {
+                mantissa = mantissa * 10 + (uint64_t)(*p - '0');
+                digits += mantissa > 0;
+                exponent--;
+            }
+        }
+    }
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        p++;
+        bool exp_negative = false;
+        if (p < end && (*p == '+' || *p == '-')) {
+            exp_negative = *p == '-';
+            p++;
+        }
+        if (p >= end || !is_digit(*p)) {
+            return false;
+        }
+        int value = 0;
+        for (; p < end && is_digit(*p); p++) {
+            if (value < 10000) {
+                value = value * 10 + (*p - '0');
+            }
+        }
+        exponent += exp_negative ? -value : value;
+    }
+    if (p != end) {
+        return false;
+    }
+
+    double value = (double)mantissa;
+    while (exponent > 22) {
+        value *= 1e22;
+        exponent -= 22;
+    }
+    while (exponent < -22) {
+        value /= 1e22;
+        exponent += 22;
+    }
+    value = exponent >= 0 ? value * powers[exponent] : value / powers[-exponent];
+    *out = negative ? -value : value;
+    return true;
+}
+
+/**
+ * @brief Целое в диапазоне; дробная часть отбрасывается, как valueint у cJSON
+ */
+static bool parse_int(const ws_span_t *span, int min, int max, int *out)
+{
+    double value;
+    if (!parse_number(span, &value) || value < min || value >= (double)max + 1) {
+        return false;
+    }
+    *out = (int)value;
+    return true;
+}
+
+/**
+ * @brief Необязательное неотрицательное число; fallback, если поля нет или оно не подходит
+ */
+static uint32_t get_uint_field(const ws_fields_t *fields, const char *key, uint32_t fallback)
+{
+    double value;
+    if (!parse_number(find_field(fields, key), &value) || value < 0) {
+        return fallback;
+    }
+    return value >= 4294967295.0 ? UINT32_MAX : (uint32_t)value;
+}
+
+/**
+ * @brief Необязательное целое в диапазоне: fallback, если поля нет; false, если оно вне диапазона
+ */
+static bool get_int_field(const ws_fields_t *fields, const char *key, int min, int max, int fallback, int *out)
+{
+    const ws_span_t *span = find_field(fields, key);
+    if (!span) {
+        *out = fallback;
+        return true;
+    }
+    return parse_int(span, min, max, out);
+}
+
+/**
+ * @brief Номер сообщения: целое 0..UINT32_MAX
+ */
+static bool parse_seq(const ws_span_t *span, uint32_t *out)
+{
+    double value;
+    if (!parse_number(span, &value) || value < 0 || value > UINT32_MAX || value != (double)(uint32_t)value) {
+        return false;
+    }
+    *out = (uint32_t)value;
+    return true;
+}
+
+static bool get_string(const ws_span_t *span, ws_span_t *out)
+{
+    if (!span || span->len < 2 || span->ptr[0] != '"') {
+        return false;
+    }
+    out->ptr = span->ptr + 1;
+    out->len = span->len - 2;
+    return true;
+}
+
+/**
+ * @brief Следующий элемент массива; it стоит внутри массива после '['
+ */
+static bool array_next(scanner_t *it, ws_span_t *item)
+{
+    skip_ws(it);
+    if (it->p < it->end && *it->p == ',') {
+        it->p++;
+        skip_ws(it);
+    }
+    if (it->p >= it->end || *it->p == ']') {
+        return false;
+    }
+    item->ptr = it->p;
+    scan_value(it, 0);
+    item->len = (size_t)(it->p - item->ptr);
+    return true;
+}
+
+static bool array_begin(const ws_span_t *span, scanner_t *it)
+{
+    if (!span || span->len < 2 || span->ptr[0] != '[') {
+        return false;
+    }
+    it->p = span->ptr + 1;
+    it->end = span->ptr + span->len;
+    return true;
+}
+
+/**
+ * @brief Цвет эффекта из массива [r, g, b]
+ */
+static bool parse_rgb_array(const ws_span_t *span, led_rgb_t *color)
+{
+    scanner_t it;
+    ws_span_t item;
+    int channels[3];
+    int count = 0;
+
+    if (!array_begin(span, &it)) {
+        return false;
+    }
+    while (array_next(&it, &item)) {
+        if (count == 3 || !parse_int(&item, 0, 255, &channels[count])) {
+            return false;
+        }
+        count++;
+    }
+    if (count != 3) {
+        return false;
+    }
+    color->r = (uint8_t)channels[0];
+    color->g = (uint8_t)channels[1];
+    color->b = (uint8_t)channels[2];
+    return true;
+}
+
+static uint32_t get_duration(const ws_fields_t *fields)
+{
+    int duration_ms;
+    return parse_int(find_field(fields, "durationMs"), 1, INT32_MAX, &duration_ms) ? (uint32_t)duration_ms : 0;
+}
+
+static bool parse_set_servo(const ws_fields_t *fields, ws_command_t *command)
+{
+    int id;
+    double angle;
+    if (!parse_int(find_field(fields, "id"), 1, 2, &id) ||
+        !parse_number(find_field(fields, "angle"), &angle)) {
+        return false;
+    }
+    // Диапазон проверяется до округления: lround от 1e300 * 100 не определён
+    if (angle < 0.0 || angle > 180.0) {
+        return false;
+    }
+    // Дробный угол поддерживается с точностью до сотой градуса
+    long angle_cdeg = lround(angle * 100.0);
+    command->servo.id = (uint8_t)id;
+    command->servo.angle_cdeg = (int32_t)angle_cdeg;
+    command->servo.duration_ms = get_duration(fields);
+    return true;
+}
+
+static bool parse_set_pose(const ws_fields_t *fields, ws_command_t *command)
+{
+    if (!parse_int(find_field(fields, "pan"), 0, 180, &command->pose.pan) ||
+        !parse_int(find_field(fields, "tilt"), 0, 180, &command->pose.tilt)) {
+        return false;
+    }
+    command->pose.duration_ms = get_duration(fields);
+    return true;
+}
+
+static bool parse_set_led_color(const ws_fields_t *fields, ws_command_t *command)
+{
+    int r, g, b;
+    if (!parse_int(find_field(fields, "r"), 0, 255, &r) || !parse_int(find_field(fields, "g"), 0, 255, &g) ||
+        !parse_int(find_field(fields, "b"), 0, 255, &b)) {
+        return false;
+    }
+    command->led_color.r = (uint8_t)r;
+    command->led_color.g = (uint8_t)g;
+    command->led_color.b = (uint8_t)b;
+    return true;
+}
+
+/**
+ * @brief Разбор команды set_led_effect
+ *
+ * {"type":"set_led_effect","effect":"fade","color":[r,g,b],"from":[r,g,b],
+ *  "durationMs":..,"periodMs":..,"minLevel":..,"width":..,
+ *  "kelvinFrom":..,"kelvinTo":..,"zones":[[first,last,[r,g,b],[r,g,b]],...]}
+ *
+ * minLevel 0..255, width 1..255, kelvin 1000..10000 и не больше
+ * LED_EFFECT_MAX_ZONES зон; значения вне диапазона отклоняются, а не
+ * заворачиваются при сужении типа.
+ */
+static bool parse_set_led_effect(const ws_fields_t *fields, ws_command_t *command)
+{
+    static const struct {
+        const char *name;
+        led_effect_type_t type;
+    } types[] = {
+        { "none", LED_EFFECT_NONE },
+        { "fade", LED_EFFECT_FADE },
+        { "breathe", LED_EFFECT_BREATHE },
+        { "chase", LED_EFFECT_CHASE },
+        { "color_temp", LED_EFFECT_COLOR_TEMP },
+        { "gradient", LED_EFFECT_GRADIENT },
+    };
+    led_effect_t *effect = &command->led_effect;
+    ws_span_t name;
+    int min_level, width, kelvin_from, kelvin_to;
+
+    if (!get_string(find_field(fields, "effect"), &name)) {
+        return false;
+    }
+    memset(effect, 0, sizeof(*effect));
+    size_t i = 0;
+    while (i < sizeof(types) / sizeof(types[0]) && !ws_span_equals(name, types[i].name)) {
+        i++;
+    }
+    if (i == sizeof(types) / sizeof(types[0])) {
+        return false;
+    }
+    effect->type = types[i].type;
+
+    // Без "color" — белый, без "from" переход начинается с текущего цвета
+    led_rgb_t white = { 255, 255, 255 };
+    if (!parse_rgb_array(find_field(fields, "color"), &effect->color)) {
+        effect->color = white;
+    }
+    effect->from_current = !parse_rgb_array(find_field(fields, "from"), &effect->from);
+    effect->duration_ms = get_uint_field(fields, "durationMs", 1000);
+    effect->period_ms = get_uint_field(fields, "periodMs", 2000);
+    if (!get_int_field(fields, "minLevel", 0, 255, 0, &min_level) ||
+        !get_int_field(fields, "width", 1, 255, 1, &width) ||
+        !get_int_field(fields, "kelvinFrom", 1000, 10000, 2700, &kelvin_from) ||
+        !get_int_field(fields, "kelvinTo", 1000, 10000, 6500, &kelvin_to)) {
+        return false;
+    }
+    effect->min_level = (uint8_t)min_level;
+    effect->width = (uint8_t)width;
+    effect->kelvin_from = (uint16_t)kelvin_from;
+    effect->kelvin_to = (uint16_t)kelvin_to;
+
+    scanner_t zones;
+    ws_span_t zone;
+    if (!array_begin(find_field(fields, "zones"), &zones)) {
+        return true;
+    }
+    while (array_next(&zones, &zone)) {
+        scanner_t it;
+        ws_span_t items[4];
+        int count = 0;
+        int first, last;
+
+        if (effect->zone_count == LED_EFFECT_MAX_ZONES || !array_begin(&zone, &it)) {
+            return false;
+        }
+        while (count < 4 && array_next(&it, &items[count])) {
+            count++;
+        }
+        led_effect_zone_t *out = &effect->zones[effect->zone_count];
+        if (count != 4 || !parse_int(&items[0], 0, UINT16_MAX, &first) ||
+            !parse_int(&items[1], first, UINT16_MAX, &last) ||
+            !parse_rgb_array(&items[2], &out->from) || !parse_rgb_array(&items[3], &out->to)) {
+            return false;
+        }
+        out->first = (uint16_t)first;
+        out->last = (uint16_t)last;
+        effect->zone_count++;
+    }
+    return true;
+}
+
+static bool parse_set_led_brightness(const ws_fields_t *fields, ws_command_t *command)
+{
+    int brightness;
+    if (!parse_int(find_field(fields, "brightness"), 0, 255, &brightness)) {
+        return false;
+    }
+    command->led_brightness = (uint8_t)brightness;
+    return true;
+}
+
+static bool parse_clear_leds(const ws_fields_t *fields, ws_command_t *command)
+{
+    (void)fields;
+    (void)command;
+    return true;
+}
+
+static bool parse_ack(const ws_fields_t *fields, ws_command_t *command)
+{
+    ws_cmd_ack_t *ack = &command->ack;
+
+    memset(ack, 0, sizeof(*ack));
+    get_string(find_field(fields, "action"), &ack->action);
+    get_string(find_field(fields, "heartbeatFormat"), &ack->heartbeat_format);
+    ack->has_seq = parse_seq(find_field(fields, "seq"), &ack->seq);
+    const ws_span_t *resync = find_field(fields, "resync");
+    ack->resync = resync && ws_span_equals(*resync, "true");
+    return true;
+}
+
+static bool parse_error(const ws_fields_t *fields, ws_command_t *command)
+{
+    command->error.ptr = "";
+    command->error.len = 0;
+    get_string(find_field(fields, "error"), &command->error);
+    return true;
+}
+
+/**
+ * @brief Разбор пакета: все операции проверяются до выполнения любой из них
+ */
+static bool parse_batch(const ws_fields_t *fields, ws_command_t *command)
+{
+    ws_cmd_batch_t *batch = &command->batch;
+    scanner_t it;
+    ws_span_t op;
+
+    batch->count = 0;
+    if (!array_begin(find_field(fields, "ops"), &it)) {
+        return false;
+    }
+    while (array_next(&it, &op)) {
+        ws_command_t parsed;
+        if (batch->count == WS_COMMAND_BATCH_MAX_OPS || ws_command_parse_op(&op, &parsed) != WS_COMMAND_OK) {
+            return false;
+        }
+        batch->ops[batch->count++] = op;
+    }
+    return batch->count > 0;
+}
+
+static const ws_command_spec_t s_commands[WS_COMMAND_COUNT] = {
+    [WS_COMMAND_SET_SERVO] = { "set_servo", parse_set_servo },
+    [WS_COMMAND_SET_POSE] = { "set_pose", parse_set_pose },
+    [WS_COMMAND_SET_LED_COLOR] = { "set_led_color", parse_set_led_color },
+    [WS_COMMAND_SET_LED_EFFECT] = { "set_led_effect", parse_set_led_effect },
+    [WS_COMMAND_SET_LED_BRIGHTNESS] = { "set_led_brightness", parse_set_led_brightness },
+    [WS_COMMAND_CLEAR_LEDS] = { "clear_leds", parse_clear_leds },
+    [WS_COMMAND_ACK] = { "ack", parse_ack },
+    [WS_COMMAND_ERROR] = { "error", parse_error },
+    [WS_COMMAND_BATCH] = { "batch", parse_batch },
+};
+
+/**
+ * @brief Найти команду по имени
+ *
+ * Имена команд различаются длиной: длина выбирает единственного
+ * кандидата, memcmp его подтверждает. Команде с уже занятой длиной
+ * нужна вторая проверка в своём case.
+ */
+static int lookup_command(ws_span_t name)
+{
+    int candidate;
+    switch (name.len) {
+    case 3: candidate = WS_COMMAND_ACK; break;
+    case 5: candidate = name.ptr[0] == 'b' ? WS_COMMAND_BATCH : WS_COMMAND_ERROR; break;
+    case 8: candidate = WS_COMMAND_SET_POSE; break;
+    case 9: candidate = WS_COMMAND_SET_SERVO; break;
+    case 10: candidate = WS_COMMAND_CLEAR_LEDS; break;
+    case 13: candidate = WS_COMMAND_SET_LED_COLOR; break;
+    case 14: candidate = WS_COMMAND_SET_LED_EFFECT; break;
+    case 18: candidate = WS_COMMAND_SET_LED_BRIGHTNESS; break;
+    default: return -1;
+    }
+    return memcmp(s_commands[candidate].name, name.ptr, name.len) == 0 ? candidate : -1;
+}
+
+/**
+ * @brief Разобрать сообщение; операция пакета может быть только командой управления
+ */
+static ws_command_status_t parse_message(const char *data, size_t len, ws_command_t *command, bool batch_op)
+{
+    scanner_t s = { data, data + len };
+    ws_fields_t fields;
+    ws_span_t type;
+
+    fields.count = 0;
+    skip_ws(&s);
+    if (!scan_object(&s, 0, &fields)) {
+        return WS_COMMAND_MALFORMED;
+    }
+    skip_ws(&s);
+    if (s.p != s.end) {
+        return WS_COMMAND_MALFORMED;
+    }
+
+    // Номер нужен и отклонённой команде: бэкенд получит отказ, а не таймаут
+    command->has_seq = parse_seq(find_field(&fields, "seq"), &command->seq);
+    if (!get_string(find_field(&fields, "type"), &type)) {
+        return WS_COMMAND_NO_TYPE;
+    }
+    int index = lookup_command(type);
+    if (index < 0) {
+        return WS_COMMAND_UNKNOWN_TYPE;
+    }
+    // Вложенный пакет отклоняется до разбора его операций
+    if (batch_op && (index == WS_COMMAND_ACK || index == WS_COMMAND_ERROR || index == WS_COMMAND_BATCH)) {
+        return WS_COMMAND_INVALID;
+    }
+    command->type = (ws_command_type_t)index;
+    return s_commands[index].parse(&fields, command) ? WS_COMMAND_OK : WS_COMMAND_INVALID;
+}
+
+ws_command_status_t ws_command_parse(const char *data, size_t len, ws_command_t *command)
+{
+    return parse_message(data, len, command, false);
+}
+
+ws_command_status_t ws_command_parse_op(const ws_span_t *op, ws_command_t *command)
+{
+    return parse_message(op->ptr, op->len, command, true);
+}
+
+const char *ws_command_name(ws_command_type_t type)
+{
+    return type < WS_COMMAND_COUNT ? s_commands[type].name : "unknown";
+}
+
+const char *ws_command_status_name(ws_command_status_t status)
+{
+    switch (status) {
+    case WS_COMMAND_OK: return "ok";
+    case WS_COMMAND_MALFORMED: return "malformed JSON";
+    case WS_COMMAND_NO_TYPE: return "no type";
+    case WS_COMMAND_UNKNOWN_TYPE: return "unknown type";
+    case WS_COMMAND_INVALID: return "invalid fields";
+    case WS_COMMAND_FAILED: return "execution failed";
+    }
+    return "unknown";
+}
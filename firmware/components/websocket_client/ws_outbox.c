@@ -0,0 +1,157 @@
+#include "ws_outbox.h"
+
+#include <string.h>
+
+void ws_outbox_init(ws_outbox_t *outbox)
+{
+    memset(outbox, 0, sizeof(*outbox));
+}
+
+/**
+ * @brief Удалить сообщение и сдвинуть следующие за ним данные
+ */
+static void remove_message(ws_outbox_t *outbox, int index)
+{
+    ws_outbox_message_t *message = &outbox->messages[index];
+    uint16_t end = message->offset + message->len;
+    uint16_t len = message->len;
+
+    memmove(outbox->data + message->offset, outbox->data + end, outbox->used - end);
+    outbox->used -= len;
+    for (int i = index + 1; i < outbox->count; i++) {
+        outbox->messages[i].offset -= len;
+        outbox->messages[i - 1] = outbox->messages[i];
+    }
+    outbox->count--;
+    outbox->stats.depth = outbox->count;
+    outbox->stats.bytes = outbox->used;
+}
+
+static void drop_message(ws_outbox_t *outbox, int index)
+{
+    outbox->stats.classes[outbox->messages[index].cls].dropped++;
+    remove_message(outbox, index);
+}
+
+/**
+ * @brief Самое старое сообщение самого младшего класса не старше cls
+ * @return Индекс или -1, если вытеснять нечего
+ */
+static int find_victim(const ws_outbox_t *outbox, ws_outbox_class_t cls)
+{
+    int victim = -1;
+    for (int i = 0; i < outbox->count; i++) {
+        uint8_t candidate = outbox->messages[i].cls;
+        if (candidate == WS_OUTBOX_CONTROL || candidate < cls) {
+            continue;
+        }
+        if (victim < 0 || candidate > outbox->messages[victim].cls) {
+            victim = i;
+        }
+    }
+    return victim;
+}
+
+bool ws_outbox_push(ws_outbox_t *outbox, ws_outbox_class_t cls, uint8_t kind, bool binary,
+                    const void *data, size_t len, int64_t now_us)
+{
+    ws_outbox_class_stats_t *stats = &outbox->stats.classes[cls];
+    if (len == 0 || len > WS_OUTBOX_SIZE) {
+        stats->rejected++;
+        return false;
+    }
+
+    if (kind != 0) {
+        for (int i = outbox->count - 1; i >= 0; i--) {
+            if (outbox->messages[i].cls == cls && outbox->messages[i].kind == kind) {
+                drop_message(outbox, i);
+            }
+        }
+    }
+
+    // Сначала проверяем, что вытеснение вообще освободит место: иначе
+    // сообщения выброшены зря
+    size_t free_bytes = WS_OUTBOX_SIZE - outbox->used;
+    int free_slots = WS_OUTBOX_MAX_MESSAGES - outbox->count;
+    for (int i = 0; i < outbox->count; i++) {
+        if (outbox->messages[i].cls != WS_OUTBOX_CONTROL && outbox->messages[i].cls >= cls) {
+            free_bytes += outbox->messages[i].len;
+            free_slots++;
+        }
+    }
+    if (free_bytes < len || free_slots == 0) {
+        stats->rejected++;
+        return false;
+    }
+
+    while (outbox->count == WS_OUTBOX_MAX_MESSAGES || (size_t)(WS_OUTBOX_SIZE - outbox->used) < len) {
+        drop_message(outbox, find_victim(outbox, cls));
+    }
+
+    ws_outbox_message_t *message = &outbox->messages[outbox->count++];
+    message->cls = (uint8_t)cls;
+    message->kind = kind;
+    message->binary = binary;
+    message->offset = outbox->used;
+    message->len = (uint16_t)len;
+    message->enqueued_us = now_us;
+    memcpy(outbox->data + outbox->used, data, len);
+    outbox->used += (uint16_t)len;
+
+    stats->enqueued++;
+    outbox->stats.depth = outbox->count;
+    outbox->stats.bytes = outbox->used;
+    if (outbox->count > outbox->stats.max_depth) {
+        outbox->stats.max_depth = outbox->count;
+    }
+    if (outbox->used > outbox->stats.max_bytes) {
+        outbox->stats.max_bytes = outbox->used;
+    }
+    return true;
+}
+
+size_t ws_outbox_pop(ws_outbox_t *outbox, void *buffer, size_t buffer_size, ws_outbox_message_t *message)
+{
+    int best = -1;
+    for (int i = 0; i < outbox->count; i++) {
+        if (best < 0 || outbox->messages[i].cls < outbox->messages[best].cls) {
+            best = i;
+        }
+    }
+    if (best < 0 || outbox->messages[best].len > buffer_size) {
+        return 0;
+    }
+
+    *message = outbox->messages[best];
+    memcpy(buffer, outbox->data + message->offset, message->len);
+    remove_message(outbox, best);
+    return message->len;
+}
+
+void ws_outbox_complete(ws_outbox_t *outbox, const ws_outbox_message_t *message, bool sent, int64_t now_us)
+{
+    ws_outbox_class_stats_t *stats = &outbox->stats.classes[message->cls];
+    if (!sent) {
+        stats->failed++;
+        return;
+    }
+
+    uint32_t latency_us = (uint32_t)(now_us - message->enqueued_us);
+    stats->sent++;
+    stats->last_latency_us = latency_us;
+    stats->total_latency_us += latency_us;
+    if (latency_us > stats->max_latency_us) {
+        stats->max_latency_us = latency_us;
+    }
+}
+
+void ws_outbox_clear(ws_outbox_t *outbox)
+{
+    for (int i = 0; i < outbox->count; i++) {
+        outbox->stats.classes[outbox->messages[i].cls].dropped++;
+    }
+    outbox->count = 0;
+    outbox->used = 0;
+    outbox->stats.depth = 0;
+    outbox->stats.bytes = 0;
+}
@@ -0,0 +1,105 @@
+#include "ws_reassembly.h"
+
+#include <string.h>
+
+void ws_reassembly_init(ws_reassembly_t *reassembly)
+{
+    memset(reassembly, 0, sizeof(*reassembly));
+}
+
+void ws_reassembly_reset(ws_reassembly_t *reassembly)
+{
+    reassembly->active = false;
+    reassembly->overflow = false;
+    reassembly->len = 0;
+    reassembly->frame_base = 0;
+}
+
+static ws_reassembly_status_t complete(ws_reassembly_t *reassembly, const char *data, size_t len,
+                                       ws_reassembly_message_t *message)
+{
+    ws_reassembly_stats_t *stats = &reassembly->stats;
+    stats->messages++;
+    if (reassembly->opcode == WS_OPCODE_BINARY) {
+        stats->binary++;
+    }
+    if (len > stats->max_len) {
+        stats->max_len = (uint32_t)len;
+    }
+
+    message->data = data;
+    message->len = len;
+    message->binary = reassembly->opcode == WS_OPCODE_BINARY;
+    reassembly->active = false;
+    return WS_REASSEMBLY_COMPLETE;
+}
+
+static ws_reassembly_status_t protocol_error(ws_reassembly_t *reassembly)
+{
+    reassembly->stats.protocol_errors++;
+    ws_reassembly_reset(reassembly);
+    return WS_REASSEMBLY_DROPPED;
+}
+
+ws_reassembly_status_t ws_reassembly_feed(ws_reassembly_t *reassembly, uint8_t opcode, bool fin,
+                                          const char *data, size_t len, size_t payload_len,
+                                          size_t payload_offset, ws_reassembly_message_t *message)
+{
+    if (opcode >= WS_OPCODE_CLOSE) {
+        // Управляющие кадры могут приходить между кадрами сообщения
+        return WS_REASSEMBLY_IGNORED;
+    }
+    if (opcode != WS_OPCODE_CONTINUATION && opcode != WS_OPCODE_TEXT && opcode != WS_OPCODE_BINARY) {
+        return protocol_error(reassembly);
+    }
+    if (payload_offset > payload_len || len > payload_len - payload_offset) {
+        return protocol_error(reassembly);
+    }
+
+    bool frame_start = payload_offset == 0;
+    bool frame_end = payload_offset + len == payload_len;
+
+    if (frame_start && opcode != WS_OPCODE_CONTINUATION) {
+        if (reassembly->active) {
+            // Новое сообщение до конца предыдущего
+            reassembly->stats.protocol_errors++;
+        }
+        ws_reassembly_reset(reassembly);
+        reassembly->opcode = opcode;
+        reassembly->active = true;
+
+        if (frame_end && fin) {
+            // Сообщение целиком в одном куске: отдаём без копии
+            return complete(reassembly, data, len, message);
+        }
+    } else if (!reassembly->active) {
+        // Продолжение без начала: начало уже отброшено или потеряно
+        return protocol_error(reassembly);
+    } else if (frame_start) {
+        reassembly->frame_base = reassembly->len;
+    }
+
+    if (!reassembly->overflow) {
+        if (reassembly->frame_base + payload_offset != reassembly->len) {
+            return protocol_error(reassembly);
+        }
+        // payload_len известен с первого куска: большой кадр отбрасывается сразу
+        if (payload_len > WS_REASSEMBLY_SIZE - reassembly->frame_base) {
+            reassembly->overflow = true;
+            reassembly->stats.oversized++;
+        } else {
+            memcpy(reassembly->data + reassembly->len, data, len);
+            reassembly->len += len;
+        }
+    }
+
+    if (!frame_end || !fin) {
+        return WS_REASSEMBLY_PENDING;
+    }
+    if (reassembly->overflow) {
+        ws_reassembly_reset(reassembly);
+        return WS_REASSEMBLY_DROPPED;
+    }
+    reassembly->stats.reassembled++;
+    return complete(reassembly, reassembly->data, reassembly->len, message);
+}
@@ -0,0 +1,253 @@
+/*
+ * Стоимость одного heartbeat: потоковый json_writer в статический буфер
+ * (heartbeat_json_encode, опорный и разностный) и бинарный bin1 против
+ * прежнего пути cJSON DOM + cJSON_Print.
+ *
+ * Сравнение с cJSON собирается, только если CMake нашёл исходники cJSON
+ * (ESP-IDF components/json/cJSON или -DCJSON_DIR=...).
+ *
+ * Перед замером json_writer_float проверяется на границах фиксированной
+ * точки: большие значения с многими знаками не должны переполнять uint64.
+ *
+ * Использование: bench_heartbeat_json [iterations] [ranges]
+ */
+
+#include "bench_common.h"
+#include "heartbeat_bin.h"
+#include "heartbeat_json.h"
+#include "json_writer.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef BENCH_HAVE_CJSON
+#include "cJSON.h"
+#endif
+
+#define BENCH_DEFAULT_ITERATIONS 100000
+#define BENCH_DEFAULT_RANGES 3
+#define BENCH_DEVICE_ID "smartlight_a1b2c3"
+
+static servo_status_t s_servo = {.angle1 = 92, .angle2 = 37};
+static uwb_positioning_stats_t s_stats;
+static heartbeat_state_t s_state;
+static heartbeat_state_t s_base;
+static uwb_range_t s_ranges[UWB_MAX_RANGES];
+static size_t s_range_count;
+
+static char s_json[HEARTBEAT_JSON_MAX_SIZE];
+static uint8_t s_bin[HEARTBEAT_BIN_MAX_SIZE];
+
+static void fill_sample(size_t range_count)
+{
+    memset(&s_stats, 0, sizeof(s_stats));
+    s_stats.total_bytes = 1843920;
+    s_stats.discarded_bytes = 312;
+    s_stats.parsed_frames = 229541;
+    s_stats.invalid_frames = 17;
+    s_stats.last_byte_at_ms = 86399123;
+    strcpy(s_stats.last_rx_hex, "F0 05 01 00 7B 00 C4 AA F0 05 02 00 A1 01 B9 AA");
+    s_stats.auto_config_enabled = true;
+    s_stats.role = 1;
+    s_stats.pid = 255;
+    s_stats.period = 5;
+    s_stats.local_address = 0x0000;
+    s_stats.peer0_address = 0x0001;
+
+    s_range_count = range_count < UWB_MAX_RANGES ? range_count : UWB_MAX_RANGES;
+    for (size_t i = 0; i < s_range_count; i++) {
+        memset(&s_ranges[i], 0, sizeof(s_ranges[i]));
+        s_ranges[i].peer_addr = (uint16_t)(i + 1);
+        s_ranges[i].distance_m = 1.234f + (float)i * 0.517f;
+        s_ranges[i].filtered_distance_m = 1.2f + (float)i * 0.5f;
+        s_ranges[i].rssi_dbm = -60 - (int)i;
+        s_ranges[i].updated_at_ms = 86399000 + (int64_t)i;
+        s_ranges[i].valid = true;
+    }
+
+    s_state.servo = s_servo;
+    s_state.uwb_ready = true;
+    s_state.stats = s_stats;
+    s_state.range_count = s_range_count;
+
+    // Типичная разность за секунду: растут только счётчики UART и кадров
+    s_base = s_state;
+    s_base.stats.total_bytes -= 80 * 8;
+    s_base.stats.parsed_frames -= 80;
+    s_base.stats.last_byte_at_ms -= 1000;
+}
+
+#ifdef BENCH_HAVE_CJSON
+static size_t s_allocations;
+
+static void *counting_malloc(size_t size)
+{
+    s_allocations++;
+    return malloc(size);
+}
+
+/* Прежняя реализация из websocket_client.c, оставлена только для сравнения */
+static size_t legacy_heartbeat(void)
+{
+    cJSON *heartbeat_json = cJSON_CreateObject();
+    cJSON_AddStringToObject(heartbeat_json, "type", "heartbeat");
+    cJSON_AddStringToObject(heartbeat_json, "deviceId", BENCH_DEVICE_ID);
+
+    cJSON *servo1 = cJSON_CreateObject();
+    cJSON_AddNumberToObject(servo1, "angle", s_servo.angle1);
+    cJSON_AddItemToObject(heartbeat_json, "servo1", servo1);
+    cJSON *servo2 = cJSON_CreateObject();
+    cJSON_AddNumberToObject(servo2, "angle", s_servo.angle2);
+    cJSON_AddItemToObject(heartbeat_json, "servo2", servo2);
+
+    cJSON *uwb = cJSON_CreateObject();
+    cJSON *ranges = cJSON_CreateArray();
+    for (size_t i = 0; i < s_range_count; i++) {
+        char peer_id[UWB_PEER_ID_LEN];
+        uwb_range_format_peer_id(&s_ranges[i], peer_id, sizeof(peer_id));
+        cJSON *range = cJSON_CreateObject();
+        cJSON_AddStringToObject(range, "peerId", peer_id);
+        cJSON_AddNumberToObject(range, "distanceM", s_ranges[i].distance_m);
+        cJSON_AddNumberToObject(range, "filteredDistanceM", s_ranges[i].filtered_distance_m);
+        cJSON_AddNumberToObject(range, "updatedAtMs", (double)s_ranges[i].updated_at_ms);
+        cJSON_AddNumberToObject(range, "rssiDbm", s_ranges[i].rssi_dbm);
+        cJSON_AddItemToArray(ranges, range);
+    }
+    cJSON_AddItemToObject(uwb, "ranges", ranges);
+    cJSON_AddBoolToObject(uwb, "ready", true);
+    cJSON_AddNumberToObject(uwb, "rangeCount", (double)s_range_count);
+    cJSON_AddNumberToObject(uwb, "uartBytes", s_stats.total_bytes);
+    cJSON_AddNumberToObject(uwb, "discardedBytes", s_stats.discarded_bytes);
+    cJSON_AddNumberToObject(uwb, "parsedFrames", s_stats.parsed_frames);
+    cJSON_AddNumberToObject(uwb, "invalidFrames", s_stats.invalid_frames);
+    cJSON_AddNumberToObject(uwb, "parsedLines", s_stats.parsed_lines);
+    cJSON_AddNumberToObject(uwb, "invalidLines", s_stats.invalid_lines);
+    cJSON_AddNumberToObject(uwb, "lastByteAtMs", (double)s_stats.last_byte_at_ms);
+    cJSON_AddStringToObject(uwb, "lastRxHex", s_stats.last_rx_hex);
+    cJSON_AddBoolToObject(uwb, "autoConfig", s_stats.auto_config_enabled);
+    cJSON_AddNumberToObject(uwb, "role", s_stats.role);
+    cJSON_AddNumberToObject(uwb, "pid", s_stats.pid);
+    cJSON_AddNumberToObject(uwb, "period", s_stats.period);
+    cJSON_AddNumberToObject(uwb, "localAddress", s_stats.local_address);
+    cJSON_AddNumberToObject(uwb, "peer0Address", s_stats.peer0_address);
+    cJSON_AddItemToObject(heartbeat_json, "uwb", uwb);
+
+    char *json_string = cJSON_Print(heartbeat_json);
+    size_t len = strlen(json_string);
+    bench_consume(json_string);
+    free(json_string);
+    cJSON_Delete(heartbeat_json);
+    return len;
+}
+#endif
+
+static size_t writer_heartbeat(void)
+{
+    size_t len = heartbeat_json_encode(s_json, sizeof(s_json), BENCH_DEVICE_ID, 1, &s_state, NULL, s_ranges);
+    bench_consume(s_json);
+    return len;
+}
+
+static size_t delta_heartbeat(void)
+{
+    size_t len = heartbeat_json_encode(s_json, sizeof(s_json), BENCH_DEVICE_ID, 2, &s_state, &s_base, s_ranges);
+    bench_consume(s_json);
+    return len;
+}
+
+static size_t binary_heartbeat(void)
+{
+    size_t len = heartbeat_bin_encode(s_bin, sizeof(s_bin), &s_servo, true, &s_stats, s_ranges, s_range_count);
+    bench_consume(s_bin);
+    return len;
+}
+
+static int check_float(double value, unsigned decimals, const char *expected)
+{
+    char buffer[48];
+    json_writer_t writer;
+    json_writer_init(&writer, buffer, sizeof(buffer));
+    json_writer_float(&writer, value, decimals);
+    if (json_writer_finish(&writer) == 0 || strcmp(buffer, expected) != 0) {
+        printf("json_writer_float(%g, %u): got %s, expected %s\n", value, decimals, buffer, expected);
+        return 1;
+    }
+    return 0;
+}
+
+static int check_floats(void)
+{
+    int failures = 0;
+    failures += check_float(-2.25, 2, "-2.25");
+    failures += check_float(0.0004, 3, "0");
+    failures += check_float(123456789012.5, 9, "123456789012.5");
+    failures += check_float(1.0e12, 6, "1000000000000");
+    failures += check_float(8.9e15, 9, "8900000000000000");
+    failures += check_float(1.0e16, 2, "null");
+    failures += check_float(NAN, 2, "null");
+    return failures;
+}
+
+static void report(const char *name, size_t (*encode)(void), int iterations)
+{
+    size_t bytes = encode();
+    uint64_t start_cycles = bench_cycles();
+    uint64_t start_ns = bench_now_ns();
+    for (int i = 0; i < iterations; i++) {
+        encode();
+    }
+    uint64_t cycles = bench_cycles() - start_cycles;
+    double ns = (double)(bench_now_ns() - start_ns);
+
+    printf("%-16s %6zu bytes %9.3f us/heartbeat", name, bytes, ns / iterations / 1000.0);
+    if (BENCH_HAVE_CYCLES) {
+        printf(" %8.0f cycles", (double)cycles / iterations);
+    }
+    printf("\n");
+}
+
+int main(int argc, char **argv)
+{
+    int iterations = argc > 1 ? atoi(argv[1]) : BENCH_DEFAULT_ITERATIONS;
+    if (iterations <= 0) {
+        iterations = BENCH_DEFAULT_ITERATIONS;
+    }
+    int range_count = argc > 2 ? atoi(argv[2]) : BENCH_DEFAULT_RANGES;
+    if (range_count < 0) {
+        range_count = BENCH_DEFAULT_RANGES;
+    }
+
+    if (check_floats() != 0) {
+        return 1;
+    }
+
+    fill_sample((size_t)range_count);
+    printf("heartbeat with %zu ranges\n", s_range_count);
+
+    if (writer_heartbeat() == 0) {
+        printf("json_writer: buffer of %d bytes is too small\n", HEARTBEAT_JSON_MAX_SIZE);
+        return 1;
+    }
+    printf("json_writer output: %s\n", s_json);
+    delta_heartbeat();
+    printf("delta output: %s\n", s_json);
+
+    report("json_writer", writer_heartbeat, iterations);
+    report("json delta", delta_heartbeat, iterations);
+    report("binary bin1", binary_heartbeat, iterations);
+
+#ifdef BENCH_HAVE_CJSON
+    cJSON_Hooks hooks = {.malloc_fn = counting_malloc, .free_fn = free};
+    cJSON_InitHooks(&hooks);
+    s_allocations = 0;
+    legacy_heartbeat();
+    printf("cJSON allocations per heartbeat: %zu\n", s_allocations);
+    report("cJSON_Print", legacy_heartbeat, iterations);
+#else
+    printf("cJSON sources not found, legacy path skipped (configure with -DCJSON_DIR=...)\n");
+#endif
+
+    return 0;
+}
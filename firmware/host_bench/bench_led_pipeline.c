@@ -0,0 +1,202 @@
+/*
+ * Стоимость перевода кадра в байты ленты от 64 светодиодов до длин больше
+ * LED_CONTROLLER_MAX_LEDS: прежний путь (деление (c * brightness) / 255 на каждый
+ * канал, без гаммы) против led_pipeline (16-битный линейный кадр,
+ * множитель яркости из таблицы, с дизерингом и без). Отдельно — полный путь
+ * кадра эффекта: 8-битный цвет -> гамма-таблица -> led_pipeline.
+ *
+ * Перед замером проверяет, что дизеринг в среднем за 256 кадров даёт
+ * заданный дробный уровень, а полная яркость сохраняет 255. Для
+ * статического цвета без эффекта проверяет путь повтора кадров: первый
+ * дробный кадр требует разбудить задачу эффектов, повторы её больше не
+ * будят, а целый уровень повтор снимает.
+ *
+ * Использование: bench_led_pipeline [frames]
+ */
+
+#include "bench_common.h"
+#include "led_controller.h"
+#include "led_pipeline.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_DEFAULT_FRAMES 20000
+#define BENCH_MIN_LEDS 64
+#define BENCH_MAX_LEDS 4096
+
+static led_rgb_t s_frame[BENCH_MAX_LEDS];
+static uint16_t s_linear[BENCH_MAX_LEDS * 3];
+static uint8_t s_error[BENCH_MAX_LEDS * 3];
+static uint8_t s_out[BENCH_MAX_LEDS * 3];
+
+/* Прежний путь led_controller_set_all_color / set_color */
+static void legacy_render(int leds, uint8_t brightness)
+{
+    for (int i = 0; i < leds; i++) {
+        s_out[i * 3 + 0] = (s_frame[i].g * brightness) / 255;
+        s_out[i * 3 + 1] = (s_frame[i].r * brightness) / 255;
+        s_out[i * 3 + 2] = (s_frame[i].b * brightness) / 255;
+    }
+}
+
+static void effect_render(int leds, uint8_t brightness)
+{
+    for (int i = 0; i < leds; i++) {
+        s_linear[i * 3 + 0] = led_gamma_lut[s_frame[i].g];
+        s_linear[i * 3 + 1] = led_gamma_lut[s_frame[i].r];
+        s_linear[i * 3 + 2] = led_gamma_lut[s_frame[i].b];
+    }
+    led_pipeline_render(s_linear, s_out, s_error, (size_t)leds * 3, led_brightness_lut[brightness], true);
+}
+
+static int check_pipeline(void)
+{
+    int errors = 0;
+
+    // Полная яркость и полный цвет — 255 без дизеринга
+    uint16_t full = led_gamma_lut[255];
+    memset(s_error, 0, sizeof(s_error));
+    led_pipeline_render(&full, s_out, s_error, 1, led_brightness_lut[255], true);
+    if (s_out[0] != 255) {
+        printf("check: full white gives %d\n", s_out[0]);
+        errors++;
+    }
+
+    // Уровень 10.25 шага ленты: в среднем за 256 кадров ровно 10.25
+    uint16_t level = 10 * 256 + 64;
+    uint32_t sum = 0;
+    memset(s_error, 0, sizeof(s_error));
+    for (int f = 0; f < 256; f++) {
+        bool fractional = led_pipeline_render(&level, s_out, s_error, 1, 0xFFFF, true);
+        sum += s_out[0];
+        if (!fractional) {
+            printf("check: fractional level not reported\n");
+            errors++;
+            break;
+        }
+    }
+    // 0xFFFF вместо 1.0 теряет до одной единицы 16-битного уровня
+    if (sum < 10 * 256 + 63 || sum > 10 * 256 + 64) {
+        printf("check: dithered average %u/256, expected %u/256\n", sum, 10u * 256 + 64);
+        errors++;
+    }
+
+    for (unsigned v = 0; v < LED_GAMMA_LUT_SIZE; v++) {
+        if (led_gamma_lut[v] != led_gamma_lut[led_gamma_inverse(led_gamma_lut[v])]) {
+            printf("check: inverse gamma of %u\n", v);
+            errors++;
+            break;
+        }
+    }
+
+    return errors;
+}
+
+/* Статический цвет: led_controller_update рисует кадр один раз, дальше его
+ * повторяет задача эффектов — только если её разбудили */
+static int check_static_refresh(void)
+{
+    int errors = 0;
+    bool refresh = false;
+    led_rgb_t color = {.r = 200, .g = 90, .b = 17};
+    uint8_t brightness = 77;
+    uint16_t linear[3] = {led_gamma_lut[color.g], led_gamma_lut[color.r], led_gamma_lut[color.b]};
+    uint16_t scale = led_brightness_lut[brightness];
+    uint32_t sum[3] = {0};
+
+    memset(s_error, 0, sizeof(s_error));
+    bool fractional = led_pipeline_render(linear, s_out, s_error, 3, scale, true);
+    if (!led_pipeline_update_refresh(&refresh, fractional, true)) {
+        printf("check: static fractional colour does not wake the refresh task\n");
+        errors++;
+    }
+
+    // Повторы с частотой эффектов: средний уровень совпадает с заданным
+    for (int f = 0; f < 256; f++) {
+        if (f > 0) {
+            fractional = led_pipeline_render(linear, s_out, s_error, 3, scale, true);
+            if (led_pipeline_update_refresh(&refresh, fractional, true)) {
+                printf("check: refresh frame %d wakes the task again\n", f);
+                errors++;
+                break;
+            }
+        }
+        for (int c = 0; c < 3; c++) {
+            sum[c] += s_out[c];
+        }
+    }
+    for (int c = 0; c < 3; c++) {
+        uint32_t expected = ((uint32_t)linear[c] * scale) >> 16;
+        if (sum[c] + 1 < expected || sum[c] > expected) {
+            printf("check: static subpixel %d averages %u/256, expected %u/256\n", c, sum[c], expected);
+            errors++;
+        }
+    }
+
+    // Без дизеринга и на целом уровне повторять нечего
+    if (led_pipeline_update_refresh(&refresh, true, false) || refresh) {
+        printf("check: refresh requested with dithering off\n");
+        errors++;
+    }
+    uint16_t black[3] = {0};
+    fractional = led_pipeline_render(black, s_out, s_error, 3, scale, true);
+    if (led_pipeline_update_refresh(&refresh, fractional, true) || refresh) {
+        printf("check: black keeps the refresh task running\n");
+        errors++;
+    }
+
+    return errors;
+}
+
+int main(int argc, char **argv)
+{
+    int frames = argc > 1 ? atoi(argv[1]) : BENCH_DEFAULT_FRAMES;
+    if (frames <= 0) {
+        frames = BENCH_DEFAULT_FRAMES;
+    }
+
+    int errors = check_pipeline() + check_static_refresh();
+    printf("checks: %d errors\n", errors);
+
+    for (int i = 0; i < BENCH_MAX_LEDS; i++) {
+        s_frame[i].r = (uint8_t)(i * 7);
+        s_frame[i].g = (uint8_t)(i * 13);
+        s_frame[i].b = (uint8_t)(i * 29);
+        s_linear[i * 3 + 0] = led_gamma_lut[s_frame[i].g];
+        s_linear[i * 3 + 1] = led_gamma_lut[s_frame[i].r];
+        s_linear[i * 3 + 2] = led_gamma_lut[s_frame[i].b];
+    }
+
+    printf("%6s %14s %14s %14s %14s\n", "leds", "legacy us/fr", "lut us/fr", "dither us/fr", "effect us/fr");
+    for (int leds = BENCH_MIN_LEDS; leds <= BENCH_MAX_LEDS; leds *= 4) {
+        size_t subpixels = (size_t)leds * 3;
+        double ns[4];
+        for (int variant = 0; variant < 4; variant++) {
+            uint64_t start = bench_now_ns();
+            for (int f = 0; f < frames; f++) {
+                uint8_t brightness = (uint8_t)(128 + (f & 63));
+                switch (variant) {
+                case 0:
+                    legacy_render(leds, brightness);
+                    break;
+                case 1:
+                    led_pipeline_render(s_linear, s_out, s_error, subpixels, led_brightness_lut[brightness], false);
+                    break;
+                case 2:
+                    led_pipeline_render(s_linear, s_out, s_error, subpixels, led_brightness_lut[brightness], true);
+                    break;
+                default:
+                    effect_render(leds, brightness);
+                    break;
+                }
+                bench_consume(s_out);
+            }
+            ns[variant] = (double)(bench_now_ns() - start) / frames;
+        }
+        printf("%6d %14.2f %14.2f %14.2f %14.2f\n", leds, ns[0] / 1000.0, ns[1] / 1000.0, ns[2] / 1000.0, ns[3] / 1000.0);
+    }
+
+    return errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,258 @@
+/*
+ * Планировщик заданий (scheduler) на поддельных часах: esp_timer_get_time
+ * возвращает модельное время, задания сдвигают его на своё время работы,
+ * vTaskDelay — на время сна. Сначала проверяет, что без перегрузки нет
+ * промахов и пропусков, затем — что затянувшееся задание низкого приоритета
+ * видно как промахи срока и пропущенные выпуски у обоих заданий, а счётчики
+ * согласованы между собой. Статистика обновляется и копируется под
+ * блокировкой планировщика, задания выполняются вне её.
+ *
+ * В конце печатает стоимость выбора и учёта одного выполнения задания.
+ *
+ * Использование: bench_scheduler [runs]
+ */
+
+#include "bench_common.h"
+
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Статические pick_job, run_job и scheduler_task нужны напрямую */
+#include "scheduler.c"
+
+#define BENCH_DEFAULT_RUNS 1000000
+#define SIM_PERIOD_MS 10
+
+#define CHECK(cond, ...)                 \
+    do {                                 \
+        if (!(cond)) {                   \
+            printf("check: " __VA_ARGS__); \
+            printf("\n");                \
+            s_failures++;                \
+        }                                \
+    } while (0)
+
+static int s_failures;
+
+static int64_t s_now_us;
+static int64_t s_stop_us;
+static jmp_buf s_stop;
+static struct scheduler *s_running;
+
+int64_t esp_timer_get_time(void)
+{
+    return s_now_us;
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    s_now_us += (int64_t)ticks * portTICK_PERIOD_MS * 1000;
+    if (s_now_us >= s_stop_us) {
+        longjmp(s_stop, 1);
+    }
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack_size, void *arg,
+                       UBaseType_t priority, TaskHandle_t *out_handle)
+{
+    (void)fn;
+    (void)name;
+    (void)stack_size;
+    (void)arg;
+    (void)priority;
+    *out_handle = &s_running;
+    return pdPASS;
+}
+
+typedef struct {
+    uint32_t work_us;
+    uint32_t overrun_every;     ///< Каждое N-е выполнение длится overrun_us; 0 — никогда
+    uint32_t overrun_us;
+    uint32_t runs;
+    uint64_t total_us;
+    bool under_lock;
+} sim_job_t;
+
+/* Задание сдвигает часы на своё время работы */
+static void sim_job(void *arg)
+{
+    sim_job_t *job = arg;
+    job->runs++;
+    uint32_t work_us = job->overrun_every && job->runs % job->overrun_every == 0 ? job->overrun_us : job->work_us;
+    job->total_us += work_us;
+    s_now_us += work_us;
+    if (s_running->stats_lock.depth != 0) {
+        job->under_lock = true;
+    }
+}
+
+/* Задача планировщика до момента until_us модельного времени */
+static void run_until(struct scheduler *sched, int64_t until_us)
+{
+    s_running = sched;
+    s_stop_us = until_us;
+    if (!setjmp(s_stop)) {
+        scheduler_task(sched);
+    }
+}
+
+static scheduler_handle_t sim_scheduler(const char *name, sim_job_t *fast, sim_job_t *slow)
+{
+    scheduler_config_t config = {.name = name, .stack_size = 4096, .task_priority = 5};
+    scheduler_handle_t sched;
+    CHECK(scheduler_create(&config, &sched) == ESP_OK, "%s: scheduler not created", name);
+
+    // Как servo и led в планировщике control: короткий срок у важного задания
+    scheduler_job_config_t fast_job = {
+        .name = "fast", .fn = sim_job, .arg = fast, .period_ms = SIM_PERIOD_MS, .deadline_ms = 2, .priority = 3,
+    };
+    scheduler_job_config_t slow_job = {
+        .name = "slow", .fn = sim_job, .arg = slow, .period_ms = SIM_PERIOD_MS, .priority = 1,
+    };
+    CHECK(scheduler_add_job(sched, &fast_job) == ESP_OK, "%s: fast job not added", name);
+    CHECK(scheduler_add_job(sched, &slow_job) == ESP_OK, "%s: slow job not added", name);
+    CHECK(scheduler_start(sched) == ESP_OK, "%s: scheduler not started", name);
+    return sched;
+}
+
+/* Общие для любого прогона соотношения счётчиков задания */
+static void check_stats(struct scheduler *sched, int index, const sim_job_t *sim, int64_t span_us)
+{
+    scheduler_job_stats_t stats = {0};
+    uint32_t lock_entries = sched->stats_lock.entries;
+    int global = index;
+    for (int i = 0; i < s_scheduler_count && &s_schedulers[i] != sched; i++) {
+        global += s_schedulers[i].job_count;
+    }
+    CHECK(scheduler_get_job_stats(global, &stats) == ESP_OK, "job %d stats", global);
+    CHECK(sched->stats_lock.entries == lock_entries + 1 && sched->stats_lock.depth == 0,
+          "%s: stats copied without the lock", stats.name);
+
+    uint32_t histogram_runs = 0;
+    for (int b = 0; b < SCHEDULER_HISTOGRAM_BUCKETS; b++) {
+        histogram_runs += stats.histogram[b];
+    }
+    CHECK(stats.runs == sim->runs, "%s: %u runs counted, %u done", stats.name, (unsigned)stats.runs,
+          (unsigned)sim->runs);
+    CHECK(histogram_runs == stats.runs, "%s: histogram holds %u of %u runs", stats.name,
+          (unsigned)histogram_runs, (unsigned)stats.runs);
+    CHECK(stats.total_us == sim->total_us, "%s: total %llu us, expected %llu us", stats.name,
+          (unsigned long long)stats.total_us, (unsigned long long)sim->total_us);
+    CHECK(!sim->under_lock, "%s: job ran under the stats lock", stats.name);
+
+    // Каждый выпуск за время прогона либо выполнен, либо пропущен
+    uint32_t releases = (uint32_t)(span_us / (SIM_PERIOD_MS * 1000));
+    uint32_t accounted = stats.runs + stats.skipped;
+    CHECK(accounted + 1 >= releases && accounted <= releases + 1,
+          "%s: %u runs + %u skipped for %u releases", stats.name, (unsigned)stats.runs,
+          (unsigned)stats.skipped, (unsigned)releases);
+}
+
+static void check_steady(void)
+{
+    sim_job_t fast = {.work_us = 300};
+    sim_job_t slow = {.work_us = 100};
+    struct scheduler *sched = sim_scheduler("steady", &fast, &slow);
+
+    int64_t started_us = s_now_us;
+    run_until(sched, started_us + 1000000);
+    int64_t span_us = s_now_us - started_us;
+
+    check_stats(sched, 0, &fast, span_us);
+    check_stats(sched, 1, &slow, span_us);
+    for (int i = 0; i < sched->job_count; i++) {
+        const scheduler_job_stats_t *stats = &sched->jobs[i].stats;
+        CHECK(stats->misses == 0 && stats->skipped == 0, "steady %s: %u misses, %u skipped", stats->name,
+              (unsigned)stats->misses, (unsigned)stats->skipped);
+    }
+    // Планировщик спит целыми тиками: старт позже выпуска меньше чем на тик,
+    // второе задание ждёт ещё и первое
+    uint32_t tick_us = portTICK_PERIOD_MS * 1000;
+    CHECK(sched->jobs[0].stats.max_latency_us < tick_us, "steady fast latency %u us",
+          (unsigned)sched->jobs[0].stats.max_latency_us);
+    CHECK(sched->jobs[1].stats.max_latency_us >= fast.work_us &&
+          sched->jobs[1].stats.max_latency_us < tick_us + fast.work_us, "steady slow latency %u us",
+          (unsigned)sched->jobs[1].stats.max_latency_us);
+}
+
+static void check_overrun(void)
+{
+    // Каждое 50-е выполнение медленного задания занимает 3.5 периода
+    sim_job_t fast = {.work_us = 300};
+    sim_job_t slow = {.work_us = 100, .overrun_every = 50, .overrun_us = 35000};
+    struct scheduler *sched = sim_scheduler("overrun", &fast, &slow);
+
+    int64_t started_us = s_now_us;
+    run_until(sched, started_us + 2000000);
+    int64_t span_us = s_now_us - started_us;
+
+    check_stats(sched, 0, &fast, span_us);
+    check_stats(sched, 1, &slow, span_us);
+
+    // Задания не вытесняются: важное задание ждёт конца затянувшегося.
+    // 35 мс от выпуска медленного теряют ему 3 следующих выпуска, важному —
+    // 2: его выпуск внутри затянувшегося выполнения ещё выполняется, с опозданием
+    const scheduler_job_stats_t *fast_stats = &sched->jobs[0].stats;
+    const scheduler_job_stats_t *slow_stats = &sched->jobs[1].stats;
+    uint32_t overruns = slow.runs / slow.overrun_every;
+    CHECK(overruns > 0, "no overrun happened");
+    CHECK(fast_stats->misses >= overruns, "fast: %u misses for %u overruns", (unsigned)fast_stats->misses,
+          (unsigned)overruns);
+    CHECK(fast_stats->skipped >= overruns * 2, "fast: %u skipped for %u overruns", (unsigned)fast_stats->skipped,
+          (unsigned)overruns);
+    CHECK(slow_stats->misses == overruns, "slow: %u misses for %u overruns", (unsigned)slow_stats->misses,
+          (unsigned)overruns);
+    CHECK(slow_stats->skipped == overruns * 3, "slow: %u skipped for %u overruns", (unsigned)slow_stats->skipped,
+          (unsigned)overruns);
+    CHECK(slow_stats->max_us == slow.overrun_us, "slow max %u us", (unsigned)slow_stats->max_us);
+    CHECK(fast_stats->max_latency_us >= slow.overrun_us - SIM_PERIOD_MS * 1000, "fast latency %u us",
+          (unsigned)fast_stats->max_latency_us);
+}
+
+int main(int argc, char **argv)
+{
+    int runs = argc > 1 ? atoi(argv[1]) : BENCH_DEFAULT_RUNS;
+    if (runs <= 0) {
+        runs = BENCH_DEFAULT_RUNS;
+    }
+
+    check_steady();
+    check_overrun();
+    printf("checks: %d errors\n", s_failures);
+
+    // Выбор и учёт выполнения на полном планировщике: задания пустые, часы стоят
+    static struct scheduler sched;
+    static sim_job_t jobs[SCHEDULER_MAX_JOBS];
+    portMUX_INITIALIZE(&sched.stats_lock);
+    s_running = &sched;
+    for (int i = 0; i < SCHEDULER_MAX_JOBS; i++) {
+        scheduler_job_t *job = &sched.jobs[i];
+        job->config = (scheduler_job_config_t){
+            .name = "bench", .fn = sim_job, .arg = &jobs[i], .period_ms = 1, .deadline_ms = 1, .priority = (uint8_t)(i % 3),
+        };
+        job->stats.name = job->config.name;
+    }
+    sched.job_count = SCHEDULER_MAX_JOBS;
+
+    s_now_us = 0;
+    uint64_t start_cycles = bench_cycles();
+    uint64_t start_ns = bench_now_ns();
+    for (int i = 0; i < runs; i++) {
+        // Все выпуски созрели: выбор проходит по всем заданиям
+        s_now_us += 1000;
+        scheduler_job_t *job = pick_job(&sched, s_now_us);
+        run_job(&sched, job);
+    }
+    uint64_t cycles = bench_cycles() - start_cycles;
+    double ns = (double)(bench_now_ns() - start_ns);
+    bench_consume(&sched);
+
+    printf("%d jobs: pick + run + stats %.2f ns/run", SCHEDULER_MAX_JOBS, ns / runs);
+    if (BENCH_HAVE_CYCLES) {
+        printf(" %8.1f cycles", (double)cycles / runs);
+    }
+    printf("\n");
+
+    return s_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,201 @@
+/*
+ * Калибровочные таблицы сервоприводов (servo_calibration): сначала проверяет
+ * кусочно-линейное отображение угол -> импульс -> угол, ограничение за
+ * крайними точками, зеркальные (убывающие) таблицы, заполненную таблицу и
+ * отказ для немонотонных точек, затем печатает стоимость прямого и обратного
+ * отображения на таблице из SERVO_CALIBRATION_MAX_POINTS точек — их задание
+ * servo вызывает на каждом кадре движения.
+ *
+ * Использование: bench_servo_calibration [iterations]
+ */
+
+#include "bench_common.h"
+#include "servo_calibration.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define BENCH_DEFAULT_ITERATIONS 10000000
+
+#define CHECK(cond, ...)                 \
+    do {                                 \
+        if (!(cond)) {                   \
+            printf("check: " __VA_ARGS__); \
+            printf("\n");                \
+            s_failures++;                \
+        }                                \
+    } while (0)
+
+static int s_failures;
+
+/* Каждая сотая градуса возвращается из импульса не дальше чем на 0.01° */
+static void check_round_trip(const servo_calibration_t *cal, const char *name)
+{
+    for (int32_t cdeg = cal->angle_cdeg[0]; cdeg <= cal->angle_cdeg[cal->count - 1]; cdeg++) {
+        float pulse_us = servo_calibration_pulse_us(cal, cdeg);
+        int32_t back = servo_calibration_angle_cdeg(cal, pulse_us);
+        if (back < cdeg - 1 || back > cdeg + 1) {
+            printf("check: %s round trip %d cdeg -> %.3f us -> %d cdeg\n", name, (int)cdeg,
+                   (double)pulse_us, (int)back);
+            s_failures++;
+            return;
+        }
+    }
+    for (int i = 0; i < cal->count; i++) {
+        CHECK(servo_calibration_pulse_us(cal, cal->angle_cdeg[i]) == cal->pulse_us[i],
+              "%s point %d pulse", name, i);
+        CHECK(servo_calibration_angle_cdeg(cal, cal->pulse_us[i]) == cal->angle_cdeg[i],
+              "%s point %d angle", name, i);
+    }
+}
+
+static void check_default(void)
+{
+    servo_calibration_t cal;
+    servo_calibration_default(&cal);
+    CHECK(servo_calibration_is_valid(&cal), "default table is invalid");
+    CHECK(servo_calibration_pulse_us(&cal, 9000) == 1650.0f, "default 90 deg gives %.2f us",
+          (double)servo_calibration_pulse_us(&cal, 9000));
+    check_round_trip(&cal, "default");
+
+    // За пределами таблицы — крайние точки, в обе стороны отображения
+    CHECK(servo_calibration_pulse_us(&cal, -500) == 800.0f, "below 0 deg not clamped");
+    CHECK(servo_calibration_pulse_us(&cal, 20000) == 2500.0f, "above 180 deg not clamped");
+    CHECK(servo_calibration_angle_cdeg(&cal, 500.0f) == 0, "short pulse not clamped");
+    CHECK(servo_calibration_angle_cdeg(&cal, 2700.0f) == 18000, "long pulse not clamped");
+
+    // Рабочий диапазон уже 0..180°: углы за ним упираются в крайние точки
+    servo_calibration_linear(&cal, 1000, 900, 17000, 2300);
+    CHECK(servo_calibration_is_valid(&cal), "narrow table is invalid");
+    CHECK(servo_calibration_pulse_us(&cal, 0) == 900.0f, "narrow table below range");
+    CHECK(servo_calibration_pulse_us(&cal, 18000) == 2300.0f, "narrow table above range");
+    CHECK(servo_calibration_angle_cdeg(&cal, 850.0f) == 1000, "narrow table short pulse");
+    check_round_trip(&cal, "narrow");
+}
+
+static void check_mirrored(void)
+{
+    servo_calibration_t cal;
+    servo_calibration_linear(&cal, 0, 2400, 18000, 600);
+    CHECK(servo_calibration_is_valid(&cal), "mirrored table is invalid");
+    CHECK(servo_calibration_pulse_us(&cal, 9000) == 1500.0f, "mirrored 90 deg gives %.2f us",
+          (double)servo_calibration_pulse_us(&cal, 9000));
+    CHECK(servo_calibration_angle_cdeg(&cal, 2600.0f) == 0, "mirrored long pulse not clamped to 0");
+    CHECK(servo_calibration_angle_cdeg(&cal, 500.0f) == 18000, "mirrored short pulse not clamped to 180");
+    check_round_trip(&cal, "mirrored");
+
+    CHECK(servo_calibration_set_point(&cal, 4500, 2000), "mirrored point rejected");
+    CHECK(servo_calibration_is_valid(&cal), "mirrored table with a mark is invalid");
+    check_round_trip(&cal, "mirrored mark");
+}
+
+/* Нелинейный сервопривод: отметки через каждые 30° до заполнения таблицы */
+static void fill_table(servo_calibration_t *cal)
+{
+    static const uint16_t s_marks[][2] = {
+        {3000, 1060}, {6000, 1350}, {9000, 1600}, {12000, 1830}, {15000, 2110}, {16500, 2300},
+    };
+
+    servo_calibration_linear(cal, 0, 780, 18000, 2480);
+    for (size_t i = 0; i < sizeof(s_marks) / sizeof(s_marks[0]); i++) {
+        CHECK(servo_calibration_set_point(cal, s_marks[i][0], s_marks[i][1]), "mark %u rejected",
+              (unsigned)s_marks[i][0]);
+    }
+}
+
+static void check_full(void)
+{
+    servo_calibration_t cal;
+    fill_table(&cal);
+    CHECK(cal.count == SERVO_CALIBRATION_MAX_POINTS, "full table has %d points", cal.count);
+    CHECK(servo_calibration_is_valid(&cal), "full table is invalid");
+    for (int i = 1; i < cal.count; i++) {
+        CHECK(cal.angle_cdeg[i] > cal.angle_cdeg[i - 1], "points out of order at %d", i);
+    }
+
+    // Между отметками — линейно: середина 60..90° даёт середину импульсов
+    CHECK(servo_calibration_pulse_us(&cal, 7500) == 1475.0f, "piecewise midpoint gives %.2f us",
+          (double)servo_calibration_pulse_us(&cal, 7500));
+    check_round_trip(&cal, "full");
+
+    // Новую точку некуда добавить, существующую можно заменить
+    CHECK(!servo_calibration_set_point(&cal, 4500, 1200), "point added to a full table");
+    CHECK(servo_calibration_set_point(&cal, 9000, 1610) && cal.count == SERVO_CALIBRATION_MAX_POINTS,
+          "point in a full table not replaced");
+    CHECK(servo_calibration_is_valid(&cal), "full table invalid after replace");
+}
+
+static void check_rejected(void)
+{
+    servo_calibration_t cal;
+
+    // Отметка выше соседней справа ломает монотонность: применять нельзя
+    servo_calibration_default(&cal);
+    CHECK(servo_calibration_set_point(&cal, 6000, 1400), "mark 60 deg rejected");
+    CHECK(servo_calibration_set_point(&cal, 9000, 1300), "mark 90 deg rejected");
+    CHECK(!servo_calibration_is_valid(&cal), "non-monotonic table accepted");
+
+    // Равные импульсы не обращаются однозначно
+    servo_calibration_default(&cal);
+    servo_calibration_set_point(&cal, 9000, 800);
+    CHECK(!servo_calibration_is_valid(&cal), "flat segment accepted");
+
+    servo_calibration_linear(&cal, 9000, 1000, 9000, 2000);
+    CHECK(!servo_calibration_is_valid(&cal), "repeated angle accepted");
+    servo_calibration_linear(&cal, 0, 300, 18000, 2500);
+    CHECK(!servo_calibration_is_valid(&cal), "pulse below range accepted");
+
+    servo_calibration_default(&cal);
+    cal.count = 1;
+    CHECK(!servo_calibration_is_valid(&cal), "single point accepted");
+    cal.count = SERVO_CALIBRATION_MAX_POINTS + 1;
+    CHECK(!servo_calibration_is_valid(&cal), "oversized table accepted");
+    servo_calibration_default(&cal);
+    cal.version = SERVO_CALIBRATION_VERSION + 1;
+    CHECK(!servo_calibration_is_valid(&cal), "unknown version accepted");
+
+    servo_calibration_default(&cal);
+    CHECK(!servo_calibration_set_point(&cal, -1, 1000), "negative angle point accepted");
+    CHECK(!servo_calibration_set_point(&cal, 18001, 1000), "angle above 180 point accepted");
+    CHECK(!servo_calibration_set_point(&cal, 9000, SERVO_CALIBRATION_PULSE_MAX_US + 1), "long pulse point accepted");
+    CHECK(cal.count == 2, "rejected points changed the table");
+}
+
+int main(int argc, char **argv)
+{
+    int iterations = argc > 1 ? atoi(argv[1]) : BENCH_DEFAULT_ITERATIONS;
+    if (iterations <= 0) {
+        iterations = BENCH_DEFAULT_ITERATIONS;
+    }
+
+    check_default();
+    check_mirrored();
+    check_full();
+    check_rejected();
+    printf("checks: %d errors\n", s_failures);
+
+    servo_calibration_t cal;
+    fill_table(&cal);
+
+    float pulse_sum = 0.0f;
+    uint64_t start_ns = bench_now_ns();
+    for (int i = 0; i < iterations; i++) {
+        pulse_sum += servo_calibration_pulse_us(&cal, (int32_t)((i * 7919u) % 18001u));
+    }
+    double pulse_ns = (double)(bench_now_ns() - start_ns);
+    bench_consume(&pulse_sum);
+
+    int64_t angle_sum = 0;
+    start_ns = bench_now_ns();
+    for (int i = 0; i < iterations; i++) {
+        angle_sum += servo_calibration_angle_cdeg(&cal, 780.0f + (float)((i * 7919u) % 1701u));
+    }
+    double angle_ns = (double)(bench_now_ns() - start_ns);
+    bench_consume(&angle_sum);
+
+    printf("%d-point table: pulse_us %.2f ns/call, angle_cdeg %.2f ns/call\n", cal.count,
+           pulse_ns / iterations, angle_ns / iterations);
+
+    return s_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,162 @@
+/*
+ * Модель аппаратного затухания LEDC (servo_fade): сначала проверяет разбиение
+ * на шаги, фактическое время окончания и прерывание затухания на середине,
+ * затем печатает стоимость servo_fade_duty_at — её задание servo вызывает
+ * на каждом кадре, пока идёт затухание.
+ *
+ * Duty соответствуют калибровке по умолчанию: 800..2500 мкс при 13 битах и
+ * 50 Гц, т.е. 328 (0°), 676 (90°) и 1024 (180°).
+ *
+ * Использование: bench_servo_fade [iterations]
+ */
+
+#include "bench_common.h"
+#include "servo_fade.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define BENCH_DEFAULT_ITERATIONS 10000000
+#define BENCH_PWM_HZ 50
+#define BENCH_PERIOD_US 20000
+#define BENCH_START_US 1000000
+
+#define DUTY_0_DEG 328
+#define DUTY_90_DEG 676
+#define DUTY_180_DEG 1024
+
+#define CHECK(cond, ...)                 \
+    do {                                 \
+        if (!(cond)) {                   \
+            printf("check: " __VA_ARGS__); \
+            printf("\n");                \
+            s_failures++;                \
+        }                                \
+    } while (0)
+
+static int s_failures;
+
+static uint32_t delta_of(const servo_fade_t *fade)
+{
+    return fade->target_duty > fade->start_duty ? fade->target_duty - fade->start_duty
+                                                : fade->start_duty - fade->target_duty;
+}
+
+/* Duty меняется только на границах шагов, ровно на scale и только к цели */
+static void check_steps(const servo_fade_t *fade, const char *name)
+{
+    int64_t step_us = (int64_t)fade->cycle_num * fade->period_us;
+    uint32_t previous = fade->start_duty;
+    uint32_t delta = delta_of(fade);
+
+    for (uint32_t k = 1; k <= fade->steps; k++) {
+        int64_t edge = fade->started_us + (int64_t)k * step_us;
+        uint32_t before = servo_fade_duty_at(fade, edge - 1);
+        uint32_t after = servo_fade_duty_at(fade, edge);
+        uint32_t moved = k * fade->scale < delta ? k * fade->scale : delta;
+        uint32_t expected = fade->target_duty > fade->start_duty ? fade->start_duty + moved
+                                                                 : fade->start_duty - moved;
+
+        if (before != previous || after != expected) {
+            printf("check: %s step %u: %u -> %u, expected %u -> %u\n", name, (unsigned)k,
+                   (unsigned)before, (unsigned)after, (unsigned)previous, (unsigned)expected);
+            s_failures++;
+            return;
+        }
+        previous = after;
+    }
+    CHECK(previous == fade->target_duty, "%s ends at %u, expected %u", name,
+          (unsigned)previous, (unsigned)fade->target_duty);
+}
+
+static void check_fades(void)
+{
+    servo_fade_t fade;
+
+    // 0° -> 90° за 1000 мс: 348 отсчётов на 50 периодов дают scale 6,
+    // 58 шагов по периоду — LEDC закончит через 1160 мс, а не через 1000
+    servo_fade_plan(&fade, DUTY_0_DEG, DUTY_90_DEG, 1000, BENCH_PWM_HZ, BENCH_START_US);
+    CHECK(fade.scale == 6 && fade.cycle_num == 1 && fade.steps == 58,
+          "90 deg in 1000 ms: scale %u cycle_num %u steps %u", (unsigned)fade.scale,
+          (unsigned)fade.cycle_num, (unsigned)fade.steps);
+    CHECK(servo_fade_end_us(&fade) - BENCH_START_US == 1160000,
+          "90 deg in 1000 ms ends after %lld us", (long long)(servo_fade_end_us(&fade) - BENCH_START_US));
+    CHECK(servo_fade_duty_at(&fade, BENCH_START_US - 5000) == DUTY_0_DEG, "duty before start");
+    CHECK(servo_fade_duty_at(&fade, servo_fade_end_us(&fade) + 5000) == DUTY_90_DEG, "duty after end");
+    check_steps(&fade, "0->90");
+
+    // Обратный ход: то же разбиение, duty убывает
+    servo_fade_plan(&fade, DUTY_90_DEG, DUTY_0_DEG, 1000, BENCH_PWM_HZ, BENCH_START_US);
+    check_steps(&fade, "90->0");
+
+    // Медленное затухание: один отсчёт раз в 5 периодов, время совпадает с запрошенным
+    servo_fade_plan(&fade, DUTY_90_DEG, DUTY_90_DEG + 10, 1000, BENCH_PWM_HZ, BENCH_START_US);
+    CHECK(fade.scale == 1 && fade.cycle_num == 5 && fade.steps == 10,
+          "slow fade: scale %u cycle_num %u steps %u", (unsigned)fade.scale,
+          (unsigned)fade.cycle_num, (unsigned)fade.steps);
+    CHECK(servo_fade_end_us(&fade) - BENCH_START_US == 1000000, "slow fade end");
+    check_steps(&fade, "slow");
+
+    // Число периодов на шаг ограничено регистром LEDC: затухание короче запрошенного
+    servo_fade_plan(&fade, DUTY_90_DEG, DUTY_90_DEG + 1, 60000, BENCH_PWM_HZ, BENCH_START_US);
+    CHECK(fade.cycle_num == SERVO_FADE_CYCLE_NUM_MAX, "cycle_num %u not capped", (unsigned)fade.cycle_num);
+    CHECK(servo_fade_end_us(&fade) - BENCH_START_US == (int64_t)SERVO_FADE_CYCLE_NUM_MAX * BENCH_PERIOD_US,
+          "capped fade end");
+
+    // Короче периода ШИМ — один шаг сразу на всю разность
+    servo_fade_plan(&fade, DUTY_0_DEG, DUTY_180_DEG, 5, BENCH_PWM_HZ, BENCH_START_US);
+    CHECK(fade.steps == 1 && fade.scale == DUTY_180_DEG - DUTY_0_DEG, "short fade is not one step");
+    CHECK(servo_fade_end_us(&fade) - BENCH_START_US == BENCH_PERIOD_US, "short fade end");
+
+    // Цель совпадает с текущим duty — затухания нет
+    servo_fade_plan(&fade, DUTY_90_DEG, DUTY_90_DEG, 1000, BENCH_PWM_HZ, BENCH_START_US);
+    CHECK(fade.steps == 0 && servo_fade_end_us(&fade) == BENCH_START_US, "empty fade has steps");
+    CHECK(servo_fade_duty_at(&fade, BENCH_START_US + 1) == DUTY_90_DEG, "empty fade duty");
+
+    // Отмена на середине: новое затухание начинается с duty, на котором
+    // остановилось прежнее, и выход не прыгает
+    servo_fade_plan(&fade, DUTY_0_DEG, DUTY_180_DEG, 2000, BENCH_PWM_HZ, BENCH_START_US);
+    int64_t cancel_us = BENCH_START_US + 730000;
+    uint32_t stopped = servo_fade_duty_at(&fade, cancel_us);
+    CHECK(stopped > DUTY_0_DEG && stopped < DUTY_180_DEG, "mid-fade duty %u", (unsigned)stopped);
+
+    servo_fade_t back;
+    servo_fade_plan(&back, stopped, DUTY_0_DEG, 500, BENCH_PWM_HZ, cancel_us);
+    CHECK(servo_fade_duty_at(&back, cancel_us) == stopped, "reversed fade jumps at start");
+    CHECK(servo_fade_duty_at(&back, cancel_us + BENCH_PERIOD_US) < stopped, "reversed fade does not move back");
+    CHECK(servo_fade_end_us(&back) < servo_fade_end_us(&fade), "reversed fade outlives the cancelled one");
+    check_steps(&back, "cancel->0");
+}
+
+int main(int argc, char **argv)
+{
+    int iterations = argc > 1 ? atoi(argv[1]) : BENCH_DEFAULT_ITERATIONS;
+    if (iterations <= 0) {
+        iterations = BENCH_DEFAULT_ITERATIONS;
+    }
+
+    check_fades();
+    printf("checks: %d errors\n", s_failures);
+
+    servo_fade_t fade;
+    servo_fade_plan(&fade, DUTY_0_DEG, DUTY_180_DEG, 3000, BENCH_PWM_HZ, 0);
+    int64_t span_us = servo_fade_end_us(&fade);
+    uint64_t sum = 0;
+
+    uint64_t start_cycles = bench_cycles();
+    uint64_t start_ns = bench_now_ns();
+    for (int i = 0; i < iterations; i++) {
+        sum += servo_fade_duty_at(&fade, (int64_t)(i * 7919u) % span_us);
+    }
+    uint64_t cycles = bench_cycles() - start_cycles;
+    double ns = (double)(bench_now_ns() - start_ns);
+    bench_consume(&sum);
+
+    printf("servo_fade_duty_at %8.2f ns/call", ns / iterations);
+    if (BENCH_HAVE_CYCLES) {
+        printf(" %8.1f cycles", (double)cycles / iterations);
+    }
+    printf("\n");
+
+    return s_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,210 @@
+/*
+ * Бенчмарк разбора потока MK8000 на хосте.
+ *
+ * Воспроизводит запись UART (бинарные кадры F0 05 .. AA вперемешку с
+ * диагностическими текстовыми строками) через uwb_parser порциями по 128 байт,
+ * как это делает uwb_positioning_task, и печатает bytes/s, frames/s и
+ * стоимость одного кадра.
+ *
+ * Использование: bench_uwb_parser [capture.bin] [iterations]
+ * Без файла используется синтетическая запись.
+ */
+
+#include "bench_common.h"
+#include "uwb_parser.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_CHUNK_SIZE 128
+#define BENCH_DEFAULT_ITERATIONS 2000
+#define BENCH_SYNTHETIC_RECORDS 4096
+#define BENCH_UART_BAUD 115200
+#define BENCH_PERIOD_MS 10
+
+typedef struct {
+    uint64_t frames;
+    uint64_t invalid_frames;
+    uint64_t lines;
+    uint64_t invalid_lines;
+    uint64_t discarded;
+} bench_counters_t;
+
+static void count_event(const uwb_parser_event_t *event, void *ctx)
+{
+    bench_counters_t *counters = ctx;
+
+    switch (event->type) {
+        case UWB_PARSER_EVENT_FRAME_RANGE:
+            counters->frames++;
+            bench_consume(event->range);
+            break;
+        case UWB_PARSER_EVENT_FRAME_INVALID:
+        case UWB_PARSER_EVENT_FRAME_BAD_LENGTH:
+            counters->invalid_frames++;
+            break;
+        case UWB_PARSER_EVENT_LINE_RANGE:
+            counters->lines++;
+            bench_consume(event->range);
+            break;
+        case UWB_PARSER_EVENT_LINE_INVALID:
+        case UWB_PARSER_EVENT_LINE_OVERFLOW:
+            counters->invalid_lines++;
+            break;
+        case UWB_PARSER_EVENT_DISCARDED_BYTE:
+            counters->discarded++;
+            break;
+    }
+}
+
+static uint8_t *load_capture(const char *path, size_t *len)
+{
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        return NULL;
+    }
+
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    if (size <= 0) {
+        fclose(f);
+        return NULL;
+    }
+
+    uint8_t *data = malloc((size_t)size);
+    if (data != NULL && fread(data, 1, (size_t)size, f) != (size_t)size) {
+        free(data);
+        data = NULL;
+    }
+    fclose(f);
+
+    *len = (size_t)size;
+    return data;
+}
+
+/*
+ * Синтетическая запись: три пира с period=5, каждая 16-я запись — текстовая
+ * строка одного из четырёх форматов, каждая 64-я — мусорный байт.
+ */
+static uint8_t *build_synthetic_capture(size_t *len)
+{
+    static const char *const line_formats[] = {
+        "DIST,uwb_%04X,%u.%03u\r\n",
+        "DIST:uwb_%04X:%u.%03u\r\n",
+        "uwb_%04X,%u.%03u\r\n",
+        "uwb_%04X:%u.%03u\r\n",
+    };
+
+    size_t capacity = BENCH_SYNTHETIC_RECORDS * 32;
+    uint8_t *data = malloc(capacity);
+    if (data == NULL) {
+        return NULL;
+    }
+
+    size_t offset = 0;
+    uint32_t seed = 0x12345678u;
+    for (int i = 0; i < BENCH_SYNTHETIC_RECORDS; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        uint16_t peer = (uint16_t)(1 + (i % 3));
+        uint16_t distance_cm = (uint16_t)(50 + (seed >> 16) % 900);
+
+        if (i % 64 == 63) {
+            data[offset++] = 0x07;
+        }
+
+        if (i % 16 == 15) {
+            int written = snprintf((char *)data + offset, capacity - offset,
+                                   line_formats[(i / 16) % 4], peer,
+                                   distance_cm / 100, (distance_cm % 100) * 10);
+            offset += (size_t)written;
+            continue;
+        }
+
+        uint8_t frame[UWB_FRAME_SIZE] = {
+            UWB_FRAME_HEADER, UWB_FRAME_PAYLOAD_LEN,
+            (uint8_t)(peer & 0xFF), (uint8_t)(peer >> 8),
+            (uint8_t)(distance_cm & 0xFF), (uint8_t)(distance_cm >> 8),
+            (uint8_t)(256 - 60 - (seed >> 8) % 30), UWB_FRAME_TAIL,
+        };
+        memcpy(data + offset, frame, sizeof(frame));
+        offset += sizeof(frame);
+    }
+
+    *len = offset;
+    return data;
+}
+
+static void replay(uwb_parser_t *parser, const uint8_t *data, size_t len)
+{
+    for (size_t offset = 0; offset < len; offset += BENCH_CHUNK_SIZE) {
+        size_t chunk = len - offset < BENCH_CHUNK_SIZE ? len - offset : BENCH_CHUNK_SIZE;
+        uwb_parser_feed(parser, data + offset, chunk, (int64_t)offset);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    const char *capture_path = argc > 1 ? argv[1] : NULL;
+    int iterations = argc > 2 ? atoi(argv[2]) : BENCH_DEFAULT_ITERATIONS;
+    if (iterations <= 0) {
+        iterations = BENCH_DEFAULT_ITERATIONS;
+    }
+
+    size_t len = 0;
+    uint8_t *data = capture_path != NULL ? load_capture(capture_path, &len) : build_synthetic_capture(&len);
+    if (data == NULL) {
+        fprintf(stderr, "Failed to load capture%s%s\n",
+                capture_path != NULL ? ": " : "", capture_path != NULL ? capture_path : "");
+        return 1;
+    }
+
+    bench_counters_t counters = {0};
+    uwb_parser_t parser;
+    uwb_parser_init(&parser, count_event, &counters);
+
+    /* Прогрев и подсчёт событий за один проход */
+    replay(&parser, data, len);
+    bench_counters_t per_pass = counters;
+    memset(&counters, 0, sizeof(counters));
+
+    uint64_t start_ns = bench_now_ns();
+    uint64_t start_cycles = bench_cycles();
+    for (int i = 0; i < iterations; i++) {
+        replay(&parser, data, len);
+    }
+    uint64_t elapsed_cycles = bench_cycles() - start_cycles;
+    uint64_t elapsed_ns = bench_now_ns() - start_ns;
+
+    double seconds = (double)elapsed_ns / 1e9;
+    double total_bytes = (double)len * iterations;
+    uint64_t records = counters.frames + counters.lines;
+    double ns_per_byte = (double)elapsed_ns / total_bytes;
+    /* Байты, приходящие по UART за один период задания uwb */
+    double uart_bytes_per_period = (double)BENCH_UART_BAUD / 10.0 * BENCH_PERIOD_MS / 1000.0;
+
+    printf("capture: %s, %zu bytes/pass, %d passes\n",
+           capture_path != NULL ? capture_path : "synthetic", len, iterations);
+    printf("per pass: frames=%llu invalidFrames=%llu lines=%llu invalidLines=%llu discarded=%llu\n",
+           (unsigned long long)per_pass.frames, (unsigned long long)per_pass.invalid_frames,
+           (unsigned long long)per_pass.lines, (unsigned long long)per_pass.invalid_lines,
+           (unsigned long long)per_pass.discarded);
+    printf("throughput: %.1f MB/s, %.0f frames/s, %.0f lines/s\n",
+           total_bytes / seconds / 1e6,
+           (double)counters.frames / seconds,
+           (double)counters.lines / seconds);
+    if (records > 0) {
+        printf("cost: %.1f ns/record", (double)elapsed_ns / (double)records);
+        if (BENCH_HAVE_CYCLES) {
+            printf(", %.0f cycles/record", (double)elapsed_cycles / (double)records);
+        }
+        printf("\n");
+    }
+    printf("budget: %.2f us to parse %.0f bytes (one %d ms period at %d baud)\n",
+           ns_per_byte * uart_bytes_per_period / 1000.0, uart_bytes_per_period,
+           BENCH_PERIOD_MS, BENCH_UART_BAUD);
+
+    free(data);
+    return 0;
+}
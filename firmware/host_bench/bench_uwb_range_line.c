@@ -0,0 +1,152 @@
+/*
+ * Сравнение разбора текстовых строк MK8000: табличный однопроходный
+ * uwb_parser_parse_range_line против прежнего каскада sscanf.
+ *
+ * Перед замером проверяет, что на общем наборе строк оба разборщика
+ * согласны (с точностью до округления расстояния до миллиметра).
+ *
+ * Использование: bench_uwb_range_line [iterations]
+ */
+
+#include "bench_common.h"
+#include "uwb_parser.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_DEFAULT_ITERATIONS 200000
+
+/* Прежняя реализация из uwb_positioning.c, оставлена только для сравнения */
+static bool legacy_parse_range_line(const char *line, int64_t now_ms, uwb_range_t *range)
+{
+    char peer_id[UWB_PEER_ID_LEN] = {0};
+    float distance_m = 0.0f;
+
+    if (sscanf(line, "DIST,%31[^,],%f", peer_id, &distance_m) == 2 ||
+        sscanf(line, "DIST:%31[^:]:%f", peer_id, &distance_m) == 2 ||
+        sscanf(line, "%31[^,],%f", peer_id, &distance_m) == 2 ||
+        sscanf(line, "%31[^:]:%f", peer_id, &distance_m) == 2) {
+        if (peer_id[0] == '\0' || distance_m < 0.0f || distance_m > 100.0f) {
+            return false;
+        }
+
+        memset(range, 0, sizeof(*range));
+        uwb_parser_set_peer(range, peer_id, strlen(peer_id));
+        range->distance_m = distance_m;
+        range->updated_at_ms = now_ms;
+        range->valid = true;
+        return true;
+    }
+
+    return false;
+}
+
+typedef bool (*parse_fn_t)(const char *line, int64_t now_ms, uwb_range_t *range);
+
+static const char *const s_corpus[] = {
+    "DIST,uwb_0001,1.234",
+    "DIST:uwb_0002:0.5",
+    "uwb_0003,12.75",
+    "uwb_0004:99.999",
+    "DIST,anchor-left,3",
+    "DIST, spaced ,  4.250",
+    "DIST,uwb_0001,1.23456",
+    "a:b,1.5",
+    "DIST,uwb_0001,-0.0",
+    "DIST,uwb_0001,+2.5m",
+    "DIST,uwb_0001,100.0",
+    "DIST,uwb_0001,100.001",
+    "DIST,uwb_0001,-1.0",
+    "DIST,,1.0",
+    "DIST,uwb_0001,",
+    "DIST,uwb_0001,abc",
+    "OK",
+    "AT+MODE=0",
+    "+PERIOD:5",
+    "ERROR: unknown command",
+    "DIST,this_peer_name_is_way_too_long_for_buffer,1.0",
+};
+
+#define CORPUS_SIZE (sizeof(s_corpus) / sizeof(s_corpus[0]))
+
+static int check_agreement(void)
+{
+    int mismatches = 0;
+
+    for (size_t i = 0; i < CORPUS_SIZE; i++) {
+        uwb_range_t expected = {0};
+        uwb_range_t actual = {0};
+        bool expected_ok = legacy_parse_range_line(s_corpus[i], 0, &expected);
+        bool actual_ok = uwb_parser_parse_range_line(s_corpus[i], 0, &actual);
+
+        char expected_peer[UWB_PEER_ID_LEN] = {0};
+        char actual_peer[UWB_PEER_ID_LEN] = {0};
+        uwb_range_format_peer_id(&expected, expected_peer, sizeof(expected_peer));
+        uwb_range_format_peer_id(&actual, actual_peer, sizeof(actual_peer));
+
+        bool same = (expected_ok == actual_ok);
+        if (same && expected_ok) {
+            same = strcmp(expected_peer, actual_peer) == 0 &&
+                   fabsf(expected.distance_m - actual.distance_m) < 0.0006f;
+        }
+
+        if (!same) {
+            mismatches++;
+            printf("mismatch: \"%s\": sscanf=%s(%s, %.4f) table=%s(%s, %.4f)\n", s_corpus[i],
+                   expected_ok ? "ok" : "reject", expected_peer, (double)expected.distance_m,
+                   actual_ok ? "ok" : "reject", actual_peer, (double)actual.distance_m);
+        }
+    }
+
+    return mismatches;
+}
+
+static double measure(parse_fn_t parse, int iterations, uint64_t *cycles)
+{
+    uwb_range_t range;
+    uint64_t start_cycles = bench_cycles();
+    uint64_t start_ns = bench_now_ns();
+
+    for (int i = 0; i < iterations; i++) {
+        for (size_t j = 0; j < CORPUS_SIZE; j++) {
+            parse(s_corpus[j], i, &range);
+            bench_consume(&range);
+        }
+    }
+
+    *cycles = bench_cycles() - start_cycles;
+    return (double)(bench_now_ns() - start_ns);
+}
+
+int main(int argc, char **argv)
+{
+    int iterations = argc > 1 ? atoi(argv[1]) : BENCH_DEFAULT_ITERATIONS;
+    if (iterations <= 0) {
+        iterations = BENCH_DEFAULT_ITERATIONS;
+    }
+
+    int mismatches = check_agreement();
+    printf("agreement: %zu lines, %d mismatches\n", CORPUS_SIZE, mismatches);
+
+    uint64_t legacy_cycles = 0;
+    uint64_t table_cycles = 0;
+    double legacy_ns = measure(legacy_parse_range_line, iterations, &legacy_cycles);
+    double table_ns = measure(uwb_parser_parse_range_line, iterations, &table_cycles);
+    double lines = (double)iterations * CORPUS_SIZE;
+
+    printf("sscanf cascade: %.1f ns/line", legacy_ns / lines);
+    if (BENCH_HAVE_CYCLES) {
+        printf(", %.0f cycles/line", (double)legacy_cycles / lines);
+    }
+    printf("\n");
+    printf("table parser:   %.1f ns/line", table_ns / lines);
+    if (BENCH_HAVE_CYCLES) {
+        printf(", %.0f cycles/line", (double)table_cycles / lines);
+    }
+    printf("\n");
+    printf("speedup: %.1fx\n", legacy_ns / table_ns);
+
+    return mismatches == 0 ? 0 : 1;
+}
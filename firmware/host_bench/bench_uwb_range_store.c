@@ -0,0 +1,178 @@
+/*
+ * Обновление таблицы расстояний при 1..64 пирах: хеш-индекс по адресу
+ * MK8000 с LRU-вытеснением (uwb_range_store) против прежнего линейного
+ * поиска по строковому peer_id с форматированием "uwb_%04X" на каждый кадр.
+ *
+ * Перед замером проверяет, что таблица находит всех пиров и при
+ * переполнении вытесняет самых давних.
+ *
+ * Использование: bench_uwb_range_store [updates_per_point]
+ */
+
+#include "bench_common.h"
+#include "uwb_range_store.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_DEFAULT_UPDATES 2000000
+#define BENCH_ANCHOR_BASE 0x1000
+
+/* Прежняя реализация: строковый ключ, линейный поиск, вытеснение старейшего */
+typedef struct {
+    char peer_id[UWB_PEER_ID_LEN];
+    float distance_m;
+    int rssi_dbm;
+    int64_t updated_at_ms;
+    bool valid;
+} legacy_range_t;
+
+static legacy_range_t s_legacy[UWB_MAX_RANGES];
+
+static void legacy_upsert(uint16_t peer_addr, float distance_m, int64_t now_ms)
+{
+    legacy_range_t range = {0};
+    snprintf(range.peer_id, sizeof(range.peer_id), "uwb_%04X", peer_addr);
+    range.distance_m = distance_m;
+    range.updated_at_ms = now_ms;
+    range.valid = true;
+
+    for (size_t i = 0; i < UWB_MAX_RANGES; i++) {
+        if (s_legacy[i].valid && strncmp(s_legacy[i].peer_id, range.peer_id, UWB_PEER_ID_LEN) == 0) {
+            s_legacy[i] = range;
+            return;
+        }
+    }
+
+    for (size_t i = 0; i < UWB_MAX_RANGES; i++) {
+        if (!s_legacy[i].valid) {
+            s_legacy[i] = range;
+            return;
+        }
+    }
+
+    size_t oldest_index = 0;
+    for (size_t i = 1; i < UWB_MAX_RANGES; i++) {
+        if (s_legacy[i].updated_at_ms < s_legacy[oldest_index].updated_at_ms) {
+            oldest_index = i;
+        }
+    }
+    s_legacy[oldest_index] = range;
+}
+
+static uwb_range_store_t s_store;
+static uwb_range_t s_snapshot[UWB_MAX_RANGES];
+
+static void store_upsert(uint16_t peer_addr, float distance_m, int64_t now_ms)
+{
+    uwb_range_t range = {0};
+    range.peer_addr = peer_addr;
+    range.distance_m = distance_m;
+    range.updated_at_ms = now_ms;
+    range.valid = true;
+    uwb_range_store_upsert(&s_store, &range);
+}
+
+static bool snapshot_has(size_t count, uint16_t peer_addr)
+{
+    for (size_t i = 0; i < count; i++) {
+        if (!s_snapshot[i].peer_named && s_snapshot[i].peer_addr == peer_addr) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static int check_store(void)
+{
+    int errors = 0;
+
+    uwb_range_store_reset(&s_store);
+    for (int64_t t = 0; t < UWB_MAX_RANGES * 3; t++) {
+        store_upsert((uint16_t)(BENCH_ANCHOR_BASE + t % UWB_MAX_RANGES), 1.0f, t);
+    }
+    size_t count = uwb_range_store_snapshot(&s_store, s_snapshot, UWB_MAX_RANGES, UWB_MAX_RANGES * 3, 1000000);
+    if (count != UWB_MAX_RANGES) {
+        printf("check: expected %d peers, got %zu\n", UWB_MAX_RANGES, count);
+        errors++;
+    }
+
+    // Переполнение: должны остаться последние UWB_MAX_RANGES пиров
+    int total_peers = UWB_MAX_RANGES + UWB_MAX_RANGES / 2;
+    uwb_range_store_reset(&s_store);
+    for (int i = 0; i < total_peers; i++) {
+        store_upsert((uint16_t)(BENCH_ANCHOR_BASE + i), 1.0f, i);
+    }
+    count = uwb_range_store_snapshot(&s_store, s_snapshot, UWB_MAX_RANGES, total_peers, 1000000);
+    for (int i = 0; i < total_peers; i++) {
+        bool expected = i >= total_peers - UWB_MAX_RANGES;
+        if (snapshot_has(count, (uint16_t)(BENCH_ANCHOR_BASE + i)) != expected) {
+            printf("check: peer %d %s after eviction\n", i, expected ? "missing" : "still present");
+            errors++;
+        }
+    }
+
+    // Повторно пришедший пир не должен вытесняться первым
+    uwb_range_store_reset(&s_store);
+    for (int i = 0; i < UWB_MAX_RANGES; i++) {
+        store_upsert((uint16_t)(BENCH_ANCHOR_BASE + i), 1.0f, i);
+    }
+    store_upsert(BENCH_ANCHOR_BASE, 2.0f, UWB_MAX_RANGES);
+    store_upsert(0xBEEF, 3.0f, UWB_MAX_RANGES + 1);
+    count = uwb_range_store_snapshot(&s_store, s_snapshot, UWB_MAX_RANGES, UWB_MAX_RANGES + 1, 1000000);
+    if (!snapshot_has(count, BENCH_ANCHOR_BASE) || snapshot_has(count, BENCH_ANCHOR_BASE + 1) ||
+        !snapshot_has(count, 0xBEEF)) {
+        printf("check: LRU order is not respected\n");
+        errors++;
+    }
+
+    return errors;
+}
+
+typedef void (*upsert_fn_t)(uint16_t peer_addr, float distance_m, int64_t now_ms);
+
+static double measure(upsert_fn_t upsert, int peers, int updates, uint64_t *cycles)
+{
+    uint64_t start_cycles = bench_cycles();
+    uint64_t start_ns = bench_now_ns();
+
+    for (int i = 0; i < updates; i++) {
+        upsert((uint16_t)(BENCH_ANCHOR_BASE + i % peers), 1.0f + (float)(i & 0xFF) * 0.001f, i);
+    }
+
+    *cycles = bench_cycles() - start_cycles;
+    return (double)(bench_now_ns() - start_ns);
+}
+
+int main(int argc, char **argv)
+{
+    int updates = argc > 1 ? atoi(argv[1]) : BENCH_DEFAULT_UPDATES;
+    if (updates <= 0) {
+        updates = BENCH_DEFAULT_UPDATES;
+    }
+
+    int errors = check_store();
+    printf("checks: capacity %d, %d errors\n", UWB_MAX_RANGES, errors);
+
+    printf("%6s %16s %16s %8s\n", "peers", "linear ns/upd", "hashed ns/upd", "speedup");
+    for (int peers = 1; peers <= UWB_MAX_RANGES; peers *= 2) {
+        uint64_t legacy_cycles = 0;
+        uint64_t store_cycles = 0;
+
+        memset(s_legacy, 0, sizeof(s_legacy));
+        double legacy_ns = measure(legacy_upsert, peers, updates, &legacy_cycles);
+        uwb_range_store_reset(&s_store);
+        double store_ns = measure(store_upsert, peers, updates, &store_cycles);
+        bench_consume(s_legacy);
+        bench_consume(&s_store);
+
+        printf("%6d %16.1f %16.1f %7.1fx", peers, legacy_ns / updates, store_ns / updates, legacy_ns / store_ns);
+        if (BENCH_HAVE_CYCLES) {
+            printf("  (%.0f vs %.0f cycles)", (double)legacy_cycles / updates, (double)store_cycles / updates);
+        }
+        printf("\n");
+    }
+
+    return errors == 0 ? 0 : 1;
+}
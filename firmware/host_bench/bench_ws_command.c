@@ -0,0 +1,377 @@
+/*
+ * Разбор входящих команд WebSocket: ws_command_parse прямо в буфере кадра
+ * против прежнего пути malloc-копия + cJSON_Parse + strcmp по type.
+ *
+ * Сначала проверяет разбор эталонных команд, затем прогоняет фаззинг:
+ * мутации эталонов (замена, вставка и удаление байтов, обрезка) и
+ * случайные байты. Каждое сообщение лежит в буфере ровно своей длины,
+ * поэтому выход за его границу ловит сборка с -fsanitize=address.
+ * Принятая фаззером команда должна быть в допустимых диапазонах.
+ *
+ * Сравнение с cJSON собирается, только если CMake нашёл исходники cJSON
+ * (ESP-IDF components/json/cJSON или -DCJSON_DIR=...).
+ *
+ * Использование: bench_ws_command [iterations] [fuzz_cases] [seed]
+ */
+
+#include "bench_common.h"
+#include "ws_command.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef BENCH_HAVE_CJSON
+#include "cJSON.h"
+#endif
+
+#define BENCH_DEFAULT_ITERATIONS 200000
+#define BENCH_DEFAULT_FUZZ_CASES 1000000
+#define BENCH_FUZZ_MAX_LEN 512
+
+/* Поток живого наведения: в основном set_servo / set_pose */
+static const char *const s_corpus[] = {
+    "{\"type\":\"set_servo\",\"id\":1,\"angle\":92.35}",
+    "{\"type\":\"set_servo\",\"id\":2,\"angle\":37,\"durationMs\":400}",
+    "{\"type\":\"set_pose\",\"pan\":120,\"tilt\":45,\"durationMs\":250}",
+    "{\"type\":\"set_pose\",\"pan\":90,\"tilt\":90}",
+    "{\"type\":\"set_led_color\",\"r\":255,\"g\":128,\"b\":0}",
+    "{\"type\":\"set_led_brightness\",\"brightness\":200}",
+    "{\"type\":\"set_led_effect\",\"effect\":\"gradient\",\"zones\":[[0,3,[255,0,0],[0,0,255]],"
+    "[4,6,[0,255,0],[255,255,255]]]}",
+    "{\"type\":\"set_led_effect\",\"effect\":\"fade\",\"color\":[10,20,30],\"durationMs\":1500}",
+    "{ \"type\" : \"ack\", \"action\" : \"heartbeat\", \"seq\" : 4711, \"resync\" : true }",
+    "{\"type\":\"ack\",\"action\":\"register\",\"heartbeatFormat\":\"bin1\"}",
+    "{\"type\":\"clear_leds\"}",
+    "{\"type\":\"error\",\"error\":\"device \\\"x\\\" not found\"}",
+    "{\"type\":\"batch\",\"ops\":[{\"type\":\"set_led_color\",\"r\":255,\"g\":180,\"b\":90},"
+    "{\"type\":\"set_led_brightness\",\"brightness\":160},{\"type\":\"set_pose\",\"pan\":70,\"tilt\":100}]}",
+    "{\"type\":\"set_pose\",\"pan\":88,\"tilt\":91,\"seq\":1024}",
+};
+#define CORPUS_SIZE (sizeof(s_corpus) / sizeof(s_corpus[0]))
+
+static int s_failures;
+
+#define CHECK(cond)                                                     \
+    do {                                                                \
+        if (!(cond)) {                                                  \
+            printf("check failed at line %d: %s\n", __LINE__, #cond);   \
+            s_failures++;                                               \
+        }                                                               \
+    } while (0)
+
+static ws_command_status_t parse_text(const char *text, ws_command_t *command)
+{
+    return ws_command_parse(text, strlen(text), command);
+}
+
+static void check_reference(void)
+{
+    ws_command_t c;
+
+    CHECK(parse_text(s_corpus[0], &c) == WS_COMMAND_OK && c.type == WS_COMMAND_SET_SERVO &&
+          c.servo.id == 1 && c.servo.angle_cdeg == 9235 && c.servo.duration_ms == 0);
+    CHECK(parse_text(s_corpus[1], &c) == WS_COMMAND_OK && c.servo.angle_cdeg == 3700 && c.servo.duration_ms == 400);
+    CHECK(parse_text(s_corpus[2], &c) == WS_COMMAND_OK && c.type == WS_COMMAND_SET_POSE &&
+          c.pose.pan == 120 && c.pose.tilt == 45 && c.pose.duration_ms == 250);
+    CHECK(parse_text(s_corpus[4], &c) == WS_COMMAND_OK && c.led_color.r == 255 && c.led_color.g == 128);
+    CHECK(parse_text(s_corpus[6], &c) == WS_COMMAND_OK && c.led_effect.type == LED_EFFECT_GRADIENT &&
+          c.led_effect.zone_count == 2 && c.led_effect.zones[1].first == 4 && c.led_effect.zones[1].to.b == 255);
+    CHECK(parse_text(s_corpus[7], &c) == WS_COMMAND_OK && c.led_effect.from_current &&
+          c.led_effect.color.b == 30 && c.led_effect.duration_ms == 1500 && c.led_effect.period_ms == 2000);
+    CHECK(parse_text(s_corpus[8], &c) == WS_COMMAND_OK && c.type == WS_COMMAND_ACK && c.ack.has_seq &&
+          c.ack.seq == 4711 && c.ack.resync && ws_span_equals(c.ack.action, "heartbeat"));
+    CHECK(parse_text(s_corpus[9], &c) == WS_COMMAND_OK && ws_span_equals(c.ack.heartbeat_format, "bin1"));
+    CHECK(parse_text(s_corpus[11], &c) == WS_COMMAND_OK && ws_span_equals(c.error, "device \\\"x\\\" not found"));
+
+    CHECK(parse_text(s_corpus[12], &c) == WS_COMMAND_OK && c.type == WS_COMMAND_BATCH && c.batch.count == 3);
+    ws_command_t op;
+    CHECK(ws_command_parse_op(&c.batch.ops[1], &op) == WS_COMMAND_OK && op.type == WS_COMMAND_SET_LED_BRIGHTNESS &&
+          op.led_brightness == 160);
+    CHECK(ws_command_parse_op(&c.batch.ops[2], &op) == WS_COMMAND_OK && op.pose.pan == 70 && op.pose.tilt == 100);
+
+    // Пакет отклоняется целиком: неверная операция, вложенный пакет, ack, пустой или длинный список
+    CHECK(parse_text("{\"type\":\"batch\",\"ops\":[{\"type\":\"clear_leds\"},{\"type\":\"set_servo\",\"id\":5,"
+                     "\"angle\":1}]}", &c) == WS_COMMAND_INVALID);
+    CHECK(parse_text("{\"type\":\"batch\",\"ops\":[{\"type\":\"batch\",\"ops\":[{\"type\":\"clear_leds\"}]}]}", &c) ==
+          WS_COMMAND_INVALID);
+    CHECK(parse_text("{\"type\":\"batch\",\"ops\":[{\"type\":\"ack\"}]}", &c) == WS_COMMAND_INVALID);
+    CHECK(parse_text("{\"type\":\"batch\",\"ops\":[]}", &c) == WS_COMMAND_INVALID);
+    CHECK(parse_text("{\"type\":\"batch\",\"ops\":[{\"type\":\"clear_leds\"},{\"type\":\"clear_leds\"},"
+                     "{\"type\":\"clear_leds\"},{\"type\":\"clear_leds\"},{\"type\":\"clear_leds\"},"
+                     "{\"type\":\"clear_leds\"},{\"type\":\"clear_leds\"},{\"type\":\"clear_leds\"},"
+                     "{\"type\":\"clear_leds\"}]}", &c) == WS_COMMAND_INVALID);
+    CHECK(parse_text("{\"type\":\"batcX\"}", &c) == WS_COMMAND_UNKNOWN_TYPE);
+
+    // Номер команды известен и при отказе, чтобы устройство ответило command_ack
+    CHECK(parse_text("{\"type\":\"set_pose\",\"pan\":1,\"tilt\":2,\"seq\":42}", &c) == WS_COMMAND_OK && c.has_seq &&
+          c.seq == 42);
+    CHECK(parse_text("{\"seq\":7,\"type\":\"set_pose\",\"pan\":1}", &c) == WS_COMMAND_INVALID && c.has_seq && c.seq == 7);
+    CHECK(parse_text("{\"type\":\"reboot\",\"seq\":4294967295}", &c) == WS_COMMAND_UNKNOWN_TYPE && c.has_seq &&
+          c.seq == UINT32_MAX);
+    CHECK(parse_text("{\"type\":\"clear_leds\",\"seq\":1.5}", &c) == WS_COMMAND_OK && !c.has_seq);
+    CHECK(parse_text(s_corpus[0], &c) == WS_COMMAND_OK && !c.has_seq);
+
+    CHECK(parse_text("{\"type\":\"set_servo\",\"id\":3,\"angle\":10}", &c) == WS_COMMAND_INVALID);
+    CHECK(parse_text("{\"type\":\"set_servo\",\"id\":1,\"angle\":180.01}", &c) == WS_COMMAND_INVALID);
+    CHECK(parse_text("{\"type\":\"set_servo\",\"id\":1,\"angle\":180.004}", &c) == WS_COMMAND_INVALID);
+    CHECK(parse_text("{\"type\":\"set_servo\",\"id\":1,\"angle\":1e300}", &c) == WS_COMMAND_INVALID);
+    CHECK(parse_text("{\"type\":\"set_servo\",\"id\":1,\"angle\":-1e300}", &c) == WS_COMMAND_INVALID);
+    CHECK(parse_text("{\"type\":\"set_servo\",\"id\":1,\"angle\":-0.001}", &c) == WS_COMMAND_INVALID);
+    CHECK(parse_text("{\"type\":\"set_servo\",\"id\":1,\"angle\":1.8e2}", &c) == WS_COMMAND_OK &&
+          c.servo.angle_cdeg == 18000);
+    CHECK(parse_text("{\"type\":\"set_led_color\",\"r\":256,\"g\":0,\"b\":0}", &c) == WS_COMMAND_INVALID);
+    // Поля эффекта вне диапазона отклоняются, а не заворачиваются в uint8_t/uint16_t
+    CHECK(parse_text("{\"type\":\"set_led_effect\",\"effect\":\"chase\",\"width\":256}", &c) == WS_COMMAND_INVALID);
+    CHECK(parse_text("{\"type\":\"set_led_effect\",\"effect\":\"chase\",\"width\":0}", &c) == WS_COMMAND_INVALID);
+    CHECK(parse_text("{\"type\":\"set_led_effect\",\"effect\":\"breathe\",\"minLevel\":-1}", &c) == WS_COMMAND_INVALID);
+    CHECK(parse_text("{\"type\":\"set_led_effect\",\"effect\":\"color_temp\",\"kelvinFrom\":70000}", &c) ==
+          WS_COMMAND_INVALID);
+    CHECK(parse_text("{\"type\":\"set_led_effect\",\"effect\":\"color_temp\",\"kelvinTo\":999}", &c) ==
+          WS_COMMAND_INVALID);
+    CHECK(parse_text("{\"type\":\"set_led_effect\",\"effect\":\"color_temp\",\"kelvinFrom\":1000,"
+                     "\"kelvinTo\":10000,\"minLevel\":255,\"width\":255}", &c) == WS_COMMAND_OK &&
+          c.led_effect.kelvin_from == 1000 && c.led_effect.kelvin_to == 10000 && c.led_effect.min_level == 255 &&
+          c.led_effect.width == 255);
+    CHECK(parse_text("{\"type\":\"set_led_effect\",\"effect\":\"gradient\",\"zones\":[[0,1,[1,1,1],[2,2,2]],"
+                     "[2,3,[1,1,1],[2,2,2]],[4,5,[1,1,1],[2,2,2]],[6,7,[1,1,1],[2,2,2]]]}", &c) == WS_COMMAND_OK &&
+          c.led_effect.zone_count == LED_EFFECT_MAX_ZONES);
+    CHECK(parse_text("{\"type\":\"set_led_effect\",\"effect\":\"gradient\",\"zones\":[[0,1,[1,1,1],[2,2,2]],"
+                     "[2,3,[1,1,1],[2,2,2]],[4,5,[1,1,1],[2,2,2]],[6,7,[1,1,1],[2,2,2]],[8,9,[1,1,1],[2,2,2]]]}",
+                     &c) == WS_COMMAND_INVALID);
+    CHECK(parse_text("{\"type\":\"set_pose\",\"pan\":10}", &c) == WS_COMMAND_INVALID);
+    CHECK(parse_text("{\"type\":\"reboot\"}", &c) == WS_COMMAND_UNKNOWN_TYPE);
+    CHECK(parse_text("{\"type\":\"set_posX\"}", &c) == WS_COMMAND_UNKNOWN_TYPE);
+    CHECK(parse_text("{\"id\":1}", &c) == WS_COMMAND_NO_TYPE);
+    CHECK(parse_text("{\"type\":\"clear_leds\"", &c) == WS_COMMAND_MALFORMED);
+    CHECK(parse_text("{\"type\":\"clear_leds\"} x", &c) == WS_COMMAND_MALFORMED);
+    CHECK(parse_text("[[[[[[[[[[[[1]]]]]]]]]]]]", &c) == WS_COMMAND_MALFORMED);
+    CHECK(parse_text("{\"a\":[[[[[[[[[[[[1]]]]]]]]]]]],\"type\":\"clear_leds\"}", &c) == WS_COMMAND_MALFORMED);
+}
+
+/* Принятая команда обязана быть в диапазонах, которые обещает ws_command.h */
+static void check_accepted(const ws_command_t *c)
+{
+    switch (c->type) {
+    case WS_COMMAND_BATCH:
+        CHECK(c->batch.count > 0 && c->batch.count <= WS_COMMAND_BATCH_MAX_OPS);
+        for (int i = 0; i < c->batch.count; i++) {
+            ws_command_t op;
+            CHECK(ws_command_parse_op(&c->batch.ops[i], &op) == WS_COMMAND_OK && op.type != WS_COMMAND_BATCH);
+            check_accepted(&op);
+        }
+        break;
+    case WS_COMMAND_SET_SERVO:
+        CHECK(c->servo.id >= 1 && c->servo.id <= 2 && c->servo.angle_cdeg >= 0 && c->servo.angle_cdeg <= 18000);
+        break;
+    case WS_COMMAND_SET_POSE:
+        CHECK(c->pose.pan >= 0 && c->pose.pan <= 180 && c->pose.tilt >= 0 && c->pose.tilt <= 180);
+        break;
+    case WS_COMMAND_SET_LED_EFFECT:
+        CHECK(c->led_effect.zone_count <= LED_EFFECT_MAX_ZONES);
+        for (int i = 0; i < c->led_effect.zone_count; i++) {
+            CHECK(c->led_effect.zones[i].first <= c->led_effect.zones[i].last);
+        }
+        break;
+    default:
+        CHECK(c->type < WS_COMMAND_COUNT);
+        break;
+    }
+}
+
+static uint32_t s_rng;
+
+static uint32_t next_random(void)
+{
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 17;
+    s_rng ^= s_rng << 5;
+    return s_rng;
+}
+
+static size_t mutate(const char *source, char *out)
+{
+    static const char structural[] = "{}[]\",:-.0123456789eE \\tfn";
+    size_t len = strlen(source);
+    memcpy(out, source, len);
+
+    int mutations = 1 + (int)(next_random() % 4);
+    for (int m = 0; m < mutations; m++) {
+        size_t pos = len ? next_random() % len : 0;
+        switch (next_random() % 5) {
+        case 0: // замена на структурный символ
+            if (len) {
+                out[pos] = structural[next_random() % (sizeof(structural) - 1)];
+            }
+            break;
+        case 1: // случайный байт
+            if (len) {
+                out[pos] = (char)next_random();
+            }
+            break;
+        case 2: // вставка
+            if (len < BENCH_FUZZ_MAX_LEN) {
+                memmove(out + pos + 1, out + pos, len - pos);
+                out[pos] = structural[next_random() % (sizeof(structural) - 1)];
+                len++;
+            }
+            break;
+        case 3: // удаление
+            if (len) {
+                memmove(out + pos, out + pos + 1, len - pos - 1);
+                len--;
+            }
+            break;
+        default: // обрезка
+            len = pos;
+            break;
+        }
+    }
+    return len;
+}
+
+static void fuzz(int cases)
+{
+    static char scratch[BENCH_FUZZ_MAX_LEN + 8];
+    int accepted = 0;
+    int statuses[WS_COMMAND_INVALID + 1] = {0};
+
+    for (int i = 0; i < cases; i++) {
+        size_t len;
+        if (i % 8 == 7) {
+            len = next_random() % 64;
+            for (size_t k = 0; k < len; k++) {
+                scratch[k] = (char)next_random();
+            }
+        } else {
+            len = mutate(s_corpus[next_random() % CORPUS_SIZE], scratch);
+        }
+
+        // Буфер ровно по длине сообщения, без завершающего нуля
+        char *message = malloc(len ? len : 1);
+        memcpy(message, scratch, len);
+        ws_command_t command;
+        ws_command_status_t status = ws_command_parse(message, len, &command);
+        statuses[status]++;
+        if (status == WS_COMMAND_OK) {
+            accepted++;
+            check_accepted(&command);
+        }
+        free(message);
+    }
+
+    printf("fuzz: %d cases, accepted %d, malformed %d, no type %d, unknown %d, invalid %d\n", cases, accepted,
+           statuses[WS_COMMAND_MALFORMED], statuses[WS_COMMAND_NO_TYPE], statuses[WS_COMMAND_UNKNOWN_TYPE],
+           statuses[WS_COMMAND_INVALID]);
+}
+
+static size_t s_lengths[CORPUS_SIZE];
+
+static int parse_corpus(void)
+{
+    int ok = 0;
+    for (size_t i = 0; i < CORPUS_SIZE; i++) {
+        ws_command_t command;
+        ok += ws_command_parse(s_corpus[i], s_lengths[i], &command) == WS_COMMAND_OK;
+        bench_consume(&command);
+    }
+    return ok;
+}
+
+#ifdef BENCH_HAVE_CJSON
+static size_t s_allocations;
+
+static void *counting_malloc(size_t size)
+{
+    s_allocations++;
+    return malloc(size);
+}
+
+/* Прежний handle_websocket_message до выполнения команды */
+static int legacy_corpus(void)
+{
+    static const char *const types[] = { "set_servo", "set_pose", "set_led_color", "set_led_effect",
+                                         "set_led_brightness", "clear_leds", "ack", "error" };
+    int ok = 0;
+    for (size_t i = 0; i < CORPUS_SIZE; i++) {
+        char *copy = counting_malloc(s_lengths[i] + 1);
+        memcpy(copy, s_corpus[i], s_lengths[i]);
+        copy[s_lengths[i]] = '\0';
+        cJSON *json = cJSON_Parse(copy);
+        free(copy);
+        cJSON *type = cJSON_GetObjectItem(json, "type");
+        if (cJSON_IsString(type)) {
+            for (size_t t = 0; t < sizeof(types) / sizeof(types[0]); t++) {
+                if (strcmp(type->valuestring, types[t]) == 0) {
+                    ok++;
+                    break;
+                }
+            }
+        }
+        cJSON_Delete(json);
+    }
+    return ok;
+}
+#endif
+
+static void report(const char *name, int (*run)(void), int iterations)
+{
+    int ok = run();
+    uint64_t start_cycles = bench_cycles();
+    uint64_t start_ns = bench_now_ns();
+    for (int i = 0; i < iterations; i++) {
+        run();
+    }
+    uint64_t cycles = bench_cycles() - start_cycles;
+    double ns = (double)(bench_now_ns() - start_ns);
+    double commands = (double)iterations * CORPUS_SIZE;
+
+    printf("%-16s %2d/%zu ok %8.3f us/command %10.0f commands/s", name, ok, CORPUS_SIZE,
+           ns / commands / 1000.0, commands / (ns / 1e9));
+    if (BENCH_HAVE_CYCLES) {
+        printf(" %7.0f cycles", (double)cycles / commands);
+    }
+    printf("\n");
+}
+
+int main(int argc, char **argv)
+{
+    int iterations = argc > 1 ? atoi(argv[1]) : BENCH_DEFAULT_ITERATIONS;
+    if (iterations <= 0) {
+        iterations = BENCH_DEFAULT_ITERATIONS;
+    }
+    int cases = argc > 2 ? atoi(argv[2]) : BENCH_DEFAULT_FUZZ_CASES;
+    if (cases < 0) {
+        cases = BENCH_DEFAULT_FUZZ_CASES;
+    }
+    s_rng = argc > 3 ? (uint32_t)strtoul(argv[3], NULL, 0) : 0x5eed1234u;
+    if (s_rng == 0) {
+        s_rng = 1;
+    }
+
+    for (size_t i = 0; i < CORPUS_SIZE; i++) {
+        s_lengths[i] = strlen(s_corpus[i]);
+    }
+
+    check_reference();
+    fuzz(cases);
+    if (s_failures > 0) {
+        printf("%d checks failed\n", s_failures);
+        return 1;
+    }
+
+    report("ws_command", parse_corpus, iterations);
+
+#ifdef BENCH_HAVE_CJSON
+    cJSON_Hooks hooks = {.malloc_fn = counting_malloc, .free_fn = free};
+    cJSON_InitHooks(&hooks);
+    s_allocations = 0;
+    legacy_corpus();
+    printf("cJSON allocations per command: %.1f\n", (double)s_allocations / CORPUS_SIZE);
+    report("malloc+cJSON", legacy_corpus, iterations);
+#else
+    printf("cJSON sources not found, legacy path skipped (configure with -DCJSON_DIR=...)\n");
+#endif
+
+    return 0;
+}
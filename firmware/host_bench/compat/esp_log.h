@@ -0,0 +1,7 @@
+/* Минимальная замена esp_log.h: журнал на хосте не нужен */
+#pragma once
+
+#define ESP_LOGE(tag, ...) do { (void)(tag); } while (0)
+#define ESP_LOGW(tag, ...) do { (void)(tag); } while (0)
+#define ESP_LOGI(tag, ...) do { (void)(tag); } while (0)
+#define ESP_LOGD(tag, ...) do { (void)(tag); } while (0)
@@ -0,0 +1,6 @@
+/* Минимальная замена esp_timer.h; часы определяет сам бенчмарк */
+#pragma once
+
+#include <stdint.h>
+
+int64_t esp_timer_get_time(void);
@@ -0,0 +1,24 @@
+/* Минимальная замена FreeRTOS.h для сборки компонентов на хосте.
+ * Одна задача, поэтому критическая секция только считает входы: проверки
+ * видят, что блокировка взята и отпущена */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+
+typedef struct {
+    int depth;
+    uint32_t entries;
+} portMUX_TYPE;
+
+#define pdPASS 1
+#define portTICK_PERIOD_MS 1
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+
+#define portMUX_INITIALIZE(mux) ((mux)->depth = 0, (mux)->entries = 0)
+#define portENTER_CRITICAL(mux) ((mux)->depth++, (mux)->entries++)
+#define portEXIT_CRITICAL(mux) ((mux)->depth--)
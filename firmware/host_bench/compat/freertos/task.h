@@ -0,0 +1,11 @@
+/* Минимальная замена freertos/task.h; функции определяет сам бенчмарк */
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+typedef void *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *);
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack_size, void *arg,
+                       UBaseType_t priority, TaskHandle_t *out_handle);
+void vTaskDelay(TickType_t ticks);
@@ -20,6 +20,7 @@
 #include "uwb_positioning.h"
 #include "web_server.h"
 #include "websocket_client.h"
+#include "scheduler.h"
 #include "driver/gpio.h"
 #include "driver/uart.h"
 
@@ -128,29 +129,39 @@ static void reset_button_task(void *pvParameters)
     }
 }
 
-/**
- * @brief Задача для периодических операций (сервоприводы, heartbeat)
+/*
+ * Периодические операции выполняют два планировщика. control — сервоприводы,
+ * UWB и LED: короткие неблокирующие задания с периодом 10 мс. network —
+ * heartbeat WebSocket: отправка может ждать сеть до секунды на попытку,
+ * поэтому живёт в своей задаче с приоритетом ниже и не задерживает
+ * сервоприводы.
  */
-static void periodic_task(void *pvParameters)
+#define CONTROL_PERIOD_MS 10
+#define SERVO_JOB_DEADLINE_MS 2     // Шаг плавного движения должен уйти в начале периода
+
+static void servo_job(void *arg)
 {
-    TickType_t xLastWakeTime = xTaskGetTickCount();
-    const TickType_t xFrequency = pdMS_TO_TICKS(10); // 10ms period
-    
-    ESP_LOGI(TAG, "Periodic task started");
-    
-    while (1) {
-        // Обновление сервоприводов для плавного движения
-        servo_controller_task();
+    // Обновление сервоприводов для плавного движения
+    servo_controller_task();
+}
 
-        // Диагностика/обновление UWB-модуля
-        uwb_positioning_task();
-        
-        // Отправка heartbeat сообщений через WebSocket
-        if (g_websocket_started && websocket_client_is_connected()) {
-            websocket_client_heartbeat_task();
-        }
-        
-        vTaskDelayUntil(&xLastWakeTime, xFrequency);
+static void led_job(void *arg)
+{
+    // Кадр LED, отложенный пока провод был занят предыдущим
+    led_controller_task();
+}
+
+static void uwb_job(void *arg)
+{
+    // Опрос UWB-модуля (если не запущена отдельная задача чтения UART)
+    uwb_positioning_task();
+}
+
+static void heartbeat_job(void *arg)
+{
+    // Отправка heartbeat сообщений через WebSocket
+    if (g_websocket_started && websocket_client_is_connected()) {
+        websocket_client_heartbeat_task();
     }
 }
 
@@ -317,14 +328,29 @@ static esp_err_t init_system(void)
     
     // Инициализация LED контроллера
     ESP_LOGI(TAG, "Initializing LED controller...");
-    led_controller_config_t led_config = {
-        .gpio_pin = 33,    // GPIO пин для DATA сигнала WS2812
-        .led_count = 7     // Количество светодиодов в ленте
+    // Каждая лента на своём канале RMT; кадры лент уходят одновременно
+    static const led_controller_config_t led_strips[] = {
+#ifdef CONFIG_SMARTLIGHT_LED_STRIP1_GPIO
+        { .gpio_pin = CONFIG_SMARTLIGHT_LED_STRIP1_GPIO, .led_count = CONFIG_SMARTLIGHT_LED_STRIP1_LEDS },
+#else
+        { .gpio_pin = 33, .led_count = 7 },  // GPIO пин для DATA сигнала WS2812
+#endif
+#ifdef CONFIG_SMARTLIGHT_LED_STRIP2_GPIO
+        { .gpio_pin = CONFIG_SMARTLIGHT_LED_STRIP2_GPIO, .led_count = CONFIG_SMARTLIGHT_LED_STRIP2_LEDS },
+#endif
+#ifdef CONFIG_SMARTLIGHT_LED_STRIP3_GPIO
+        { .gpio_pin = CONFIG_SMARTLIGHT_LED_STRIP3_GPIO, .led_count = CONFIG_SMARTLIGHT_LED_STRIP3_LEDS },
+#endif
+#ifdef CONFIG_SMARTLIGHT_LED_STRIP4_GPIO
+        { .gpio_pin = CONFIG_SMARTLIGHT_LED_STRIP4_GPIO, .led_count = CONFIG_SMARTLIGHT_LED_STRIP4_LEDS },
+#endif
     };
-    ret = led_controller_init(&led_config);
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to initialize LED controller: %s", esp_err_to_name(ret));
-        return ret;
+    for (size_t i = 0; i < sizeof(led_strips) / sizeof(led_strips[0]); i++) {
+        ret = led_controller_add_strip(&led_strips[i], NULL);
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to initialize LED strip %d: %s", (int)i + 1, esp_err_to_name(ret));
+            return ret;
+        }
     }
 
     // Инициализация UWB-модуля расположения
@@ -334,6 +360,11 @@ static esp_err_t init_system(void)
         .tx_pin = 18,
         .rx_pin = 19,
         .baud_rate = 115200,
+#ifdef CONFIG_SMARTLIGHT_UWB_RX_TASK
+        .rx_task_enabled = true,
+        .rx_task_core = CONFIG_SMARTLIGHT_UWB_RX_TASK_CORE,
+        .rx_task_priority = 6,  // Выше планировщика control, чтобы не переполнять FIFO UART
+#endif
     };
     configure_uwb_for_device(&uwb_config);
     ret = uwb_positioning_init(&uwb_config);
@@ -359,15 +390,38 @@ static esp_err_t init_system(void)
  */
 static void create_tasks(void)
 {
-    // Создаем задачу для периодических операций
-    xTaskCreate(
-        periodic_task,
-        "periodic_task",
-        4096,
-        NULL,
-        5,  // Высокий приоритет для точного управления сервоприводами
-        NULL
-    );
+    // Планировщик управления: высокий приоритет для точного управления сервоприводами
+    scheduler_config_t control_config = {
+        .name = "control",
+        .stack_size = 4096,
+        .task_priority = 5,
+    };
+    scheduler_handle_t control;
+    ESP_ERROR_CHECK(scheduler_create(&control_config, &control));
+    scheduler_job_config_t control_jobs[] = {
+        { .name = "servo", .fn = servo_job, .period_ms = CONTROL_PERIOD_MS,
+          .deadline_ms = SERVO_JOB_DEADLINE_MS, .priority = 3 },
+        { .name = "uwb", .fn = uwb_job, .period_ms = CONTROL_PERIOD_MS, .priority = 2 },
+        { .name = "led", .fn = led_job, .period_ms = CONTROL_PERIOD_MS, .priority = 1 },
+    };
+    for (size_t i = 0; i < sizeof(control_jobs) / sizeof(control_jobs[0]); i++) {
+        ESP_ERROR_CHECK(scheduler_add_job(control, &control_jobs[i]));
+    }
+    ESP_ERROR_CHECK(scheduler_start(control));
+
+    // Сетевой планировщик: ниже control и выше монитора соединений
+    scheduler_config_t network_config = {
+        .name = "network",
+        .stack_size = 4096,
+        .task_priority = 4,
+    };
+    scheduler_handle_t network;
+    ESP_ERROR_CHECK(scheduler_create(&network_config, &network));
+    scheduler_job_config_t heartbeat = {
+        .name = "heartbeat", .fn = heartbeat_job, .period_ms = CONTROL_PERIOD_MS, .priority = 1,
+    };
+    ESP_ERROR_CHECK(scheduler_add_job(network, &heartbeat));
+    ESP_ERROR_CHECK(scheduler_start(network));
     
     // Создаем задачу для мониторинга соединений
     xTaskCreate(